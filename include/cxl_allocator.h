@@ -0,0 +1,75 @@
+#ifndef CXL_ALLOCATOR_H
+#define CXL_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "cxl_api.h"
+
+// Sub-allocator for a mapped CXL region.
+//
+// Small requests are served from size-class slabs, larger ones from a buddy
+// allocator that also supplies the slabs. The allocator only deals in offsets
+// and keeps all of its metadata in host memory, so allocating and freeing never
+// touches the (uncached) device lines. Alignment is relative to the start of
+// the managed range.
+class CXLAllocator {
+public:
+    static constexpr unsigned MIN_ORDER = 12;          // Smallest buddy block (4KB)
+    static constexpr unsigned SLAB_ORDER = 16;         // Slab size for small objects (64KB)
+    static constexpr size_t MIN_CLASS_SIZE = 64;       // Smallest size class (one cache line)
+    static constexpr size_t MAX_CLASS_SIZE = 2048;     // Largest size class served from slabs
+    static constexpr unsigned NUM_CLASSES = 6;         // 64, 128, ..., 2048
+    static constexpr unsigned MAX_ORDER = 48;
+
+    CXLAllocator();
+
+    // Manage the offsets [base, base + size)
+    void init(size_t base, size_t size);
+    void reset();
+
+    bool allocate(size_t size, size_t align, size_t* offset);
+    bool release(size_t offset);
+
+    // Take [offset, offset + length), widened to whole 4KB pages, out of the free
+    // blocks; fails if any of it is already allocated. release(offset) returns it.
+    bool reserve(size_t offset, size_t length);
+
+    void get_stats(cxl_alloc_stats* stats);
+
+private:
+    struct Slab {
+        unsigned size_class;              // Index into the size-class table
+        uint32_t free_slots;              // Slots not handed out
+        uint32_t total_slots;             // Slots in the slab
+        std::vector<uint64_t> bitmap;     // One bit per slot, set = allocated
+    };
+
+    bool buddy_allocate(unsigned order, size_t* rel);
+    void buddy_release(size_t rel, unsigned order);
+    bool slab_allocate(unsigned size_class, size_t* rel);
+    bool slab_release(size_t rel);
+    void add_free_range(size_t rel, size_t size);
+
+    static unsigned order_for(size_t size);
+    static size_t class_size(unsigned size_class) { return MIN_CLASS_SIZE << size_class; }
+
+    size_t base;                                        // First managed offset
+    size_t capacity;                                    // Bytes under management
+    size_t bytes_allocated;                             // Bytes handed out (rounded to class/block)
+    size_t num_allocations;                             // Live allocations
+
+    std::vector<std::set<size_t>> free_blocks;          // Free buddy blocks per order
+    std::unordered_map<size_t, unsigned> block_orders;  // Live buddy allocations -> order
+    std::unordered_map<size_t, Slab> slabs;             // Slabs by start offset
+    std::set<size_t> partial_slabs[NUM_CLASSES];        // Slabs with free slots, per class
+    std::unordered_map<size_t, size_t> reserved;        // Reserved ranges -> length
+
+    std::mutex lock;
+};
+
+#endif // CXL_ALLOCATOR_H
@@ -4,28 +4,728 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "cxl_common.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Initialize CXL memory
+#define CXL_MAX_BW_THREADS 256
+
+// cxl_init_ex flags
+#define CXL_INIT_POPULATE   0x1     // Fault in the whole region before returning
+#define CXL_INIT_HUGE_2M    0x2     // Back the region with 2MB pages
+#define CXL_INIT_HUGE_1G    0x4     // Back the region with 1GB pages (anonymous memory only)
+#define CXL_INIT_FORMAT     0x8     // Start a device region over, dropping its layout and objects
+
+#define CXL_SCRATCH_ALL     ((size_t)-1)    // scratch_size: everything past the region header
+
+// Region setup for cxl_init_ex
+typedef struct {
+    size_t size;        // Bytes to map (rounded up to the huge page size for anonymous memory)
+    int numa_node;      // Bind the region to this node with mbind (-1 = no binding)
+    int flags;          // CXL_INIT_*
+    size_t interleave_granularity;  // Stripe unit over a device set (0 = 4KB, or larger if needed)
+    size_t scratch_size;    // Benchmark extent of a newly formatted device region (0 = half of it)
+} cxl_init_options;
+
+// Parallel bandwidth test configuration
+typedef struct {
+    int num_threads;    // Worker threads (0 = one per CPU in the affinity mask)
+    int pin_threads;    // Pin each worker to its own CPU before the timed loop
+    const int* cpus;    // CPUs to run on instead of the affinity mask (NULL = affinity mask)
+    int num_cpus;
+} cxl_bw_config;
+
+// Parallel bandwidth test result
+typedef struct {
+    double aggregate_gbps;                      // Total bytes over first-start to last-finish
+    int num_threads;                            // Number of workers that ran
+    double thread_gbps[CXL_MAX_BW_THREADS];     // Bandwidth seen by each worker
+    int thread_cpu[CXL_MAX_BW_THREADS];         // CPU each worker was pinned to (-1 = unpinned)
+    int thread_node[CXL_MAX_BW_THREADS];        // NUMA node each worker ran on (-1 = unknown)
+    int memory_node;                            // NUMA node backing the region (-1 = unknown)
+} cxl_bw_result;
+
+// Latency distribution from a histogram latency test, per dependent load
+typedef struct {
+    uint64_t samples;           // Timed samples recorded
+    double min_ns;
+    double mean_ns;
+    double p50_ns;
+    double p90_ns;
+    double p99_ns;
+    double p999_ns;
+    double max_ns;
+} cxl_latency_stats;
+
+// Page size requested for the pointer-chase working set
+typedef enum {
+    CXL_PAGES_DEFAULT = 0,      // Leave the mapping as it is
+    CXL_PAGES_4K,               // Base pages (MADV_NOHUGEPAGE)
+    CXL_PAGES_HUGE              // Transparent huge pages (MADV_HUGEPAGE)
+} cxl_page_mode;
+
+// Pointer-chase latency test configuration
+typedef struct {
+    size_t working_set;         // Bytes spanned by the chase (0 = 8MB)
+    size_t stride;              // Bytes between nodes, a multiple of 8 (0 = 64, one per cache line)
+    int page_mode;              // cxl_page_mode
+} cxl_chase_config;
+
+// One point of a latency-vs-footprint sweep
+typedef struct {
+    size_t working_set;
+    size_t stride;
+    double mean_ns;
+    double p50_ns;
+    double p99_ns;
+} cxl_latency_point;
+
+// Loaded-latency test configuration: a pointer chase on one CPU while other
+// threads keep the region busy, the way Intel MLC's --loaded_latency does
+typedef struct {
+    cxl_chase_config chase;     // Measured chase (working_set 0 = 8MB, stride 0 = 64)
+    int traffic_threads;        // Bandwidth generators (0 = one per remaining CPU)
+    int write_percent;          // Share of traffic blocks written, the rest read (0 = all reads)
+    size_t block_size;          // Bytes per traffic access (0 = 1KB)
+    const uint32_t* delays;     // Injection delays to step through, in pause instructions after
+    int num_delays;             // every block (NULL = MLC's ladder, 0 up to 20000)
+    const int* cpus;            // CPUs to run on, the chase on the first (NULL = affinity mask)
+    int num_cpus;
+} cxl_loaded_latency_config;
+
+// One point of the latency-vs-bandwidth curve
+typedef struct {
+    uint32_t delay;             // Injection delay the traffic ran with
+    int traffic_threads;
+    double traffic_gbps;        // Bandwidth the traffic threads moved while the chase ran
+    cxl_latency_stats latency;  // Chase latency under that load
+} cxl_loaded_latency_point;
+
+// Access pattern for the pattern bandwidth tests
+typedef enum {
+    CXL_PATTERN_SEQUENTIAL = 0, // Whole blocks back to back, wrapping after the last whole block
+    CXL_PATTERN_STRIDED,        // Blocks stride bytes apart, each block once per lap
+    CXL_PATTERN_RANDOM,         // Blocks in pseudo-random order, each block once per lap
+    CXL_PATTERN_GATHER,         // Element-sized reads from random places into one host block
+    CXL_PATTERN_SCATTER,        // One host block written out to random element-sized places
+    CXL_PATTERN_COUNT
+} cxl_pattern;
+
+// Pattern bandwidth test configuration
+typedef struct {
+    int pattern;                // cxl_pattern
+    int is_write;               // Direction for sequential/strided/random; gather reads, scatter writes
+    size_t block_size;          // Bytes per access
+    size_t stride;              // Strided: bytes between access starts, rounded to blocks (0 = 4 blocks)
+    size_t element_size;        // Gather/scatter: bytes per piece (0 = 64)
+    size_t working_set;         // Bytes of the region spanned (0 = all of it)
+    uint64_t seed;              // Start of the random order
+} cxl_pattern_config;
+
+// Pattern bandwidth test result, one per block size in a sweep
+typedef struct {
+    int pattern;
+    int is_write;
+    size_t block_size;
+    uint64_t accesses;          // Blocks moved
+    double seconds;
+    double gbps;
+    double ns_per_access;       // Wall time per block
+} cxl_pattern_result;
+
+// Hardware counters collected around the timed test loops (cxl_perf_enable)
+#define CXL_PERF_CYCLES         0x1
+#define CXL_PERF_INSTRUCTIONS   0x2
+#define CXL_PERF_LLC_MISSES     0x4     // Last-level cache load misses
+#define CXL_PERF_DTLB_MISSES    0x8     // Data TLB load misses
+#define CXL_PERF_CORE_EVENTS    4
+#define CXL_PERF_MAX_UNCORE     8
+#define CXL_PERF_NAME_MAX       64
+
+// Counters from one timed loop
+typedef struct {
+    uint32_t valid;             // CXL_PERF_* bits of the core counts that were collected
+    double seconds;             // Time the counters were enabled
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t llc_misses;
+    uint64_t dtlb_misses;
+    int num_uncore;
+    char uncore_name[CXL_PERF_MAX_UNCORE][CXL_PERF_NAME_MAX];  // "pmu/event/"
+    uint64_t uncore_count[CXL_PERF_MAX_UNCORE];                 // Summed over the PMU's instances
+} cxl_perf_counters;
+
+// How the CPU maps the region (cxl_fpga cache_mode module parameter)
+typedef enum {
+    CXL_CACHE_UNCACHED = CXL_MEM_CACHE_UNCACHED,
+    CXL_CACHE_WRITE_COMBINING = CXL_MEM_CACHE_WRITE_COMBINING,
+    CXL_CACHE_WRITE_BACK = CXL_MEM_CACHE_WRITE_BACK       // Also files and host memory
+} cxl_cache_mode;
+
+// What the region is mapped from
+typedef enum {
+    CXL_BACKEND_HOST = 0,       // Anonymous host memory
+    CXL_BACKEND_FILE = 1,       // Regular file or simulator device
+    CXL_BACKEND_FPGA = 2,       // cxl_fpga driver, with a command ring
+    CXL_BACKEND_DEVDAX = 3,     // Device-DAX (/dev/daxX.Y) from the kernel's CXL drivers
+    CXL_BACKEND_FSDAX = 4       // File on a filesystem mounted with -o dax
+} cxl_backend;
+
+// Copy/fill kernel variants used by the write and fill paths
+typedef enum {
+    CXL_KERNEL_AUTO = 0,        // Widest supported non-temporal kernel
+    CXL_KERNEL_SCALAR,          // libc memcpy/memset
+    CXL_KERNEL_SSE2,
+    CXL_KERNEL_SSE2_NT,
+    CXL_KERNEL_AVX2,
+    CXL_KERNEL_AVX2_NT,
+    CXL_KERNEL_AVX512,
+    CXL_KERNEL_AVX512_NT,
+    CXL_KERNEL_COUNT
+} cxl_kernel;
+
+// Near-memory compute operations, over float arrays a, b and c
+typedef enum {
+    CXL_COMPUTE_SCALE = 0,      // c = s * a
+    CXL_COMPUTE_ADD,            // c = a + b
+    CXL_COMPUTE_TRIAD,          // c = a + s * b
+    CXL_COMPUTE_DOT,            // sum of a * b
+    CXL_COMPUTE_SUM,            // sum of a
+    CXL_COMPUTE_OP_COUNT
+} cxl_compute_op;
+
+// Instruction set for the compute kernels
+typedef enum {
+    CXL_COMPUTE_ISA_AUTO = 0,   // Widest supported
+    CXL_COMPUTE_ISA_SCALAR,
+    CXL_COMPUTE_ISA_AVX2,       // AVX2 with FMA
+    CXL_COMPUTE_ISA_AVX512,
+    CXL_COMPUTE_ISA_COUNT
+} cxl_compute_isa;
+
+// Compute benchmark setup
+typedef struct {
+    int op;                     // cxl_compute_op
+    int isa;                    // cxl_compute_isa
+    size_t elements;            // Floats per array (0 = 4M, 16MB per array)
+    int iterations;             // Passes over the arrays (0 = 10)
+    size_t tile_bytes;          // Bytes per array per cache tile (0 = 16KB)
+} cxl_compute_config;
+
+// Compute benchmark result
+typedef struct {
+    int isa;                    // Instruction set that ran (AUTO resolved)
+    double flops;               // Floating-point operations performed
+    double bytes;               // Bytes read from and written to the region
+    double seconds;
+    double gflops;
+    double gbps;                // Bytes moved per second, in 2^30-byte GB
+    double bytes_per_flop;      // Arithmetic intensity, inverted
+    double checksum;            // Last reduction, or the first output element
+} cxl_compute_result;
+
+// FPGA command and completion, laid out as the driver's ring entries
+typedef struct cxl_ring_sqe cxl_command;
+typedef struct cxl_ring_cqe cxl_completion;
+
+// One range of a vectored transfer
+typedef struct {
+    size_t offset;              // Offset into the mapped region
+    void* buffer;               // Host buffer
+    size_t length;              // Bytes to move
+} cxl_iovec;
+
+// Engine used by cxl_readv/cxl_writev
+typedef enum {
+    CXL_IOV_ENGINE_CPU = 0,     // Copy kernels on the calling thread
+    CXL_IOV_ENGINE_FPGA         // One CMD_MEM_COPY chain through the driver ring; ranges the
+                                // device rejects are copied on the CPU instead
+} cxl_iov_engine;
+
+// How a memory node relates to the CPUs running a NUMA comparison
+typedef enum {
+    CXL_NODE_DRAM_LOCAL = 0,    // Same node as the benchmark CPUs
+    CXL_NODE_DRAM_REMOTE,       // Another node with CPUs
+    CXL_NODE_CPULESS,           // Memory-only node, how the kernel onlines CXL memory
+    CXL_NODE_DEVICE             // The mapped device itself
+} cxl_node_kind;
+
+// NUMA comparison setup
+typedef struct {
+    int cpu_node;               // Node whose CPUs run every test
+    size_t size;                // Bytes mapped per memory node
+    size_t block_size;          // Bandwidth test block size
+    int bw_iterations;          // Blocks copied per bandwidth thread
+    int num_threads;            // Bandwidth threads (0 = every CPU of cpu_node)
+    int latency_iterations;     // Thousands of pointer-chase hops
+    const char* device_path;    // Also measure this device (NULL = NUMA nodes only)
+} cxl_numa_compare_config;
+
+// NUMA comparison result for one memory node
+typedef struct {
+    int memory_node;            // Node measured (-1 for the device if its node is unknown)
+    int kind;                   // cxl_node_kind
+    double read_gbps;
+    double write_gbps;
+    double latency_ns;          // Mean of the pointer chase
+    double latency_p99_ns;
+} cxl_numa_result;
+
+// What ran an FPGA test
+typedef enum {
+    CXL_FPGA_ENGINE_NONE = 0,   // Nothing: no command ring and not a simulation build
+    CXL_FPGA_ENGINE_DEVICE,     // The FPGA, through the driver's command ring
+    CXL_FPGA_ENGINE_CPU         // CPU emulation (simulation builds without a ring)
+} cxl_fpga_engine;
+
+// FPGA test result
+typedef struct {
+    int engine;                 // cxl_fpga_engine
+    uint64_t commands;          // Commands the device completed (0 for CPU emulation)
+    uint64_t failed;            // Commands the device rejected, failed or timed out
+    uint64_t bytes;             // Bytes processed
+    double seconds;             // From first submission to last completion
+    double rate;                // GB/s for copy and fill, GFLOPS for compute
+} cxl_fpga_result;
+
+// Queue flavour for cxl_test_queue
+typedef enum {
+    CXL_QUEUE_SPSC = 0,         // One producer, one consumer
+    CXL_QUEUE_MPMC              // Any number of each
+} cxl_queue_type;
+
+// Queue benchmark setup
+typedef struct {
+    int type;                   // cxl_queue_type
+    uint32_t capacity;          // Slots per queue, a power of two (0 = 1024)
+    uint64_t messages;          // Messages per producer in the throughput run (0 = 1M)
+    int producers;              // Producer threads (MPMC only, 0 = 1)
+    int consumers;              // Consumer threads (MPMC only, 0 = 1)
+    int round_trips;            // Timed ping-pong exchanges (0 = 100000)
+} cxl_queue_config;
+
+// Queue benchmark result
+typedef struct {
+    double msgs_per_sec;        // Aggregate producer-to-consumer throughput
+    cxl_latency_stats rtt;      // Ping-pong round trip between two threads
+} cxl_queue_result;
+
+// Relocatable reference into a device region: the region id in the top 16 bits
+// and the byte offset below, so it means the same thing in every process that
+// maps the device and can be passed between them as a plain integer
+typedef uint64_t cxl_handle_t;
+#define CXL_HANDLE_NULL         ((cxl_handle_t)0)
+#define CXL_HANDLE_OFFSET_BITS  48
+#define CXL_OBJECT_NAME_MAX     47      // Longest object name, excluding the NUL
+
+// Layout of a mapped region
+typedef struct {
+    uint32_t version;           // Header layout (0 = none: host memory or a region too small for one)
+    uint16_t region_id;
+    uint32_t objects;           // Named objects in the table
+    uint32_t max_objects;
+    uint64_t scratch_offset;    // Extent the benchmarks overwrite; the whole region without a header
+    uint64_t scratch_size;
+    int formatted;              // This cxl_init wrote the header (blank, CXL_INIT_FORMAT or upgraded)
+    uint32_t repaired;          // Superblock copies and torn table entries fixed while attaching
+} cxl_region_info;
+
+// Region allocator statistics
+typedef struct {
+    size_t capacity;            // Bytes under management
+    size_t bytes_allocated;     // Bytes handed out, rounded up to size class or block
+    size_t bytes_free;          // Bytes available in free blocks and slab slots
+    size_t largest_free_block;  // Largest contiguous free block
+    size_t num_allocations;     // Live allocations
+    size_t num_slabs;           // Slabs carved out for small objects
+} cxl_alloc_stats;
+
+// Library operations counted by cxl_get_stats
+typedef enum {
+    CXL_STAT_READV = 0,         // cxl_readv
+    CXL_STAT_WRITEV,            // cxl_writev
+    CXL_STAT_ALLOC,             // cxl_alloc; bytes are those requested
+    CXL_STAT_FREE,              // cxl_free
+    CXL_STAT_OP_COUNT
+} cxl_stat_op;
+
+// Counters for one kind of operation
+typedef struct {
+    uint64_t calls;
+    uint64_t errors;            // Calls that failed
+    uint64_t bytes;             // Moved or allocated by the calls that succeeded
+    uint64_t total_ns;          // Time spent in the calls
+    uint64_t max_ns;            // Longest call
+} cxl_op_stats;
+
+// Library counters since cxl_init or cxl_reset_stats. The command counters cover
+// every ring of the region, the library's own transfers included; a command's
+// latency runs from posting it to reaping (or collecting) its completion.
+typedef struct {
+    cxl_op_stats ops[CXL_STAT_OP_COUNT];
+    uint64_t commands_submitted;
+    uint64_t commands_completed;
+    uint64_t commands_failed;           // Reaped with any status but CXL_CMD_STATUS_COMPLETED
+    uint64_t commands_in_flight;        // Submitted and not reaped yet
+    uint64_t command_avg_ns;
+    uint64_t command_max_ns;
+    uint64_t command_bytes[CMD_ACCELERATE + 1];     // Per opcode, over completed commands
+    uint64_t fallback_bytes;            // FPGA-engine readv/writev bytes copied on the CPU instead
+} cxl_stats;
+
+// Where tiered memory lives
+typedef enum {
+    CXL_TIER_DRAM = 0,          // Local DRAM pool
+    CXL_TIER_CXL,               // Extent of the CXL region
+    CXL_TIER_AUTO               // DRAM while it has room, then CXL
+} cxl_tier_placement;
+
+// How the tiering layer tells hot memory from cold
+typedef enum {
+    CXL_TIER_HEAT_AUTO = 0,     // Accessed bits where the kernel exposes them, else faults
+    CXL_TIER_HEAT_IDLE,         // Sampled accessed bits through /sys/kernel/mm/page_idle (root)
+    CXL_TIER_HEAT_FAULT,        // Hinting faults: chunks are protected and the first touch counted
+    CXL_TIER_HEAT_NONE          // No tracking; only cxl_tier_migrate moves memory
+} cxl_tier_heat;
+
+// Tiering layer setup
+typedef struct {
+    size_t dram_bytes;          // Local DRAM tier capacity
+    size_t cxl_bytes;           // CXL tier capacity, carved out of the region
+    size_t granule;             // Migration unit, a power of two of at least a page (0 = 2MB)
+    int dram_node;              // NUMA node for the DRAM pool (-1 = no binding)
+    int heat_source;            // cxl_tier_heat
+    uint32_t interval_ms;       // Background scan period (0 = only on cxl_tier_scan)
+    double migrate_mbps;        // Migration budget in MB/s (0 = unlimited)
+} cxl_tier_config;
+
+// Tiering layer statistics
+typedef struct {
+    size_t granule;             // Migration unit
+    size_t dram_capacity;       // Bytes in each pool
+    size_t cxl_capacity;
+    size_t dram_used;           // Bytes of each pool backing live memory
+    size_t cxl_used;
+    int heat_source;            // cxl_tier_heat actually in use
+    uint64_t scans;             // Heat sampling passes
+    uint64_t promotions;        // Chunks moved CXL -> DRAM
+    uint64_t demotions;         // Chunks moved DRAM -> CXL
+    uint64_t bytes_migrated;
+    uint64_t hint_faults;       // Sampling faults taken (CXL_TIER_HEAT_FAULT, or an untrackable CXL pool)
+} cxl_tier_stats;
+
+// Codec for the compressed object store
+typedef enum {
+    CXL_CODEC_NONE = 0,         // Stored as is
+    CXL_CODEC_LZ4               // LZ4 block format
+} cxl_codec;
+
+// Compressed object store setup
+typedef struct {
+    int codec;                  // cxl_codec for new objects
+    double min_ratio;           // Objects that don't shrink by this factor are stored as is (0 = 1.1)
+} cxl_zstore_config;
+
+// Compressed object store statistics
+typedef struct {
+    uint64_t objects;
+    uint64_t compressed_objects;    // Objects stored compressed
+    uint64_t logical_bytes;         // Sum of object sizes
+    uint64_t stored_bytes;          // Region bytes holding them
+    double capacity_multiplier;     // logical_bytes / stored_bytes (1 when empty)
+    uint64_t puts;
+    uint64_t gets;
+    double compress_gbps;           // Object bytes compressed per second, over every put (GiB/s)
+    double decompress_gbps;         // Object bytes decompressed per second, over gets of compressed objects
+    double get_avg_ns;              // Whole get: region read plus decompression
+    double get_max_ns;
+    double decompress_avg_ns;       // Decompression alone per compressed get: the cost over reading it uncompressed
+} cxl_zstore_stats;
+
+// Initialize CXL memory. device_path may list several devices separated by
+// commas, which are then interleaved into one region (see cxl_get_interleave).
+// Every process mapping a device set has to list it in the same order with the
+// same granularity. A device region keeps a header with its layout and named
+// objects, which later processes attach to as is; the benchmarks only ever
+// write its scratch extent. Fails on a header that is damaged or too new.
+// Device-DAX and filesystem-DAX paths are mapped directly (see cxl_get_backend),
+// with size rounded up to the device's alignment.
 void* cxl_init(const char* device_path, size_t size);
 
+// Initialize with explicit options; a NULL device_path maps anonymous host memory
+void* cxl_init_ex(const char* device_path, const cxl_init_options* options);
+
 // Clean up CXL memory
 void cxl_cleanup(void* handle);
 
+// Page size backing the region as reported by the kernel; device PFN
+// mappings report the base page size even when mapped with huge entries
+size_t cxl_get_page_size(void* handle);
+
+// Simulator latency/bandwidth model in effect; returns 1 if one is applied
+int cxl_get_sim_model(void* handle, double* latency_ns, double* bandwidth_gbps);
+
+// NUMA node backing the region (-1 = unknown)
+int cxl_get_numa_node(void* handle);
+
+// cxl_cache_mode of the region's mapping
+int cxl_get_cache_mode(void* handle);
+
+// cxl_backend the region is mapped from (-1 for a NULL handle)
+int cxl_get_backend(void* handle);
+
+// Cache maintenance for data shared with the device. On a write-back mapping,
+// flush what the CPU wrote before a command reads it and invalidate before
+// reading what a command wrote (and before submitting it, so no dirty line is
+// evicted over the result). Flushes are not ordered until cxl_persist_barrier,
+// so batch a set of ranges under one barrier; invalidation fences on its own.
+// On uncached and write-combining mappings only the barrier does anything. A
+// NULL handle treats addr as ordinary cached memory.
+void cxl_flush_range(void* handle, const void* addr, size_t length);
+void cxl_invalidate_range(void* handle, const void* addr, size_t length);
+void cxl_persist_barrier(void* handle);
+
+// Fill nodes with the online NUMA nodes; returns the count
+int cxl_numa_get_nodes(int* nodes, int max_nodes);
+
+// Fill cpus with the CPUs of a node; returns the count (0 for CPU-less nodes)
+int cxl_numa_get_node_cpus(int node, int* cpus, int max_cpus);
+
+// Measure every memory node (and optionally a device) from one CPU node;
+// returns results written, or -1 if cpu_node has no CPUs
+int cxl_numa_compare(const cxl_numa_compare_config* config, cxl_numa_result* results, int max_results);
+
+// Allocate memory inside the mapped region (align must be a power of two, 0 = 64 bytes)
+void* cxl_alloc(void* handle, size_t size, size_t align);
+
+// Return memory obtained from cxl_alloc
+void cxl_free(void* handle, void* ptr);
+
+// Get region allocator statistics
+void cxl_get_alloc_stats(void* handle, cxl_alloc_stats* stats);
+
+// Get the library's operation and command counters; returns 0, or -1 for a NULL handle or stats
+int cxl_get_stats(void* handle, cxl_stats* stats);
+
+// Zero the counters cxl_get_stats reports
+void cxl_reset_stats(void* handle);
+
+// Devices the region is striped over (1 for a single device); the stripe unit is
+// stored in granularity (0 for a single device) when it is not NULL. Addresses in
+// cxl_submit_commands are region offsets, and a command must stay within one
+// stripe unit (a copy's source too, on the same device)
+int cxl_get_interleave(void* handle, size_t* granularity);
+
+// Id of the region as recorded in its header (0 for anonymous mappings)
+uint16_t cxl_region_id(void* handle);
+
+// Layout of the region as recorded in its header
+void cxl_get_region_info(void* handle, cxl_region_info* info);
+
+// Start of the scratch extent, which holds no objects or allocations (size may be NULL).
+// Without a region header it is the whole region: benchmarks then refuse to run
+// while cxl_alloc allocations are live, and cxl_alloc fails while one runs
+void* cxl_get_scratch(void* handle, size_t* size);
+
+// Start of the whole mapped region, header included (size may be NULL)
+void* cxl_get_region(void* handle, size_t* size);
+
+// Handle for an address inside the region (CXL_HANDLE_NULL if outside it)
+cxl_handle_t cxl_ptr_to_handle(void* handle, const void* ptr);
+
+// Address of a handle in this process (NULL if it belongs to another region)
+void* cxl_handle_to_ptr(void* handle, cxl_handle_t object);
+
+// Allocate size bytes and publish them under name in the region's directory;
+// returns CXL_HANDLE_NULL if the name is taken, too long, or there is no space.
+// Objects are page aligned and never share pages with cxl_alloc memory.
+cxl_handle_t cxl_object_create(void* handle, const char* name, size_t size);
+
+// Look up an object published by any process mapping the device (size may be NULL)
+cxl_handle_t cxl_object_open(void* handle, const char* name, size_t* size);
+
+// Unpublish an object and free its memory; returns 0, or -1 if there is no such object
+int cxl_object_remove(void* handle, const char* name);
+
+// Tiered memory over local DRAM and an extent of the region (which must be a
+// device). Objects keep their address while the chunks under them migrate:
+// hot ones to DRAM, cold ones to CXL, in the background within the budget.
+// Destroy the tier before cleaning up the region. Returns NULL on failure.
+void* cxl_tier_create(void* handle, const cxl_tier_config* config);
+void cxl_tier_destroy(void* tier);
+
+// Allocate size bytes starting out in the given cxl_tier_placement; chunks are
+// shared between small objects, which follow them as they move
+void* cxl_tier_alloc(void* tier, size_t size, int placement);
+
+// Return memory obtained from cxl_tier_alloc
+void cxl_tier_free(void* tier, void* ptr);
+
+// Tier backing the chunk holding ptr, or -1 if ptr is not tiered memory
+int cxl_tier_where(void* tier, const void* ptr);
+
+// Move every chunk under [ptr, ptr + length) to a tier now, outside the budget;
+// returns chunks moved, or -1 if the range is not tiered memory or the tier is full
+int cxl_tier_migrate(void* tier, const void* ptr, size_t length, int target);
+
+// Run one heat sampling and migration pass now; returns chunks moved or -1
+int cxl_tier_scan(void* tier);
+
+void cxl_tier_get_stats(void* tier, cxl_tier_stats* stats);
+
+// Compressed object store in the region, for cold data that is read whole.
+// Objects are compressed on the CPU, written through cxl_writev (so the
+// FPGA engine moves them when selected) and indexed in DRAM by key; a get
+// reads one back and decompresses it. Objects are freed with the store.
+// Returns NULL on failure.
+void* cxl_zstore_create(void* handle, const cxl_zstore_config* config);
+void cxl_zstore_destroy(void* store);
+
+// Store a copy of size bytes; returns its key, or 0 if the region is full
+uint64_t cxl_zstore_put(void* store, const void* data, size_t size);
+
+// Decompress an object into out; returns its size, or -1 if there is no such
+// key or it needs more than capacity bytes
+int64_t cxl_zstore_get(void* store, uint64_t key, void* out, size_t capacity);
+
+// Size of an object, or -1 if there is no such key
+int64_t cxl_zstore_size(void* store, uint64_t key);
+
+// Free an object; returns 0, or -1 if there is no such key
+int cxl_zstore_remove(void* store, uint64_t key);
+
+void cxl_zstore_get_stats(void* store, cxl_zstore_stats* stats);
+
+// Check whether a copy/fill kernel can run on this CPU
+int cxl_kernel_supported(int kernel);
+
+// Get the name of a copy/fill kernel
+const char* cxl_kernel_name(int kernel);
+
+// Select the copy/fill kernel for a handle (returns 0 on success, -1 if unsupported)
+int cxl_set_kernel(void* handle, int kernel);
+
+// Get the copy/fill kernel currently used by a handle
+int cxl_get_kernel(void* handle);
+
+// Time every supported kernel writing block_size blocks and select the fastest
+int cxl_select_fastest_kernel(void* handle, size_t block_size, int iterations);
+
+// Check whether a compute kernel instruction set can run on this CPU
+int cxl_compute_supported(int isa);
+
+// Get the name of a compute kernel instruction set
+const char* cxl_compute_isa_name(int isa);
+
+// Whether every device under the region has a command ring (1) or not (0)
+int cxl_has_command_ring(void* handle);
+
+// Post a batch of FPGA commands with a single doorbell (returns commands accepted, -1 if no ring).
+// On a write-back mapping the caller keeps the command's ranges coherent (cxl_flush_range)
+int cxl_submit_commands(void* handle, const cxl_command* cmds, int count);
+
+// Collect finished commands without a system call (returns completions reaped, -1 if no ring)
+int cxl_reap_completions(void* handle, cxl_completion* out, int max);
+
+// Block until a submitted command finishes (returns 0, or -errno on timeout/error).
+// A timeout_ms of 0 only polls: out->status is CXL_CMD_STATUS_ACTIVE while it runs.
+// The completion is still posted to the ring and must be reaped as usual
+int cxl_wait_command(void* handle, uint32_t id, uint32_t timeout_ms, cxl_completion* out);
+
+// Select the engine for vectored transfers; returns 0 on success, -1 if unavailable
+int cxl_set_iov_engine(void* handle, int engine);
+
+// Copy many host buffers into the region in one call. Ranges are sorted and
+// adjacent ones merged; overlapping ranges are written in submission order.
+// FPGA chains use command ids with the top bit set.
+// Returns bytes written, or -1 (errno EINVAL) if any range is invalid or reaches
+// into the header kept in the first 64KB of a device region. With the
+// FPGA engine -1 (errno ETIMEDOUT or the ring's error) also means a chain never
+// completed; the device may still be using the buffers of that call.
+int64_t cxl_writev(void* handle, const cxl_iovec* iov, int iovcnt);
+
+// Copy many region ranges into host buffers in one call; returns bytes read or -1
+// (as for cxl_writev)
+int64_t cxl_readv(void* handle, const cxl_iovec* iov, int iovcnt);
+
 // Test write bandwidth
 double cxl_test_write(void* handle, void* buffer, size_t block_size, int iterations);
 
 // Test read bandwidth
 double cxl_test_read(void* handle, void* buffer, size_t block_size, int iterations);
 
+// Test write bandwidth with multiple threads (result may be NULL)
+double cxl_test_write_mt(void* handle, void* buffer, size_t block_size, int iterations,
+                         const cxl_bw_config* config, cxl_bw_result* result);
+
+// Test read bandwidth with multiple threads (result may be NULL)
+double cxl_test_read_mt(void* handle, void* buffer, size_t block_size, int iterations,
+                        const cxl_bw_config* config, cxl_bw_result* result);
+
 // Test memory latency
 double cxl_test_latency(void* handle, int iterations);
 
-// Test FPGA operations
+// Test memory latency with TSC-timed samples; returns the mean (stats may be NULL)
+double cxl_test_latency_hist(void* handle, int iterations, cxl_latency_stats* stats);
+
+// Test memory latency over a configured pointer chase (config and stats may be NULL)
+double cxl_test_latency_chase(void* handle, const cxl_chase_config* config, int iterations,
+                              cxl_latency_stats* stats);
+
+// Sweep working sets from min to max (two points per doubling); returns points written or -1
+int cxl_latency_sweep(void* handle, const cxl_chase_config* config, size_t min_working_set,
+                      size_t max_working_set, int iterations, cxl_latency_point* points, int max_points);
+
+// Measure chase latency under background traffic at each injection delay, from
+// the heaviest load down; returns points written or -1
+int cxl_loaded_latency(void* handle, const cxl_loaded_latency_config* config, int iterations,
+                       cxl_loaded_latency_point* points, int max_points);
+
+// Write the last latency histogram as JSON (snprintf semantics)
+size_t cxl_latency_json(void* handle, char* buf, size_t len);
+
+// Move iterations blocks in the configured pattern; returns GB/s (result may be NULL).
+// With stats, every access is timed on its own into the latency histogram.
+double cxl_test_pattern(void* handle, const cxl_pattern_config* config, int iterations,
+                        cxl_pattern_result* result, cxl_latency_stats* stats);
+
+// Run the pattern at block sizes from min to max, doubling, moving about bytes_per_point
+// at each (at least one block); returns points written or -1
+int cxl_pattern_sweep(void* handle, const cxl_pattern_config* config, size_t min_block_size,
+                      size_t max_block_size, size_t bytes_per_point, cxl_pattern_result* points,
+                      int max_points);
+
+// Name of an access pattern ("sequential", "strided", ...)
+const char* cxl_pattern_name(int pattern);
+
+// Collect perf_event_open counters around every timed test loop from now on.
+// uncore_events is a ';'-separated list of "pmu/event/" names, such as
+// "uncore_imc/cas_count_read/" (NULL = memory-controller CAS counts where present).
+// Returns the CXL_PERF_* core bits opened (0 if only uncore events could be), or -1
+int cxl_perf_enable(void* handle, const char* uncore_events);
+
+// Stop collecting counters
+void cxl_perf_disable(void* handle);
+
+// Counters from the most recent timed loop; returns 0, or -1 if none were collected
+int cxl_perf_last(void* handle, cxl_perf_counters* counters);
+
+// Run a compute kernel over arrays in the region; returns GFLOPS (result may be NULL)
+double cxl_test_compute(void* handle, const cxl_compute_config* config, cxl_compute_result* result);
+
+// Benchmark lock-free queues laid out in the region: producer/consumer throughput
+// and ping-pong round-trip time; returns messages per second (result may be NULL)
+double cxl_test_queue(void* handle, const cxl_queue_config* config, cxl_queue_result* result);
+
+// Test FPGA operations (operation is CMD_MEM_COPY, CMD_MEM_FILL or CMD_ACCELERATE);
+// runs on the device through the command ring, or on the CPU in simulation builds
 double cxl_test_fpga(void* handle, int operation, int iterations);
 
+// Same as cxl_test_fpga, also reporting what ran and the command counts (result may be NULL)
+double cxl_test_fpga_ex(void* handle, int operation, int iterations, cxl_fpga_result* result);
+
 #ifdef __cplusplus
 }
 #endif
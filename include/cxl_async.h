@@ -0,0 +1,195 @@
+#ifndef CXL_ASYNC_H
+#define CXL_ASYNC_H
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cxl_api.h"
+#include "cxl_interleave.h"
+
+// Asynchronous FPGA operations over the command ring (C++20).
+//
+// copy, fill and accelerate return at once with a CXLOperation that can be
+// co_awaited from a coroutine, waited on, or turned into a std::shared_future,
+// so one thread keeps many commands in flight while it does other work.
+// Operations are split into commands at stripe units and at the 32-bit length
+// limit, and queued when the ring is full. Completions are reaped by a reactor
+// thread, or by whichever thread calls poll() when there is none, and waiting
+// coroutines resume on that thread.
+//
+// Without a command ring (plain files, host memory, simulation builds) the same
+// operations run on the CPU in the reactor or in poll(), so code written
+// against this API works on every backend.
+//
+// Command ids stay below the top bit the library's own chains use and have
+// distinct low 8 bits while in flight. Completions of commands submitted any
+// other way on the same handle are reaped and dropped, so don't mix this with
+// cxl_submit_commands or the library's FPGA transfers while work is in flight.
+
+struct CXLOperationState;
+struct CXLTaskState;
+class CXLAsync;
+
+// One copy, fill or accelerate request
+class CXLOperation {
+public:
+    CXLOperation() = default;
+
+    bool valid() const { return state != nullptr; }
+    bool done() const;
+
+    // Block until every command of the operation has finished; an error status
+    // is that of the first command that failed
+    cxl_completion wait() const;
+    std::shared_future<cxl_completion> future() const;
+
+    // co_await support
+    bool await_ready() const { return done(); }
+    bool await_suspend(std::coroutine_handle<> waiter) const;
+    cxl_completion await_resume() const;
+
+private:
+    friend class CXLAsync;
+    explicit CXLOperation(std::shared_ptr<CXLOperationState> op) : state(std::move(op)) {}
+
+    std::shared_ptr<CXLOperationState> state;
+};
+
+// Coroutine returning nothing that starts at once. Destroying an unfinished task
+// detaches it: the frame frees itself when the coroutine returns.
+class CXLTask {
+public:
+    struct promise_type {
+        std::shared_ptr<CXLTaskState> state;
+
+        promise_type();
+        CXLTask get_return_object();
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+                bool await_suspend(std::coroutine_handle<promise_type> frame) noexcept {
+                    return CXLTask::finish(frame.promise().state);
+                }
+                void await_resume() noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    CXLTask(CXLTask&& other) noexcept;
+    CXLTask& operator=(CXLTask&& other) noexcept;
+    CXLTask(const CXLTask&) = delete;
+    CXLTask& operator=(const CXLTask&) = delete;
+    ~CXLTask();
+
+    bool done() const;
+
+    // Block until the coroutine returns; needs a reactor to make progress
+    // (use CXLAsync::wait otherwise)
+    void wait() const;
+
+private:
+    explicit CXLTask(std::coroutine_handle<promise_type> frame);
+    void release();
+
+    // Mark the task finished; returns whether the frame stays suspended for its owner
+    static bool finish(const std::shared_ptr<CXLTaskState>& state);
+
+    std::coroutine_handle<promise_type> frame;
+    std::shared_ptr<CXLTaskState> state;
+};
+
+class CXLAsync {
+public:
+    // Operations on a handle from cxl_init. With reactor set a thread reaps
+    // completions; otherwise the caller drives them with poll()
+    explicit CXLAsync(void* handle, bool reactor = true);
+
+    // Waits for every outstanding operation
+    ~CXLAsync();
+
+    CXLAsync(const CXLAsync&) = delete;
+    CXLAsync& operator=(const CXLAsync&) = delete;
+
+    // Addresses are region offsets, as in cxl_submit_commands. A copy on a
+    // striped region needs source and destination on the same device in every
+    // stripe unit; accelerate scales float32 values in place. Invalid requests
+    // come back already finished with CXL_CMD_STATUS_INVALID.
+    CXLOperation copy(uint64_t dst, uint64_t src, size_t length);
+    CXLOperation fill(uint64_t dst, uint8_t value, size_t length);
+    CXLOperation accelerate(uint64_t offset, size_t length, float scale);
+
+    // Reap (or, without a ring, run) what is ready and resume its waiters;
+    // returns operations finished
+    int poll();
+
+    // Wait for every outstanding operation
+    void drain();
+
+    // Wait for a task, polling when there is no reactor
+    void wait(const CXLTask& task);
+
+    // Whether operations go to the device, rather than the CPU
+    bool on_device() const { return use_ring; }
+
+    // Operations started and not yet finished
+    size_t outstanding() const;
+
+private:
+    friend class CXLOperation;
+
+    // A command waiting for a ring slot (or, without a ring, for the CPU)
+    struct Pending {
+        cxl_command cmd;
+        std::shared_ptr<CXLOperationState> op;
+    };
+
+    // A command in the ring, indexed by the low 8 bits of its id
+    struct Slot {
+        uint32_t id;
+        uint32_t generation;
+        std::shared_ptr<CXLOperationState> op;
+    };
+
+    CXLOperation start(uint32_t opcode, uint64_t dst, uint64_t data, size_t length, uint32_t flags);
+    CXLOperation failed(const char* why);
+    void submit_pending();
+    void retire(const std::shared_ptr<CXLOperationState>& op, const cxl_completion& cqe, bool* finished);
+    void finish(const std::shared_ptr<CXLOperationState>& op);
+    void execute(const cxl_command& cmd) const;
+    bool wait_one();
+    void run_reactor();
+
+    void* handle;
+    char* base;                     // Region mapping, for coherence and the CPU path
+    size_t size;
+    CXLInterleave layout;
+    bool use_ring;
+    bool coherence;                 // Write-back mapping: flush and invalidate around commands
+
+    mutable std::mutex lock;
+    std::condition_variable work_ready;     // New work for the reactor, or stopping
+    std::condition_variable idle;           // active dropped to zero
+    std::deque<Pending> pending;
+    std::vector<Slot> slots;
+    std::vector<std::shared_ptr<CXLOperationState>> failures;  // Failed at submission, finished by poll()
+    uint32_t slot_cursor;
+    size_t in_flight;               // Commands in the ring
+    size_t active;                  // Operations started and not finished
+    uint32_t sequence;              // Ids for operations
+    bool stopping;
+    std::thread reactor;
+};
+
+#endif // CXL_ASYNC_H
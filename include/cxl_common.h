@@ -2,6 +2,13 @@
 #define CXL_COMMON_H
 
 // Common definitions for HERMES-CXL
+// Shared between the kernel driver and the userspace library
+
+#ifdef __KERNEL__
+#include <linux/types.h>
+#else
+#include <stdint.h>
+#endif
 
 // CXL command status codes
 #define CXL_CMD_STATUS_ACTIVE     0
@@ -12,5 +19,100 @@
 // CXL Memory commands
 #define CXL_MEM_SEND_COMMAND     0x1001
 #define CXL_MEM_QUERY_CMD        0x1002
+#define CXL_MEM_RING_SETUP       0x1003
+#define CXL_MEM_RING_ENTER       0x1004
+#define CXL_MEM_WAIT_CMD         0x1005
+#define CXL_MEM_GET_CACHE_MODE   0x1006
+
+// CPU mapping of the shared memory, reported by CXL_MEM_GET_CACHE_MODE as a uint32_t
+#define CXL_MEM_CACHE_UNCACHED         0   // Every access goes to the device
+#define CXL_MEM_CACHE_WRITE_COMBINING  1   // Stores are buffered, loads are uncached
+#define CXL_MEM_CACHE_WRITE_BACK       2   // Fully cached; coherence is up to software
+
+// FPGA command opcodes. address is a device offset; data depends on the opcode:
+//   CMD_MEM_COPY    source device offset (a host address with CXL_CMD_FLAG_HOST_VA)
+//   CMD_MEM_FILL    fill byte
+//   CMD_ACCELERATE  float32 scale factor, applied in place to length bytes of floats
+#define CMD_NOP            0x00
+#define CMD_MEM_COPY       0x01
+#define CMD_MEM_FILL       0x02
+#define CMD_ACCELERATE     0x03
+
+// Command flags
+#define CXL_CMD_FLAG_HOST_VA   0x1     // data is a host virtual address in the submitter (CMD_MEM_COPY
+                                       // only; pinned by the driver until the command completes)
+#define CXL_CMD_FLAG_TO_HOST   0x2     // CMD_MEM_COPY runs device (address) -> host (data)
+
+// Command passed to CXL_MEM_SEND_COMMAND
+struct cxl_mem_command {
+    uint32_t id;
+    uint32_t opcode;
+    uint64_t address;
+    uint64_t data;
+    uint32_t length;
+    uint32_t flags;
+};
+
+// Command status returned by CXL_MEM_QUERY_CMD
+struct cxl_mem_query_cmd {
+    uint32_t id;
+    uint32_t status;
+    uint64_t result;
+};
+
+// Blocking wait passed to CXL_MEM_WAIT_CMD
+struct cxl_mem_wait_cmd {
+    uint32_t id;
+    uint32_t timeout_ms;        // Give up with -ETIMEDOUT after this long; 0 polls without
+                                // sleeping and reports CXL_CMD_STATUS_ACTIVE while it runs
+    uint32_t status;
+    uint32_t reserved;
+    uint64_t result;
+};
+
+// Submission/completion ring shared with userspace through mmap.
+// Command ids index the driver's command table modulo CXL_RING_ENTRIES, so
+// at most CXL_RING_ENTRIES commands with distinct low bits can be in flight.
+#define CXL_RING_ENTRIES       256                 // Must be a power of two
+#define CXL_RING_MMAP_OFFSET   (1ULL << 40)        // mmap offset that selects the ring
+
+// Submission queue entry, written by userspace
+struct cxl_ring_sqe {
+    uint32_t id;
+    uint32_t opcode;
+    uint64_t address;
+    uint64_t data;
+    uint32_t length;
+    uint32_t flags;
+};
+
+// Completion queue entry, written by the driver
+struct cxl_ring_cqe {
+    uint32_t id;
+    uint32_t status;
+    uint64_t result;
+};
+
+// Producer/consumer indices, each pair on its own cache line
+struct cxl_ring_index {
+    uint32_t head;              // Consumer position
+    uint32_t tail;              // Producer position
+    uint8_t pad[56];
+};
+
+struct cxl_ring {
+    struct cxl_ring_index sq;   // Userspace produces, driver consumes
+    struct cxl_ring_index cq;   // Driver produces, userspace consumes
+    struct cxl_ring_sqe sqes[CXL_RING_ENTRIES];
+    struct cxl_ring_cqe cqes[CXL_RING_ENTRIES];
+};
+
+// Result of CXL_MEM_RING_SETUP
+struct cxl_ring_setup {
+    uint32_t entries;           // Entries in each queue
+    uint32_t flags;
+    uint64_t mmap_offset;       // Offset to pass to mmap
+    uint64_t mmap_size;         // Length to pass to mmap
+};
 
-#endif // CXL_COMMON_H
\ No newline at end of file
+#endif // CXL_COMMON_H
@@ -0,0 +1,39 @@
+#ifndef CXL_COMPUTE_H
+#define CXL_COMPUTE_H
+
+#include <cstddef>
+
+#include "cxl_api.h"
+
+// Single-precision STREAM-style compute kernels for near-memory compute.
+//
+// As with the copy/fill kernels, each variant carries its own target
+// attribute and is picked at run time. The scalar variants are kept out of
+// the auto-vectorizer so they stay a true baseline. Reductions use several
+// accumulators per lane to hide FMA latency.
+
+struct CXLComputeOps {
+    int isa;                    // cxl_compute_isa value
+    const char* name;
+    void (*scale)(float* dst, const float* src, float s, size_t n);              // dst = s * src
+    void (*add)(float* dst, const float* a, const float* b, size_t n);           // dst = a + b
+    void (*triad)(float* dst, const float* a, const float* b, float s, size_t n); // dst = a + s * b
+    double (*dot)(const float* a, const float* b, size_t n);
+    double (*sum)(const float* a, size_t n);
+};
+
+// Kernels for the given ISA (CXL_COMPUTE_ISA_AUTO picks the widest); nullptr if unsupported
+const CXLComputeOps* cxl_compute_ops(int isa);
+
+bool cxl_compute_isa_supported(int isa);
+
+// Run one operation over n elements in tiles of tile elements, prefetching the
+// next tile while the current one is processed. dst is unused by dot and sum.
+// Returns the reduction for dot/sum, 0 otherwise.
+double cxl_compute_run(const CXLComputeOps* ops, int op, float* dst, const float* a,
+                       const float* b, float s, size_t n, size_t tile);
+
+// Floating-point operations and bytes moved per element of an operation
+void cxl_compute_cost(int op, double* flops, double* bytes);
+
+#endif // CXL_COMPUTE_H
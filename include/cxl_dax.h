@@ -0,0 +1,39 @@
+#ifndef CXL_DAX_H
+#define CXL_DAX_H
+
+#include <cstddef>
+
+// Linux DAX backends for CXL memory the upstream kernel drives itself.
+//
+// A Type 3 device onlined by the cxl and dax drivers shows up as a device-DAX
+// character device (/dev/daxX.Y) or, through a filesystem mounted with -o dax,
+// as files whose pages are the device's. Both are mapped directly, without the
+// cxl_fpga module. A device-DAX mapping must start and end on the alignment
+// the device was created with (2MB or 1GB, read from sysfs); a filesystem-DAX
+// mapping is aligned to 2MB so it can use PMD entries. Both map with MAP_SYNC,
+// so once a CPU flush completes the data is on the media and no msync is needed.
+
+enum {
+    CXL_DAX_NONE = 0,       // Not DAX: map as an ordinary file
+    CXL_DAX_DEVICE,         // Device-DAX character device
+    CXL_DAX_FS              // File on a DAX filesystem
+};
+
+struct CXLDaxInfo {
+    int kind;               // CXL_DAX_*
+    size_t capacity;        // Bytes the device (or file) holds
+    size_t align;           // Mapping alignment the kernel requires or prefers
+    int numa_node;          // Node the memory belongs to (-1 = unknown or not onlined)
+};
+
+// Identify an open descriptor; fills info and returns false for anything not DAX
+bool cxl_dax_probe(int fd, CXLDaxInfo* info);
+
+// size rounded up to what a mapping of the device can take
+size_t cxl_dax_map_size(const CXLDaxInfo& info, size_t size);
+
+// Map size bytes (already rounded) from offset 0, aligned as the device needs;
+// returns MAP_FAILED on failure
+void* cxl_dax_map(int fd, const CXLDaxInfo& info, size_t size);
+
+#endif // CXL_DAX_H
@@ -0,0 +1,72 @@
+#ifndef CXL_HISTOGRAM_H
+#define CXL_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// Log-linear (HDR-style) latency histogram.
+//
+// Values below 2^SUB_BUCKET_BITS are counted exactly; above that every power
+// of two is split into 2^SUB_BUCKET_BITS equal buckets, which bounds the
+// relative error of any reported value to about 3%.
+class CXLHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+
+    CXLHistogram();
+
+    void reset();
+    void record(uint64_t value);
+    void merge(const CXLHistogram& other);
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? min_value : 0; }
+    uint64_t max() const { return max_value; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // Smallest value at or above the given fraction (0.0 - 1.0) of samples
+    uint64_t percentile(double fraction) const;
+
+    // Write the histogram as JSON (snprintf semantics: returns the full length)
+    size_t to_json(char* buf, size_t len, const char* unit) const;
+
+private:
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_low(size_t index);
+    static uint64_t bucket_high(size_t index);
+
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t sum;
+    uint64_t min_value;
+    uint64_t max_value;
+};
+
+// Timestamp counter read that waits for earlier instructions and holds back later ones
+static inline uint64_t cxl_rdtscp() {
+#if defined(__x86_64__)
+    unsigned int aux;
+    uint64_t tsc = __rdtscp(&aux);
+    _mm_lfence();
+    return tsc;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Nanoseconds per cxl_rdtscp tick, calibrated against steady_clock on first use
+double cxl_tsc_ns_per_tick();
+
+// Cost of back-to-back cxl_rdtscp calls in ticks, to subtract from short samples
+uint64_t cxl_tsc_overhead_ticks();
+
+#endif // CXL_HISTOGRAM_H
@@ -0,0 +1,71 @@
+#ifndef CXL_INTERLEAVE_H
+#define CXL_INTERLEAVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Layout of a region striped over several devices.
+//
+// Logical granule i lives on device i % ways at device offset
+// (i / ways) * granule, the same round-robin a CXL host bridge applies with
+// its HDM decoders. Here it is built from page tables instead, one MAP_FIXED
+// mapping per granule, so the granularity is at least a page and the
+// granule count is bounded by vm.max_map_count; finer interleaving has to
+// be configured in the hardware.
+struct CXLInterleave {
+    int ways;           // Devices (1 = not striped)
+    size_t granule;     // Stripe unit in bytes
+
+    CXLInterleave() : ways(1), granule(0) {}
+
+    bool striped() const { return ways > 1; }
+
+    int device_of(uint64_t offset) const {
+        return striped() ? static_cast<int>((offset / granule) % ways) : 0;
+    }
+
+    uint64_t device_offset(uint64_t offset) const {
+        if (!striped()) {
+            return offset;
+        }
+        return (offset / granule / ways) * granule + offset % granule;
+    }
+
+    // Inverse of device_of/device_offset
+    uint64_t logical_offset(int device, uint64_t offset) const {
+        if (!striped()) {
+            return offset;
+        }
+        return ((offset / granule) * ways + device) * granule + offset % granule;
+    }
+
+    // Bytes from offset to the end of its stripe unit, which all sit on one device
+    uint64_t run(uint64_t offset) const {
+        return striped() ? granule - offset % granule : UINT64_MAX;
+    }
+
+    // Bytes of each device a logical region of size bytes uses
+    size_t device_size(size_t size) const {
+        if (!striped()) {
+            return size;
+        }
+        size_t granules = (size + granule - 1) / granule;
+        return (granules + ways - 1) / ways * granule;
+    }
+};
+
+// Split a comma-separated device list ("/dev/cxl/cxl0,/dev/cxl/cxl1")
+std::vector<std::string> cxl_interleave_devices(const char* device_path);
+
+// Stripe unit for size bytes over ways devices: requested if it is valid (a
+// power of two of at least a page, within the mapping limit), or with 0 the
+// smallest such unit from 4KB up. Returns 0 after reporting why none fits.
+size_t cxl_interleave_granule(size_t requested, size_t size, int ways);
+
+// Map size bytes (a multiple of layout.granule) interleaved over fds;
+// returns MAP_FAILED on failure
+void* cxl_interleave_map(const std::vector<int>& fds, const CXLInterleave& layout, size_t size);
+
+#endif // CXL_INTERLEAVE_H
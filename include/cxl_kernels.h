@@ -0,0 +1,48 @@
+#ifndef CXL_KERNELS_H
+#define CXL_KERNELS_H
+
+#include <cstddef>
+
+#include "cxl_api.h"
+
+// Copy/fill kernel family for writes into CXL memory.
+//
+// Every variant is compiled with a per-function target attribute, so the library
+// itself builds for the baseline ISA and picks wider kernels at run time based
+// on what the CPU reports. Non-temporal variants bypass the cache hierarchy and
+// end with an sfence, which is what uncached or write-combining mappings want.
+
+typedef void (*cxl_copy_fn)(void* dst, const void* src, size_t n);
+typedef void (*cxl_fill_fn)(void* dst, int value, size_t n);
+
+struct CXLKernelOps {
+    int id;                 // cxl_kernel value
+    const char* name;       // Human-readable name
+    cxl_copy_fn copy;       // memcpy replacement
+    cxl_fill_fn fill;       // memset replacement
+    bool non_temporal;      // Uses streaming stores
+};
+
+// Kernel for the given id (CXL_KERNEL_AUTO resolves first); nullptr if unsupported here
+const CXLKernelOps* cxl_kernel_ops(int kernel);
+
+// Whether the CPU and build support the given kernel
+bool cxl_kernel_is_supported(int kernel);
+
+// Widest supported kernel of the requested kind
+int cxl_kernel_best(bool non_temporal);
+
+// Cache line maintenance over [addr, addr + n), picked at run time like the
+// kernels above. Write-back leaves the lines cached where clwb exists; invalidate
+// writes dirty lines back and drops them. Neither fences, so a batch of ranges
+// can share one cxl_cache_fence.
+void cxl_cache_writeback(const void* addr, size_t n);
+void cxl_cache_invalidate(const void* addr, size_t n);
+
+// Order the flushes before later stores, or with full before later loads too
+void cxl_cache_fence(bool full);
+
+// Instruction doing the write-back ("clwb", "clflushopt", "clflush", "dc cvac" or "none")
+const char* cxl_cache_flush_name();
+
+#endif // CXL_KERNELS_H
@@ -0,0 +1,27 @@
+#ifndef CXL_LZ4_H
+#define CXL_LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format codec for the compressed object store.
+//
+// Output is a raw LZ4 block (no frame header or checksum), readable by any
+// LZ4 decoder's block API. The compressor is the single-pass greedy hash
+// search of LZ4's fast mode; the decoder checks every length and offset
+// against both buffers, so corrupt input fails instead of overrunning.
+
+#define CXL_LZ4_MAX_INPUT   0x7E000000UL    // Largest block the format allows
+
+// Worst-case compressed size of size input bytes (0 if size is too large)
+size_t cxl_lz4_bound(size_t size);
+
+// Compress size bytes into dst; returns the compressed size, or 0 if it didn't
+// fit in capacity or size exceeds CXL_LZ4_MAX_INPUT
+size_t cxl_lz4_compress(const void* src, size_t size, void* dst, size_t capacity);
+
+// Decompress a block into dst; returns the decompressed size, or -1 if the
+// block is malformed or decompresses past capacity
+int64_t cxl_lz4_decompress(const void* src, size_t size, void* dst, size_t capacity);
+
+#endif // CXL_LZ4_H
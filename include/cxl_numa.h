@@ -0,0 +1,32 @@
+#ifndef CXL_NUMA_H
+#define CXL_NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+// NUMA topology from sysfs and memory policy through the raw mempolicy
+// system calls, so the library does not depend on libnuma.
+//
+// CXL Type 3 memory is onlined by the kernel as a node that has memory but
+// no CPUs; cxl_numa_node_is_cpuless() is how such nodes are told apart from
+// ordinary DRAM nodes.
+
+// Online nodes in ascending order (just node 0 on non-NUMA systems)
+std::vector<int> cxl_numa_online_nodes();
+
+// CPUs belonging to a node, in ascending order
+std::vector<int> cxl_numa_node_cpus(int node);
+
+bool cxl_numa_node_has_memory(int node);
+bool cxl_numa_node_is_cpuless(int node);
+
+// Node a CPU belongs to, or -1 if unknown
+int cxl_numa_cpu_node(int cpu);
+
+// Bind [addr, addr + length) to a single node, moving any pages already present
+bool cxl_numa_bind(void* addr, size_t length, int node);
+
+// Node backing the page at addr (faulting it in if needed), or -1 if unknown
+int cxl_numa_addr_node(const void* addr);
+
+#endif // CXL_NUMA_H
@@ -0,0 +1,57 @@
+#ifndef CXL_PATTERN_H
+#define CXL_PATTERN_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cxl_api.h"
+
+// Offsets visited by the pattern bandwidth tests.
+//
+// The span is divided into whole units (a block, or a gather/scatter
+// element) and every pattern is a permutation of those slots, so a lap
+// touches each unit exactly once and no access ever straddles the end of the
+// span. Strided steps are bumped until coprime with the slot count, and the
+// random order is a full-period LCG over the next power of two with
+// out-of-range values skipped, which needs no per-slot state however large
+// the span is.
+class CXLAccessPattern {
+public:
+    CXLAccessPattern();
+
+    // Set up pattern over span bytes in units of unit bytes; step_units is the
+    // strided distance in units. Fails if the span holds no whole unit.
+    bool init(int pattern, size_t span, size_t unit, size_t step_units, uint64_t seed);
+
+    size_t slots() const { return count; }
+
+    // Byte offset of the next unit
+    size_t next() {
+        if (random) {
+            do {
+                state = (state * LCG_MULTIPLIER + LCG_INCREMENT) & mask;
+            } while (state >= count);
+            return static_cast<size_t>(state) * unit;
+        }
+        size_t offset = position * unit;
+        position += step;
+        if (position >= count) {
+            position -= count;
+        }
+        return offset;
+    }
+
+private:
+    static constexpr uint64_t LCG_MULTIPLIER = 6364136223846793005ULL;
+    static constexpr uint64_t LCG_INCREMENT = 1442695040888963407ULL;
+
+    bool random;
+    size_t unit;
+    size_t count;
+    size_t step;
+    size_t position;
+    uint64_t state;
+    uint64_t mask;
+};
+
+#endif // CXL_PATTERN_H
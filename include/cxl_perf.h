@@ -0,0 +1,58 @@
+#ifndef CXL_PERF_H
+#define CXL_PERF_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cxl_api.h"
+
+// perf_event_open counters around the timed test loops.
+//
+// Core events (cycles, instructions, LLC and dTLB load misses) count the
+// calling thread and, through inherit, every worker it starts inside the
+// window, user space only so the default perf_event_paranoid level allows
+// them. Uncore events are named like perf does, "pmu/event/" or
+// "pmu/event=0x04,umask=0x03/", resolved through sysfs, and summed over
+// every instance of the PMU (uncore_imc matches uncore_imc_0, _1, ...) on
+// one CPU of each instance's cpumask; they need system-wide access.
+// Counts are scaled for multiplexing. Events that cannot be opened are left
+// out and flagged as such rather than failing the test.
+class CXLPerfCounters {
+public:
+    CXLPerfCounters();
+    ~CXLPerfCounters();
+
+    CXLPerfCounters(const CXLPerfCounters&) = delete;
+    CXLPerfCounters& operator=(const CXLPerfCounters&) = delete;
+
+    // Open the core events and the ';'-separated uncore list (NULL = memory
+    // controller CAS counts); returns the CXL_PERF_* bits of core events opened
+    uint32_t open(const char* uncore_events);
+    void close();
+
+    bool active() const { return opened; }
+
+    // Reset and enable every counter
+    void start();
+
+    // Disable and read the counters into out
+    void stop(cxl_perf_counters* out);
+
+private:
+    struct Uncore {
+        std::string name;
+        std::vector<int> fds;
+    };
+
+    bool open_uncore(const std::string& spec, bool quiet);
+
+    bool opened;
+    uint32_t valid;
+    int core_fds[CXL_PERF_CORE_EVENTS];
+    std::vector<Uncore> uncore;
+    std::chrono::steady_clock::time_point started;
+};
+
+#endif // CXL_PERF_H
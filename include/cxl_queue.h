@@ -0,0 +1,276 @@
+#ifndef CXL_QUEUE_H
+#define CXL_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Lock-free message queues laid out entirely inside shared memory.
+//
+// Every field the two sides share (header, head and tail indices, slots)
+// lives in the memory handed to create(), so producers and consumers can sit
+// in different processes mapping the same device, or later on the FPGA. The
+// indices are on cache lines of their own and are only ever touched through
+// std::atomic_ref; the C++ objects just hold a pointer into the region plus
+// their own cached copies of the far index.
+//
+// One side calls create() to write the layout, the others attach() to it;
+// offsets travel between processes in a cxl_handle_t. T must be trivially
+// copyable since its bytes go through the region as they are.
+
+#define CXL_QUEUE_MAGIC     0x31304555514c5843ULL   // "CXLQUE01"
+#define CXL_QUEUE_LINE      64
+
+enum cxl_queue_kind_id : uint32_t {
+    CXL_QUEUE_KIND_SPSC = 1,
+    CXL_QUEUE_KIND_MPMC = 2
+};
+
+struct alignas(CXL_QUEUE_LINE) cxl_queue_header {
+    uint64_t magic;             // CXL_QUEUE_MAGIC once the layout is complete
+    uint32_t kind;              // cxl_queue_kind_id
+    uint32_t capacity;          // Slots, a power of two
+    uint32_t slot_size;         // sizeof the slot type, checked on attach
+};
+
+struct alignas(CXL_QUEUE_LINE) cxl_queue_index {
+    uint64_t value;             // Free-running position; slot is value & (capacity - 1)
+};
+
+// Layout and attach/create logic shared by both variants
+template <typename Slot, uint32_t Kind>
+class CXLQueueLayout {
+public:
+    // Bytes a queue of capacity slots occupies (capacity must be a power of two)
+    static size_t footprint(uint32_t capacity) {
+        return sizeof(Shared) + static_cast<size_t>(capacity) * sizeof(Slot);
+    }
+
+    bool valid() const { return shared != nullptr; }
+    uint32_t capacity() const { return shared ? shared->header.capacity : 0; }
+
+protected:
+    struct Shared {
+        cxl_queue_header header;
+        cxl_queue_index head;   // Next position to consume
+        cxl_queue_index tail;   // Next position to produce
+    };
+
+    CXLQueueLayout() : shared(nullptr), slots(nullptr), mask(0) {}
+
+    // Write an empty queue into memory; init_slot prepares each slot
+    template <typename Init>
+    bool format(void* memory, size_t bytes, uint32_t capacity, Init init_slot) {
+        shared = nullptr;
+        if (!memory || reinterpret_cast<uintptr_t>(memory) % CXL_QUEUE_LINE != 0 ||
+            capacity < 2 || (capacity & (capacity - 1)) != 0 || footprint(capacity) > bytes) {
+            return false;
+        }
+
+        Shared* s = static_cast<Shared*>(memory);
+        std::atomic_ref<uint64_t>(s->header.magic).store(0, std::memory_order_relaxed);
+        s->header.kind = Kind;
+        s->header.capacity = capacity;
+        s->header.slot_size = sizeof(Slot);
+        std::atomic_ref<uint64_t>(s->head.value).store(0, std::memory_order_relaxed);
+        std::atomic_ref<uint64_t>(s->tail.value).store(0, std::memory_order_relaxed);
+
+        Slot* first = reinterpret_cast<Slot*>(s + 1);
+        for (uint32_t i = 0; i < capacity; i++) {
+            init_slot(first[i], i);
+        }
+
+        // Publish last so an attach never sees a half-written queue
+        std::atomic_ref<uint64_t>(s->header.magic).store(CXL_QUEUE_MAGIC, std::memory_order_release);
+        bind(s);
+        return true;
+    }
+
+    bool bind_existing(void* memory, size_t bytes) {
+        shared = nullptr;
+        if (!memory || reinterpret_cast<uintptr_t>(memory) % CXL_QUEUE_LINE != 0 || bytes < sizeof(Shared)) {
+            return false;
+        }
+
+        Shared* s = static_cast<Shared*>(memory);
+        uint32_t capacity = s->header.capacity;
+        if (std::atomic_ref<uint64_t>(s->header.magic).load(std::memory_order_acquire) != CXL_QUEUE_MAGIC ||
+            s->header.kind != Kind || s->header.slot_size != sizeof(Slot) ||
+            capacity < 2 || (capacity & (capacity - 1)) != 0 || footprint(capacity) > bytes) {
+            return false;
+        }
+        bind(s);
+        return true;
+    }
+
+    static std::atomic_ref<uint64_t> index(cxl_queue_index& i) {
+        return std::atomic_ref<uint64_t>(i.value);
+    }
+
+    Shared* shared;
+    Slot* slots;
+    uint64_t mask;
+
+private:
+    void bind(Shared* s) {
+        shared = s;
+        slots = reinterpret_cast<Slot*>(s + 1);
+        mask = s->header.capacity - 1;
+    }
+};
+
+// Single producer, single consumer. Each side keeps the other's index cached
+// and only reloads it when the queue looks full (or empty), so the steady
+// state costs one shared store per message on each side.
+template <typename T>
+class CXLSpscQueue : public CXLQueueLayout<T, CXL_QUEUE_KIND_SPSC> {
+    static_assert(std::is_trivially_copyable<T>::value, "queue messages must be trivially copyable");
+    using Base = CXLQueueLayout<T, CXL_QUEUE_KIND_SPSC>;
+
+public:
+    CXLSpscQueue() : tail_pos(0), head_cache(0), head_pos(0), tail_cache(0) {}
+
+    bool create(void* memory, size_t bytes, uint32_t capacity) {
+        if (!Base::format(memory, bytes, capacity, [](T&, uint32_t) {})) {
+            return false;
+        }
+        load_positions();
+        return true;
+    }
+
+    bool attach(void* memory, size_t bytes) {
+        if (!Base::bind_existing(memory, bytes)) {
+            return false;
+        }
+        load_positions();
+        return true;
+    }
+
+    // Producer side; false if the queue is full
+    bool push(const T& value) {
+        if (tail_pos - head_cache > this->mask) {
+            head_cache = Base::index(this->shared->head).load(std::memory_order_acquire);
+            if (tail_pos - head_cache > this->mask) {
+                return false;
+            }
+        }
+        this->slots[tail_pos & this->mask] = value;
+        Base::index(this->shared->tail).store(++tail_pos, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false if the queue is empty
+    bool pop(T& value) {
+        if (head_pos == tail_cache) {
+            tail_cache = Base::index(this->shared->tail).load(std::memory_order_acquire);
+            if (head_pos == tail_cache) {
+                return false;
+            }
+        }
+        value = this->slots[head_pos & this->mask];
+        Base::index(this->shared->head).store(++head_pos, std::memory_order_release);
+        return true;
+    }
+
+private:
+    void load_positions() {
+        tail_pos = Base::index(this->shared->tail).load(std::memory_order_acquire);
+        head_pos = Base::index(this->shared->head).load(std::memory_order_acquire);
+        head_cache = head_pos;
+        tail_cache = tail_pos;
+    }
+
+    // Producer and consumer state on separate lines, in case one object serves both
+    alignas(CXL_QUEUE_LINE) uint64_t tail_pos;
+    uint64_t head_cache;
+    alignas(CXL_QUEUE_LINE) uint64_t head_pos;
+    uint64_t tail_cache;
+};
+
+template <typename T>
+struct CXLMpmcSlot {
+    uint64_t sequence;          // Whose turn the slot is: pos to produce, pos + 1 to consume
+    T value;
+};
+
+// Any number of producers and consumers (Vyukov's bounded queue). The slot
+// sequence numbers hand each slot back and forth, so producers and consumers
+// only contend on their own index and never on each other's.
+template <typename T>
+class CXLMpmcQueue : public CXLQueueLayout<CXLMpmcSlot<T>, CXL_QUEUE_KIND_MPMC> {
+    static_assert(std::is_trivially_copyable<T>::value, "queue messages must be trivially copyable");
+    using Slot = CXLMpmcSlot<T>;
+    using Base = CXLQueueLayout<Slot, CXL_QUEUE_KIND_MPMC>;
+    static_assert(alignof(Slot) >= std::atomic_ref<uint64_t>::required_alignment,
+                  "slot sequence must be suitably aligned for atomic_ref");
+
+public:
+    bool create(void* memory, size_t bytes, uint32_t capacity) {
+        return Base::format(memory, bytes, capacity, [](Slot& slot, uint32_t i) {
+            std::atomic_ref<uint64_t>(slot.sequence).store(i, std::memory_order_relaxed);
+        });
+    }
+
+    bool attach(void* memory, size_t bytes) {
+        return Base::bind_existing(memory, bytes);
+    }
+
+    // Safe from any thread or process; false if the queue is full
+    bool push(const T& value) {
+        auto tail = Base::index(this->shared->tail);
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = this->slots[pos & this->mask];
+            uint64_t seq = std::atomic_ref<uint64_t>(slot.sequence).load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    std::atomic_ref<uint64_t>(slot.sequence).store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Safe from any thread or process; false if the queue is empty
+    bool pop(T& value) {
+        auto head = Base::index(this->shared->head);
+        uint64_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = this->slots[pos & this->mask];
+            uint64_t seq = std::atomic_ref<uint64_t>(slot.sequence).load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = slot.value;
+                    std::atomic_ref<uint64_t>(slot.sequence).store(pos + this->mask + 1,
+                                                                   std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Back-off for callers spinning on a full or empty queue
+static inline void cxl_cpu_relax() {
+#if defined(__x86_64__)
+    _mm_pause();
+#endif
+}
+
+#endif // CXL_QUEUE_H
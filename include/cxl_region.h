@@ -0,0 +1,130 @@
+#ifndef CXL_REGION_H
+#define CXL_REGION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "cxl_api.h"
+
+// Header kept in the first CXL_REGION_HEADER_SIZE bytes of a device region.
+//
+// It names the region (a random id chosen when the header is first written,
+// carried in every cxl_handle_t), records the layout, and holds a fixed table
+// of named objects, so processes mapping the same device can find each other's
+// buffers and a restarted process finds its own again. All fields are offsets,
+// never pointers, since every process maps the region at a different address.
+//
+// The superblock is written once, at format time, in two copies on separate
+// pages; each carries a CRC-32C, and attaching repairs a damaged copy from the
+// intact one. Table entries carry their own checksum, written last on insert
+// and cleared first on removal, so an update cut short by a crash leaves an
+// entry that fails its check and is dropped instead of a half-named object.
+// Every update is written back from the CPU cache before it counts.
+//
+// Table updates take a spinlock stored in the header next to the pid holding
+// it, so a lock left behind by a dead process can be taken over.
+
+#define CXL_REGION_MAGIC        0x3130524d52454848ULL   // "HHERMR01"
+#define CXL_REGION_VERSION      2
+#define CXL_REGION_HEADER_SIZE  (64 * 1024)             // Never handed out by the allocator
+#define CXL_REGION_DIR_ENTRIES  512
+#define CXL_REGION_BLOCK        4096                    // One superblock copy per block
+#define CXL_REGION_COPIES       2
+
+struct cxl_region_superblock {
+    uint64_t magic;                         // CXL_REGION_MAGIC once formatted, stored last
+    uint32_t version;                       // CXL_REGION_VERSION
+    uint32_t region_id;                     // Non-zero 16-bit id for handles
+    uint64_t sequence;                      // The higher of two intact copies wins
+    uint64_t region_size;                   // Size of the region when formatted
+    uint64_t header_size;                   // CXL_REGION_HEADER_SIZE
+    uint64_t table_offset;                  // Region offset of the object table
+    uint32_t table_entries;                 // CXL_REGION_DIR_ENTRIES
+    uint32_t entry_size;                    // sizeof(cxl_region_dir_entry)
+    uint64_t scratch_offset;                // Extent the benchmarks may overwrite
+    uint64_t scratch_size;
+    uint32_t reserved[9];
+    uint32_t checksum;                      // CRC-32C of everything above
+};
+
+struct cxl_region_dir_entry {
+    char name[CXL_OBJECT_NAME_MAX + 1];     // NUL-terminated; empty = unused slot
+    uint64_t offset;                        // Region offset of the object
+    uint64_t length;                        // Object size in bytes
+    uint32_t checksum;                      // Over name, offset, length and region id; 0 = free
+    uint32_t reserved;
+};
+
+struct cxl_region_header {
+    union {
+        cxl_region_superblock super;
+        char block[CXL_REGION_BLOCK];
+    } copies[CXL_REGION_COPIES];
+    uint32_t lock;                          // Pid holding the table lock (0 = free)
+    uint32_t generation;                    // Bumped on every table change
+    uint32_t reserved[14];
+    struct cxl_region_dir_entry entries[CXL_REGION_DIR_ENTRIES];
+};
+
+static_assert(sizeof(cxl_region_header) <= CXL_REGION_HEADER_SIZE, "region header too large");
+
+// Directory of named objects in a mapped region's header
+class CXLObjectDirectory {
+public:
+    CXLObjectDirectory();
+
+    // Whether a region of size bytes is large enough to carry a header
+    static bool fits(size_t size);
+
+    // Attach to the header at the start of a mapped region. A blank region, or
+    // any region when format is set, gets a fresh header with a scratch extent
+    // of scratch_size bytes (cxl_init_options); a version 1 header is upgraded
+    // in place, objects included. Fails, after saying why, on a layout that
+    // cannot be trusted: a newer version, or no intact superblock copy.
+    bool attach(void* region, size_t size, size_t scratch_size, bool format);
+    void detach();
+
+    bool attached() const { return header != nullptr; }
+    uint16_t region_id() const;
+
+    // Scratch extent, clipped to the mapping
+    uint64_t scratch_offset() const;
+    uint64_t scratch_size() const;
+
+    void get_info(cxl_region_info* info) const;
+
+    // Changes whenever any process adds or removes an object
+    uint32_t generation() const;
+
+    // Table lock, shared by every process mapping the region
+    void lock();
+    void unlock();
+
+    // Lookups and updates; callers hold lock()
+    bool insert(const char* name, uint64_t offset, uint64_t length);
+    bool find(const char* name, uint64_t* offset, uint64_t* length) const;
+    bool remove(const char* name, uint64_t* offset);
+
+    // (offset, length) of every object
+    std::vector<std::pair<uint64_t, uint64_t>> extents() const;
+
+    // Clear entries a crashed update left behind; callers hold lock()
+    uint32_t scrub();
+
+private:
+    void format(size_t size, size_t scratch_size, uint32_t id, const std::vector<cxl_region_dir_entry>& keep);
+    void upgrade(size_t size, size_t scratch_size);
+    void write_copy(int index, const cxl_region_superblock& copy);
+    bool entry_valid(const cxl_region_dir_entry& entry) const;
+    uint32_t entry_checksum(const cxl_region_dir_entry& entry) const;
+
+    cxl_region_header* header;
+    cxl_region_superblock super;            // Copy of the intact superblock
+    size_t mapped_size;
+    bool formatted;                         // This attach wrote the header
+    uint32_t repaired;                      // Damage fixed while attaching
+};
+
+#endif // CXL_REGION_H
@@ -0,0 +1,96 @@
+#ifndef CXL_RING_H
+#define CXL_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "cxl_common.h"
+
+// Userspace side of the driver's submission/completion ring.
+//
+// Commands are written straight into the mmap'd submission queue and handed
+// to the driver with one CXL_MEM_RING_ENTER per batch; completions are read
+// from the completion queue without any system call.
+
+// Commands seen by one ring since it was opened or last reset
+struct CXLRingStats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t failed;            // Reaped with any status but CXL_CMD_STATUS_COMPLETED
+    uint64_t latency_count;     // Reaped commands whose submission was timed
+    uint64_t latency_total_ns;  // Submission to reaping
+    uint64_t latency_max_ns;
+    uint64_t bytes[CMD_ACCELERATE + 1];     // Per opcode, over completed commands
+};
+
+class CXLCommandRing {
+public:
+    CXLCommandRing();
+    ~CXLCommandRing();
+
+    // Set up and map the ring for an open device; fails on non-driver files
+    bool open(int device_fd);
+    void close();
+    bool is_open() const { return ring != nullptr; }
+
+    // Post up to count commands and ring the doorbell once; returns commands accepted.
+    // The driver stops taking SQEs while the CQ has no room for their completions;
+    // those stay in the SQ until reap() or collect() frees CQ slots and rings again.
+    // Entries count as accepted once published, even if the doorbell then fails
+    int submit(const struct cxl_ring_sqe* cmds, int count);
+
+    // Copy up to max completions out of the CQ; returns completions reaped
+    int reap(struct cxl_ring_cqe* out, int max);
+
+    // Sleep in the driver until a command finishes (0 on success, -errno otherwise)
+    int wait(uint32_t id, uint32_t timeout_ms, struct cxl_ring_cqe* out);
+
+    // Reap until every listed command has completed, writing completions to out
+    // in the order of ids; other completions are held back for reap().
+    // timeout_ms bounds the whole call. Returns 0 on success, -errno otherwise
+    int collect(const uint32_t* ids, int count, struct cxl_ring_cqe* out, uint32_t timeout_ms);
+
+    // Give up on commands collect() timed out on: their completions are dropped
+    // when they arrive instead of being held for reap()
+    void abandon(const uint32_t* ids, int count);
+
+    // Add this ring's counters into stats
+    void add_stats(CXLRingStats* stats) const;
+    void reset_stats();
+
+private:
+    // What was posted in each command table slot, for the completion counters
+    struct Posted {
+        uint32_t id;
+        uint32_t opcode;
+        uint32_t length;
+        uint64_t start_ns;
+    };
+
+    void account(const struct cxl_ring_cqe& cqe);   // Called with reap_lock held
+
+    // Ring again if SQEs are still waiting for the driver; 0 or -1
+    int enter();
+
+    int fd;                     // Device the ring belongs to
+    struct cxl_ring* ring;      // Mapped ring
+    size_t map_size;            // Length of the ring mapping
+    std::mutex submit_lock;     // Serializes SQ producers
+    std::mutex reap_lock;       // Serializes CQ consumers
+    std::vector<struct cxl_ring_cqe> held;  // Reaped by collect() for someone else (reap_lock)
+    std::unordered_set<uint32_t> abandoned; // Ids whose completions nobody waits for (reap_lock)
+    Posted slots[CXL_RING_ENTRIES];         // Written under submit_lock before the doorbell
+    std::atomic<uint64_t> submitted;
+    std::atomic<uint64_t> completed;
+    std::atomic<uint64_t> failed;
+    std::atomic<uint64_t> latency_count;
+    std::atomic<uint64_t> latency_total_ns;
+    std::atomic<uint64_t> latency_max_ns;
+    std::atomic<uint64_t> bytes[CMD_ACCELERATE + 1];
+};
+
+#endif // CXL_RING_H
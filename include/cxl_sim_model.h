@@ -0,0 +1,52 @@
+#ifndef CXL_SIM_MODEL_H
+#define CXL_SIM_MODEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Latency and bandwidth model for the simulated device.
+//
+// The simulator writes "latency_ns <n>" and "bandwidth_gbps <x>" lines to
+// <device>.model next to the device it exposes. Every dependent access then
+// pays latency_ns on top of the host memory underneath, and every block
+// transfer queues behind the others on a single link of bandwidth_gbps.
+class CXLSimModel {
+public:
+    CXLSimModel();
+
+    // Read <device_path>.model; returns false (and stays inactive) if there is none
+    bool load(const char* device_path);
+    void reset();
+
+    // Put another device's link alongside this one, as for a striped device set:
+    // bandwidths add up (unthrottled if either is) and the higher latency applies
+    void add_link(const CXLSimModel& other);
+
+    bool active() const { return enabled; }
+    double latency_ns() const { return latency; }
+    double bandwidth_gbps() const { return bandwidth; }
+
+    // Charge one dependent access, such as a pointer-chase hop
+    void access() const {
+        if (latency_ticks) {
+            spin(latency_ticks);
+        }
+    }
+
+    // Charge a transfer that started at start; returns once the modelled
+    // link would have delivered it
+    void transfer(size_t bytes, std::chrono::steady_clock::time_point start);
+
+private:
+    static void spin(uint64_t ticks);
+
+    bool enabled;
+    double latency;             // Injected ns per access (0 = none)
+    double bandwidth;           // Link GB/s (0 = unthrottled)
+    uint64_t latency_ticks;     // latency in cxl_rdtscp ticks
+    std::atomic<int64_t> link_free_ns;  // steady_clock time the link drains
+};
+
+#endif // CXL_SIM_MODEL_H
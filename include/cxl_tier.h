@@ -0,0 +1,129 @@
+#ifndef CXL_TIER_H
+#define CXL_TIER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cxl_api.h"
+#include "cxl_allocator.h"
+
+// Two-tier memory: a reserved virtual range whose chunks are each mapped from
+// either a DRAM pool (a memfd bound to the local node) or an extent of the
+// CXL device file, so a chunk changes tier by copying it and remapping the
+// same addresses over the new pages.
+//
+// A chunk being copied is made read-only; writers fault into a SIGSEGV
+// handler that waits for the remap and lets the access retry. The same
+// handler takes the hinting faults of CXL_TIER_HEAT_FAULT, where every chunk
+// is protected once per scan and its first touch counted. With
+// CXL_TIER_HEAT_IDLE a few pages per chunk are sampled through the kernel's
+// idle page bitmap instead, which costs no faults. The bitmap only tracks LRU
+// pages, so when a PFN-mapped BAR or device-DAX extent doesn't keep its idle
+// bits the CXL pool falls back to hinting faults. Heat decays by half every
+// scan. Objects are placed with CXLAllocator over the virtual range, and a
+// chunk is backed while any object overlaps it. One CXL slot is always kept
+// free so a full DRAM tier can still swap a hot chunk for a cold one.
+//
+// The kernel does not fault on behalf of system calls: read() into a chunk
+// being migrated, or any I/O on a chunk protected for sampling, fails with
+// EFAULT. Stage such I/O through ordinary buffers or use CXL_TIER_HEAT_IDLE
+// (which still protects CXL chunks on devices the bitmap can't track).
+class CXLTierManager {
+public:
+    CXLTierManager();
+    ~CXLTierManager();
+
+    CXLTierManager(const CXLTierManager&) = delete;
+    CXLTierManager& operator=(const CXLTierManager&) = delete;
+
+    // cxl_fd maps the device; [cxl_offset, cxl_offset + config.cxl_bytes) is the
+    // extent the CXL tier owns and cxl_view its mapping in this process
+    bool init(int cxl_fd, size_t cxl_offset, void* cxl_view, const cxl_tier_config& config);
+    void shutdown();
+
+    void* allocate(size_t size, int placement);
+    bool release(void* ptr);
+
+    int where(const void* ptr);
+    int migrate_range(const void* ptr, size_t length, int target);
+    int scan();
+
+    void get_stats(cxl_tier_stats* stats);
+
+    // Called from the SIGSEGV handler; true if the fault was ours and the access may retry
+    bool handle_fault(void* addr);
+
+private:
+    enum ChunkState : uint32_t {
+        CHUNK_UNBACKED = 0,     // PROT_NONE placeholder
+        CHUNK_RESIDENT,         // Mapped read/write
+        CHUNK_SAMPLING,         // Protected until the next touch (hinting faults)
+        CHUNK_UNPROTECTING,     // A fault is reopening it
+        CHUNK_MIGRATING         // Read-only while being copied
+    };
+
+    struct Chunk {
+        std::atomic<uint32_t> state;
+        std::atomic<uint32_t> touched;  // Hinting faults since the last scan
+        uint32_t refs;                  // Live objects overlapping the chunk
+        int tier;                       // CXL_TIER_DRAM or CXL_TIER_CXL while backed
+        uint32_t slot;                  // Slot in that tier's pool
+        uint32_t heat;
+    };
+
+    char* chunk_addr(size_t index) const { return base + index * granule; }
+    char* slot_addr(int tier, uint32_t slot) const {
+        return (tier == CXL_TIER_DRAM ? dram_view : cxl_view) + static_cast<size_t>(slot) * granule;
+    }
+
+    bool take_slot(int tier, bool spare, uint32_t* slot);
+    bool map_slot(size_t index, int tier, uint32_t slot);
+    void unback(size_t index);
+    bool move_chunk(size_t index, int target);
+    uint32_t sample_chunk(size_t index);
+    uint32_t sample_faults(size_t index);
+    bool idle_available();
+    void scanner();
+
+    int dram_fd;
+    int cxl_fd;
+    size_t cxl_offset;
+    char* dram_view;
+    char* cxl_view;
+    void* reservation;              // Address space reserved for the tiered range
+    size_t reserved_bytes;
+    char* base;                     // Tiered range, aligned to the granule inside the reservation
+    size_t granule;
+    size_t num_chunks;
+    uint32_t slots[2];              // Pool sizes in chunks
+    std::unique_ptr<Chunk[]> chunks;
+    std::vector<uint32_t> free_slots[2];
+    CXLAllocator allocator;         // Object placement over the virtual range
+    std::unordered_map<size_t, size_t> objects;  // Offset -> requested size
+    int heat_source;
+    int pagemap_fd;
+    int idle_fd;
+    bool idle_tracked[2];           // Whether each pool's pages keep their idle bits
+    double migrate_mbps;
+    std::chrono::steady_clock::time_point last_scan;
+    cxl_tier_stats stats;
+    std::atomic<uint64_t> hint_faults;
+
+    std::mutex lock;                // Everything above except the chunk atomics
+    std::thread worker;             // Background scanner
+    std::mutex worker_lock;         // Guards stopping
+    std::condition_variable wake;
+    bool stopping;
+    uint32_t interval_ms;
+    bool registered;
+};
+
+#endif // CXL_TIER_H
@@ -0,0 +1,78 @@
+#ifndef CXL_ZSTORE_H
+#define CXL_ZSTORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "cxl_api.h"
+
+// Compressed object store over the region allocator.
+//
+// Cold data is often far more compressible than it is hot, and capacity,
+// not bandwidth, is what runs out on a card. put() compresses an object on
+// the CPU into a staging buffer, allocates just the compressed size with
+// cxl_alloc and writes it with cxl_writev; objects that don't shrink by
+// min_ratio are stored as is. The index (key -> region block, sizes, codec)
+// lives in DRAM only, so the store doesn't outlive the process.
+//
+// get() decompresses straight out of the region on write-back mappings. On
+// uncached and write-combining device mappings, where CPU reads are slow,
+// it first reads the compressed bytes into DRAM with cxl_readv. Gets run
+// concurrently; put and remove exclude them only while the index changes.
+class CXLCompressedStore {
+public:
+    CXLCompressedStore();
+    ~CXLCompressedStore();
+
+    CXLCompressedStore(const CXLCompressedStore&) = delete;
+    CXLCompressedStore& operator=(const CXLCompressedStore&) = delete;
+
+    bool init(void* handle, const cxl_zstore_config& config);
+    void shutdown();
+
+    uint64_t put(const void* data, size_t size);
+    int64_t get(uint64_t key, void* out, size_t capacity);
+    int64_t size(uint64_t key);
+    bool remove(uint64_t key);
+
+    void get_stats(cxl_zstore_stats* stats);
+
+private:
+    struct Object {
+        char* block;            // In the region
+        size_t stored;          // Bytes at block
+        size_t size;            // Object size
+        int codec;
+    };
+
+    // Copy stored bytes of an object somewhere the CPU reads quickly
+    const char* fetch(const Object& object, char* staging);
+
+    void* handle;
+    char* region;               // Mapping cxl_writev/cxl_readv offsets are relative to
+    int codec;
+    double min_ratio;
+    bool in_place;              // Decompress from the mapping without staging
+
+    std::shared_mutex lock;     // Guards objects and the totals below; gets hold it shared
+    std::unordered_map<uint64_t, Object> objects;
+    uint64_t next_key;
+    uint64_t compressed_objects;
+    uint64_t logical_bytes;
+    uint64_t stored_bytes;
+
+    std::atomic<uint64_t> puts;
+    std::atomic<uint64_t> compress_bytes;       // Input to the codec
+    std::atomic<uint64_t> compress_ns;
+    std::atomic<uint64_t> gets;
+    std::atomic<uint64_t> get_ns;
+    std::atomic<uint64_t> get_max_ns;
+    std::atomic<uint64_t> decompressions;       // Gets of compressed objects
+    std::atomic<uint64_t> decompress_bytes;     // Their output
+    std::atomic<uint64_t> decompress_ns;
+};
+
+#endif // CXL_ZSTORE_H
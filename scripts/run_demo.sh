@@ -18,7 +18,7 @@ if [ -f "./build/cxl_simulator" ]; then
 else
     echo "CXL simulator executable not found, creating simulated device manually"
     mkdir -p /tmp/cxl_sim
-    touch /tmp/cxl_sim/cxl0
+    truncate -s 1G /tmp/cxl_sim/cxl0
 fi
 
 # Run the system with simulated environment
@@ -14,13 +14,14 @@ pip3 install numpy matplotlib
 
 # Build the simulation components
 echo "Building simulation components..."
-g++ -std=c++17 -Wall -o build/cxl_simulator src/simulation/cxl_simulator.cpp
+g++ -std=c++20 -Wall -o build/cxl_simulator src/app/simulation/cxl_simulator.cpp
 
 # Build modified libcxl with simulation support
-g++ -std=c++17 -Wall -fPIC -shared -o build/libcxl_sim.so src/lib/libcxl.cpp -I./include -DSIMULATION_MODE
+g++ -std=c++20 -Wall -fPIC -shared -pthread -o build/libcxl_sim.so src/app/lib/*.cpp -I./include -DSIMULATION_MODE
 
 # Build system application with simulation support
-g++ -std=c++17 -Wall -o build/cxl_system_sim src/app/cxl_system.cpp -I./include -L./build -lcxl_sim -DSIMULATION_MODE -Wl,-rpath,./build
+g++ -std=c++20 -Wall -o build/cxl_system_sim src/app/cxl_system.cpp -I./include -L./build -lcxl_sim -DSIMULATION_MODE -Wl,-rpath,./build
+g++ -std=c++20 -Wall -O2 -o build/cxl_bench_sim src/app/cxl_bench.cpp -I./include -L./build -lcxl_sim -DSIMULATION_MODE -Wl,-rpath,./build
 
 # Setup Python test environment
 pip3 install numpy matplotlib seaborn pandas ipywidgets jupyter pytest
@@ -0,0 +1,649 @@
+// Benchmark matrix runner: bandwidth over block sizes and thread counts,
+// access-pattern sweeps, pointer-chase latency (idle and under load) and compute kernels, on the CXL
+// device and on a host DRAM baseline, written as one JSON document (or CSV) for test_framework.py.
+//
+// Every record carries the same fields so the harness can filter on them:
+// test, target, op, pattern, block_size, threads, GB/s and the latency
+// percentiles. Fields a test does not measure are null (empty in CSV).
+// Loaded-latency records also carry the traffic threads' injection delay;
+// their gbps is the traffic bandwidth the latency was measured under.
+// Bandwidth is in GiB/s like the rest of libcxl. With --perf each record
+// also carries the hardware counters read around its timed loop.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include "cxl_api.h"
+
+#define BENCH_DEFAULT_BYTES         (256UL << 20)   // Data moved per bandwidth point
+#define BENCH_DEFAULT_CHASE_SET     (64UL << 20)    // Chase footprint, well past the LLC
+#define BENCH_DEFAULT_COMPUTE_BYTES (16UL << 20)    // Per array
+#define BENCH_DEFAULT_PATTERN_BYTES (32UL << 20)    // Data moved per pattern sweep point
+#define BENCH_PATTERN_MIN_BLOCK     64
+#define BENCH_LOADED_BLOCK          1024            // Traffic access size under loaded latency
+
+struct BenchOptions {
+    std::string device = "/tmp/cxl_sim/cxl0";
+    size_t size = 1UL << 30;
+    bool dram = true;
+    bool bandwidth = true;
+    bool latency = true;
+    bool compute = true;
+    bool pattern = true;
+    bool loaded = true;
+    std::vector<size_t> block_sizes = { 4 << 10, 8 << 10, 16 << 10, 32 << 10, 64 << 10,
+                                        128 << 10, 256 << 10, 512 << 10, 1 << 20 };
+    std::vector<int> threads;
+    size_t bytes = BENCH_DEFAULT_BYTES;
+    size_t pattern_bytes = BENCH_DEFAULT_PATTERN_BYTES;
+    size_t pattern_max_block = 1UL << 30;
+    int latency_iterations = 2000;
+    bool perf = false;
+    std::string uncore_events;  // Empty = libcxl's memory-controller default
+    std::string format = "json";
+    std::string output;
+};
+
+struct BenchRecord {
+    std::string test;           // bandwidth, pattern, latency, loaded_latency or compute
+    std::string target;         // cxl or dram
+    std::string op;
+    std::string pattern;
+    size_t block_size;          // Transfer size; chase stride; compute tile
+    int threads;
+    size_t working_set;         // Bytes the test spans (0 = the whole region)
+    long delay;                 // Loaded-latency injection delay (-1 = not a loaded test)
+    double gbps;                // < 0 when not measured
+    double gflops;              // < 0 when not measured
+    bool has_latency;
+    cxl_latency_stats latency;
+    bool has_perf;
+    cxl_perf_counters perf;
+};
+
+// Host and run description stored alongside the records
+struct BenchHost {
+    std::string hostname;
+    std::string kernel;
+    std::string cpu_model;
+    std::string timestamp;
+    std::string build;
+    std::string copy_kernel;
+    std::string cache_mode;
+    std::string backend;
+    long cpus;
+    std::vector<int> numa_nodes;
+    size_t page_size;
+    int memory_node;
+    bool sim_model;
+    double sim_latency_ns;
+    double sim_bandwidth_gbps;
+};
+
+static std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            out += '\\';
+            out += ch;
+        } else if (static_cast<unsigned char>(ch) < 0x20) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", ch);
+            out += esc;
+        } else {
+            out += ch;
+        }
+    }
+    return out + "\"";
+}
+
+static std::string json_number(double v, const char* fmt = "%.3f") {
+    if (v < 0.0) {
+        return "null";
+    }
+    char buf[64];
+    snprintf(buf, sizeof(buf), fmt, v);
+    return buf;
+}
+
+// "4K", "2M", "1G" or plain bytes
+static bool parse_size(const std::string& s, size_t* out) {
+    char* end = nullptr;
+    unsigned long long v = strtoull(s.c_str(), &end, 0);
+    if (end == s.c_str()) {
+        return false;
+    }
+    switch (*end) {
+    case 'K': case 'k': v <<= 10; end++; break;
+    case 'M': case 'm': v <<= 20; end++; break;
+    case 'G': case 'g': v <<= 30; end++; break;
+    default: break;
+    }
+    if (*end != '\0' || v == 0) {
+        return false;
+    }
+    *out = v;
+    return true;
+}
+
+static std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> parts;
+    std::stringstream list(s);
+    std::string part;
+    while (std::getline(list, part, ',')) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+static BenchHost collect_host(void* cxl) {
+    BenchHost host;
+    char name[256] = {};
+    gethostname(name, sizeof(name) - 1);
+    host.hostname = name;
+
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        host.kernel = std::string(uts.sysname) + " " + uts.release + " " + uts.machine;
+    }
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            host.cpu_model = colon == std::string::npos ? "" : line.substr(colon + 2);
+            break;
+        }
+    }
+
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    host.timestamp = stamp;
+
+#ifdef SIMULATION_MODE
+    host.build = "simulation";
+#else
+    host.build = "hardware";
+#endif
+    host.copy_kernel = cxl_kernel_name(cxl_get_kernel(cxl));
+    switch (cxl_get_cache_mode(cxl)) {
+        case CXL_CACHE_UNCACHED:        host.cache_mode = "uncached"; break;
+        case CXL_CACHE_WRITE_COMBINING: host.cache_mode = "write-combining"; break;
+        default:                        host.cache_mode = "write-back"; break;
+    }
+    switch (cxl_get_backend(cxl)) {
+        case CXL_BACKEND_FILE:   host.backend = "file"; break;
+        case CXL_BACKEND_FPGA:   host.backend = "fpga"; break;
+        case CXL_BACKEND_DEVDAX: host.backend = "devdax"; break;
+        case CXL_BACKEND_FSDAX:  host.backend = "fsdax"; break;
+        default:                 host.backend = "host"; break;
+    }
+    host.cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    int nodes[64];
+    int count = cxl_numa_get_nodes(nodes, 64);
+    host.numa_nodes.assign(nodes, nodes + std::max(count, 0));
+
+    host.page_size = cxl_get_page_size(cxl);
+    host.memory_node = cxl_get_numa_node(cxl);
+    host.sim_model = cxl_get_sim_model(cxl, &host.sim_latency_ns, &host.sim_bandwidth_gbps) == 1;
+    return host;
+}
+
+static BenchRecord make_record(const char* test, const char* target, const char* op, const char* pattern,
+                               size_t block_size, int threads) {
+    BenchRecord r;
+    r.test = test;
+    r.target = target;
+    r.op = op;
+    r.pattern = pattern;
+    r.block_size = block_size;
+    r.threads = threads;
+    r.working_set = 0;
+    r.delay = -1;
+    r.gbps = -1.0;
+    r.gflops = -1.0;
+    r.has_latency = false;
+    memset(&r.latency, 0, sizeof(r.latency));
+    r.has_perf = false;
+    memset(&r.perf, 0, sizeof(r.perf));
+    return r;
+}
+
+// Counters from the timed loop that just produced r
+static void attach_perf(void* region, const BenchOptions& opts, BenchRecord& r) {
+    r.has_perf = opts.perf && cxl_perf_last(region, &r.perf) == 0;
+}
+
+static void run_bandwidth(void* region, const char* target, const BenchOptions& opts,
+                          std::vector<BenchRecord>& records) {
+    for (int threads : opts.threads) {
+        for (size_t block : opts.block_sizes) {
+            int iterations = static_cast<int>(std::max<size_t>(16, opts.bytes / block / threads));
+            cxl_bw_config config = { threads, 1, nullptr, 0 };
+            for (int is_write = 0; is_write < 2; is_write++) {
+                double gbps = is_write ? cxl_test_write_mt(region, nullptr, block, iterations, &config, nullptr)
+                                       : cxl_test_read_mt(region, nullptr, block, iterations, &config, nullptr);
+                if (gbps <= 0.0) {
+                    continue;
+                }
+                BenchRecord r = make_record("bandwidth", target, is_write ? "write" : "read",
+                                            "sequential", block, threads);
+                r.gbps = gbps;
+                attach_perf(region, opts, r);
+                records.push_back(r);
+            }
+        }
+    }
+}
+
+// Every pattern over the block-size sweep, then one timed pass of small
+// accesses per pattern for the latency percentiles
+static void run_pattern(void* region, const char* target, const BenchOptions& opts,
+                        std::vector<BenchRecord>& records) {
+    for (int pattern = 0; pattern < CXL_PATTERN_COUNT; pattern++) {
+        cxl_pattern_config config = { pattern, 0, 0, 0, 0, 0, 1 };
+        cxl_pattern_result points[64];
+        for (int is_write = 0; is_write < 2; is_write++) {
+            // Gather only reads and scatter only writes
+            if ((pattern == CXL_PATTERN_GATHER && is_write) || (pattern == CXL_PATTERN_SCATTER && !is_write)) {
+                continue;
+            }
+            config.is_write = is_write;
+            if (!opts.perf) {
+                int n = cxl_pattern_sweep(region, &config, BENCH_PATTERN_MIN_BLOCK, opts.pattern_max_block,
+                                          opts.pattern_bytes, points, 64);
+                for (int i = 0; i < n; i++) {
+                    BenchRecord r = make_record("pattern", target, is_write ? "write" : "read",
+                                                cxl_pattern_name(pattern), points[i].block_size, 1);
+                    r.gbps = points[i].gbps;
+                    records.push_back(r);
+                }
+                continue;
+            }
+            // One point per sweep so the counters belong to a single block size
+            for (size_t block = BENCH_PATTERN_MIN_BLOCK; block <= opts.pattern_max_block; block *= 2) {
+                if (cxl_pattern_sweep(region, &config, block, block, opts.pattern_bytes, points, 1) != 1) {
+                    break;
+                }
+                BenchRecord r = make_record("pattern", target, is_write ? "write" : "read",
+                                            cxl_pattern_name(pattern), points[0].block_size, 1);
+                r.gbps = points[0].gbps;
+                attach_perf(region, opts, r);
+                records.push_back(r);
+            }
+        }
+
+        config.block_size = BENCH_PATTERN_MIN_BLOCK;
+        config.is_write = pattern == CXL_PATTERN_SCATTER;
+        BenchRecord r = make_record("latency", target, "access", cxl_pattern_name(pattern),
+                                    BENCH_PATTERN_MIN_BLOCK, 1);
+        cxl_pattern_result result;
+        if (cxl_test_pattern(region, &config, opts.latency_iterations * 10, &result, &r.latency) > 0.0) {
+            r.gbps = result.gbps;
+            r.has_latency = true;
+            attach_perf(region, opts, r);
+            records.push_back(r);
+        }
+    }
+}
+
+static void run_latency(void* region, const char* target, const BenchOptions& opts,
+                        std::vector<BenchRecord>& records) {
+    // Cache-line and page strides: the second adds a TLB miss to every hop
+    for (size_t stride : { 64UL, 4096UL }) {
+        cxl_chase_config config = { BENCH_DEFAULT_CHASE_SET, stride, CXL_PAGES_DEFAULT };
+        BenchRecord r = make_record("latency", target, "chase", "random", stride, 1);
+        if (cxl_test_latency_chase(region, &config, opts.latency_iterations, &r.latency) <= 0.0 ||
+            !r.latency.samples) {
+            continue;
+        }
+        r.working_set = config.working_set;
+        r.has_latency = true;
+        attach_perf(region, opts, r);
+        records.push_back(r);
+    }
+}
+
+// Chase latency against read-only and write-only traffic from the other CPUs,
+// over libcxl's default injection delays
+static void run_loaded(void* region, const char* target, const BenchOptions& opts,
+                       std::vector<BenchRecord>& records) {
+    for (int is_write = 0; is_write < 2; is_write++) {
+        cxl_loaded_latency_config config = {};
+        config.chase = { BENCH_DEFAULT_CHASE_SET, 64, CXL_PAGES_DEFAULT };
+        config.write_percent = is_write ? 100 : 0;
+        config.block_size = BENCH_LOADED_BLOCK;
+        cxl_loaded_latency_point points[64];
+        int n = cxl_loaded_latency(region, &config, opts.latency_iterations, points, 64);
+        for (int i = 0; i < n; i++) {
+            if (!points[i].latency.samples) {
+                continue;
+            }
+            BenchRecord r = make_record("loaded_latency", target, is_write ? "write" : "read", "random",
+                                        BENCH_LOADED_BLOCK, points[i].traffic_threads);
+            r.working_set = config.chase.working_set;
+            r.delay = points[i].delay;
+            r.gbps = points[i].traffic_gbps;
+            r.latency = points[i].latency;
+            r.has_latency = true;
+            records.push_back(r);
+        }
+    }
+}
+
+static void run_compute(void* region, const char* target, const BenchOptions& opts,
+                        std::vector<BenchRecord>& records) {
+    static const char* names[CXL_COMPUTE_OP_COUNT] = { "scale", "add", "triad", "dot", "sum" };
+    for (int op = 0; op < CXL_COMPUTE_OP_COUNT; op++) {
+        cxl_compute_config config = { op, CXL_COMPUTE_ISA_AUTO, BENCH_DEFAULT_COMPUTE_BYTES / sizeof(float), 0, 0 };
+        cxl_compute_result result;
+        if (cxl_test_compute(region, &config, &result) <= 0.0) {
+            continue;
+        }
+        BenchRecord r = make_record("compute", target, names[op], "sequential", 16 << 10, 1);
+        r.working_set = BENCH_DEFAULT_COMPUTE_BYTES;
+        r.gbps = result.gbps;
+        r.gflops = result.gflops;
+        attach_perf(region, opts, r);
+        records.push_back(r);
+    }
+}
+
+// Core counters the PMU could not open are null
+static std::string perf_count(const cxl_perf_counters& p, uint32_t bit, uint64_t value) {
+    return p.valid & bit ? std::to_string(value) : "null";
+}
+
+static std::string json_perf(const BenchRecord& r) {
+    if (!r.has_perf) {
+        return "null";
+    }
+    const cxl_perf_counters& p = r.perf;
+    std::string out = "{\"seconds\": " + json_number(p.seconds, "%.6f") +
+                      ", \"cycles\": " + perf_count(p, CXL_PERF_CYCLES, p.cycles) +
+                      ", \"instructions\": " + perf_count(p, CXL_PERF_INSTRUCTIONS, p.instructions) +
+                      ", \"llc_misses\": " + perf_count(p, CXL_PERF_LLC_MISSES, p.llc_misses) +
+                      ", \"dtlb_misses\": " + perf_count(p, CXL_PERF_DTLB_MISSES, p.dtlb_misses) +
+                      ", \"ipc\": " + ((p.valid & CXL_PERF_CYCLES) && (p.valid & CXL_PERF_INSTRUCTIONS) && p.cycles
+                                        ? json_number(static_cast<double>(p.instructions) / p.cycles, "%.3f")
+                                        : std::string("null")) +
+                      ", \"uncore\": {";
+    for (int i = 0; i < p.num_uncore; i++) {
+        if (i) {
+            out += ", ";
+        }
+        out += json_string(p.uncore_name[i]) + ": " + std::to_string(p.uncore_count[i]);
+    }
+    return out + "}}";
+}
+
+static void write_json(FILE* out, const BenchHost& host, const BenchOptions& opts,
+                       const std::vector<BenchRecord>& records) {
+    fprintf(out, "{\n  \"format\": \"hermes-cxl-bench\",\n  \"version\": 1,\n  \"host\": {\n");
+    fprintf(out, "    \"hostname\": %s,\n", json_string(host.hostname).c_str());
+    fprintf(out, "    \"kernel\": %s,\n", json_string(host.kernel).c_str());
+    fprintf(out, "    \"cpu_model\": %s,\n", json_string(host.cpu_model).c_str());
+    fprintf(out, "    \"cpus\": %ld,\n", host.cpus);
+    fprintf(out, "    \"numa_nodes\": [");
+    for (size_t i = 0; i < host.numa_nodes.size(); i++) {
+        fprintf(out, "%s%d", i ? ", " : "", host.numa_nodes[i]);
+    }
+    fprintf(out, "],\n");
+    fprintf(out, "    \"timestamp\": %s,\n", json_string(host.timestamp).c_str());
+    fprintf(out, "    \"build\": %s,\n", json_string(host.build).c_str());
+    fprintf(out, "    \"device\": %s,\n", json_string(opts.device).c_str());
+    fprintf(out, "    \"region_size\": %zu,\n", opts.size);
+    fprintf(out, "    \"page_size\": %zu,\n", host.page_size);
+    fprintf(out, "    \"memory_node\": %d,\n", host.memory_node);
+    fprintf(out, "    \"copy_kernel\": %s,\n", json_string(host.copy_kernel).c_str());
+    fprintf(out, "    \"cache_mode\": %s,\n", json_string(host.cache_mode).c_str());
+    fprintf(out, "    \"backend\": %s,\n", json_string(host.backend).c_str());
+    fprintf(out, "    \"sim_model\": %s\n  },\n",
+            host.sim_model ? ("{\"latency_ns\": " + json_number(host.sim_latency_ns, "%.1f") +
+                              ", \"bandwidth_gbps\": " + json_number(host.sim_bandwidth_gbps, "%.2f") + "}").c_str()
+                           : "null");
+    fprintf(out, "  \"units\": {\"gbps\": \"GiB/s\", \"latency\": \"ns\", \"block_size\": \"bytes\"},\n");
+    fprintf(out, "  \"records\": [\n");
+    for (size_t i = 0; i < records.size(); i++) {
+        const BenchRecord& r = records[i];
+        fprintf(out, "    {\"test\": %s, \"target\": %s, \"op\": %s, \"pattern\": %s, "
+                "\"block_size\": %zu, \"threads\": %d, \"working_set\": %zu, \"delay\": %s, \"gbps\": %s, "
+                "\"gflops\": %s, ",
+                json_string(r.test).c_str(), json_string(r.target).c_str(), json_string(r.op).c_str(),
+                json_string(r.pattern).c_str(), r.block_size, r.threads, r.working_set,
+                r.delay < 0 ? "null" : std::to_string(r.delay).c_str(),
+                json_number(r.gbps).c_str(), json_number(r.gflops).c_str());
+        if (r.has_latency) {
+            const cxl_latency_stats& l = r.latency;
+            fprintf(out, "\"latency_ns\": {\"samples\": %llu, \"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, "
+                    "\"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}, ",
+                    static_cast<unsigned long long>(l.samples), l.min_ns, l.mean_ns, l.p50_ns,
+                    l.p90_ns, l.p99_ns, l.p999_ns, l.max_ns);
+        } else {
+            fprintf(out, "\"latency_ns\": null, ");
+        }
+        fprintf(out, "\"perf\": %s}", json_perf(r).c_str());
+        fprintf(out, "%s\n", i + 1 < records.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Host metadata goes in leading "# key: value" lines
+static void write_csv(FILE* out, const BenchHost& host, const BenchOptions& opts,
+                      const std::vector<BenchRecord>& records) {
+    fprintf(out, "# hostname: %s\n# kernel: %s\n# cpu_model: %s\n# cpus: %ld\n# timestamp: %s\n"
+            "# build: %s\n# device: %s\n# region_size: %zu\n# page_size: %zu\n# copy_kernel: %s\n"
+            "# cache_mode: %s\n# backend: %s\n",
+            host.hostname.c_str(), host.kernel.c_str(), host.cpu_model.c_str(), host.cpus,
+            host.timestamp.c_str(), host.build.c_str(), opts.device.c_str(), opts.size, host.page_size,
+            host.copy_kernel.c_str(), host.cache_mode.c_str(), host.backend.c_str());
+    if (host.sim_model) {
+        fprintf(out, "# sim_model: latency_ns=%.1f bandwidth_gbps=%.2f\n", host.sim_latency_ns,
+                host.sim_bandwidth_gbps);
+    }
+    fprintf(out, "test,target,op,pattern,block_size,threads,working_set,delay,gbps,gflops,"
+            "lat_min_ns,lat_mean_ns,lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p999_ns,lat_max_ns,"
+            "perf_cycles,perf_instructions,perf_llc_misses,perf_dtlb_misses,perf_uncore\n");
+    for (const BenchRecord& r : records) {
+        fprintf(out, "%s,%s,%s,%s,%zu,%d,%zu,%s,%s,%s,", r.test.c_str(), r.target.c_str(), r.op.c_str(),
+                r.pattern.c_str(), r.block_size, r.threads, r.working_set,
+                r.delay < 0 ? "" : std::to_string(r.delay).c_str(),
+                r.gbps < 0.0 ? "" : json_number(r.gbps).c_str(),
+                r.gflops < 0.0 ? "" : json_number(r.gflops).c_str());
+        if (r.has_latency) {
+            const cxl_latency_stats& l = r.latency;
+            fprintf(out, "%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,", l.min_ns, l.mean_ns, l.p50_ns,
+                    l.p90_ns, l.p99_ns, l.p999_ns, l.max_ns);
+        } else {
+            fprintf(out, ",,,,,,,");
+        }
+        // Uncore counts as "name=count" pairs separated by ';'
+        if (r.has_perf) {
+            const cxl_perf_counters& p = r.perf;
+            std::string uncore;
+            for (int i = 0; i < p.num_uncore; i++) {
+                if (i) {
+                    uncore += ";";
+                }
+                uncore += std::string(p.uncore_name[i]) + "=" + std::to_string(p.uncore_count[i]);
+            }
+            auto count = [&p](uint32_t bit, uint64_t value) { return p.valid & bit ? std::to_string(value) : ""; };
+            fprintf(out, "%s,%s,%s,%s,%s\n", count(CXL_PERF_CYCLES, p.cycles).c_str(),
+                    count(CXL_PERF_INSTRUCTIONS, p.instructions).c_str(),
+                    count(CXL_PERF_LLC_MISSES, p.llc_misses).c_str(),
+                    count(CXL_PERF_DTLB_MISSES, p.dtlb_misses).c_str(), uncore.c_str());
+        } else {
+            fprintf(out, ",,,,\n");
+        }
+    }
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--device PATH] [--size BYTES] [--no-dram]\n"
+              << "       [--test bandwidth,pattern,latency,loaded,compute|all] [--block-sizes 4K,64K,1M] [--threads 1,2,4]\n"
+              << "       [--bytes BYTES] [--pattern-bytes BYTES] [--pattern-max-block BYTES]\n"
+              << "       [--latency-iterations N] [--perf] [--uncore-events pmu/event/;...]\n"
+              << "       [--format json|csv] [--output FILE]"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (arg == "--device" && has_value) {
+            opts.device = argv[++i];
+        } else if (arg == "--size" && has_value) {
+            ok = parse_size(argv[++i], &opts.size);
+        } else if (arg == "--no-dram") {
+            opts.dram = false;
+        } else if (arg == "--test" && has_value) {
+            opts.bandwidth = opts.latency = opts.compute = opts.pattern = opts.loaded = false;
+            for (const auto& test : split(argv[++i])) {
+                if (test == "all") {
+                    opts.bandwidth = opts.latency = opts.compute = opts.pattern = opts.loaded = true;
+                } else if (test == "bandwidth") {
+                    opts.bandwidth = true;
+                } else if (test == "pattern") {
+                    opts.pattern = true;
+                } else if (test == "latency") {
+                    opts.latency = true;
+                } else if (test == "loaded") {
+                    opts.loaded = true;
+                } else if (test == "compute") {
+                    opts.compute = true;
+                } else {
+                    ok = false;
+                }
+            }
+        } else if (arg == "--block-sizes" && has_value) {
+            opts.block_sizes.clear();
+            for (const auto& s : split(argv[++i])) {
+                size_t block;
+                ok = ok && parse_size(s, &block);
+                opts.block_sizes.push_back(ok ? block : 0);
+            }
+        } else if (arg == "--threads" && has_value) {
+            for (const auto& s : split(argv[++i])) {
+                int threads = atoi(s.c_str());
+                ok = ok && threads > 0 && threads <= CXL_MAX_BW_THREADS;
+                opts.threads.push_back(threads);
+            }
+        } else if (arg == "--bytes" && has_value) {
+            ok = parse_size(argv[++i], &opts.bytes);
+        } else if (arg == "--pattern-bytes" && has_value) {
+            ok = parse_size(argv[++i], &opts.pattern_bytes);
+        } else if (arg == "--pattern-max-block" && has_value) {
+            ok = parse_size(argv[++i], &opts.pattern_max_block);
+        } else if (arg == "--latency-iterations" && has_value) {
+            opts.latency_iterations = atoi(argv[++i]);
+            ok = opts.latency_iterations > 0;
+        } else if (arg == "--perf") {
+            opts.perf = true;
+        } else if (arg == "--uncore-events" && has_value) {
+            opts.perf = true;
+            opts.uncore_events = argv[++i];
+        } else if (arg == "--format" && has_value) {
+            opts.format = argv[++i];
+            ok = opts.format == "json" || opts.format == "csv";
+        } else if (arg == "--output" && has_value) {
+            opts.output = argv[++i];
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Default thread counts: powers of two up to the online CPUs, plus that count
+    if (opts.threads.empty()) {
+        int cpus = static_cast<int>(std::min<long>(sysconf(_SC_NPROCESSORS_ONLN), CXL_MAX_BW_THREADS));
+        for (int t = 1; t < cpus; t *= 2) {
+            opts.threads.push_back(t);
+        }
+        opts.threads.push_back(std::max(cpus, 1));
+    }
+
+    // A blank device is formatted with all of it as scratch; an existing layout is kept
+    cxl_init_options cxl_opts = { opts.size, -1, 0, 0, CXL_SCRATCH_ALL };
+    void* cxl = cxl_init_ex(opts.device.c_str(), &cxl_opts);
+    if (!cxl) {
+        std::cerr << "Failed to map " << opts.device << std::endl;
+        return 1;
+    }
+    void* dram = nullptr;
+    if (opts.dram) {
+        cxl_init_options dram_opts = { opts.size, -1, CXL_INIT_POPULATE, 0, 0 };
+        dram = cxl_init_ex(nullptr, &dram_opts);
+        if (!dram) {
+            std::cerr << "Failed to map host memory for the DRAM baseline, skipping it" << std::endl;
+        }
+    }
+
+    std::vector<BenchRecord> records;
+    struct { void* region; const char* name; } targets[] = { { cxl, "cxl" }, { dram, "dram" } };
+    for (const auto& target : targets) {
+        if (!target.region) {
+            continue;
+        }
+        if (opts.perf && cxl_perf_enable(target.region, opts.uncore_events.empty() ? nullptr
+                                                                               : opts.uncore_events.c_str()) < 0) {
+            std::cerr << "Performance counters unavailable, " << target.name << " records carry none" << std::endl;
+        }
+        if (opts.bandwidth) {
+            run_bandwidth(target.region, target.name, opts, records);
+        }
+        if (opts.pattern) {
+            run_pattern(target.region, target.name, opts, records);
+        }
+        if (opts.latency) {
+            run_latency(target.region, target.name, opts, records);
+        }
+        if (opts.loaded) {
+            run_loaded(target.region, target.name, opts, records);
+        }
+        if (opts.compute) {
+            run_compute(target.region, target.name, opts, records);
+        }
+    }
+
+    BenchHost host = collect_host(cxl);
+    FILE* out = opts.output.empty() ? stdout : fopen(opts.output.c_str(), "w");
+    int status = 0;
+    if (!out) {
+        std::cerr << "Failed to open " << opts.output << ": " << strerror(errno) << std::endl;
+        status = 1;
+    } else {
+        if (opts.format == "csv") {
+            write_csv(out, host, opts, records);
+        } else {
+            write_json(out, host, opts, records);
+        }
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+
+    if (dram) {
+        cxl_cleanup(dram);
+    }
+    cxl_cleanup(cxl);
+    return records.empty() ? 1 : status;
+}
@@ -0,0 +1,394 @@
+// STREAM (Copy/Scale/Add/Triad) against CXL memory, local DRAM and mixed
+// placements of the three arrays.
+//
+// The kernels, byte counts and validation follow McCalpin's stream.c so the
+// numbers are comparable with published STREAM results: rates are in 10^6
+// bytes per second and the first of --ntimes passes is not counted. Each
+// placement is three letters for arrays a, b and c, 'c' for the CXL device
+// and 'd' for host DRAM, so "dcc" keeps a in DRAM and b/c on the device.
+
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include "cxl_api.h"
+
+#define STREAM_DEFAULT_ELEMENTS (10UL * 1000 * 1000)
+#define STREAM_DEFAULT_NTIMES   10
+#define STREAM_SCALAR           3.0
+#define STREAM_ALIGN            (2UL << 20)
+
+enum { STREAM_COPY, STREAM_SCALE, STREAM_ADD, STREAM_TRIAD, STREAM_KERNELS };
+
+static const char* kernel_names[STREAM_KERNELS] = { "Copy", "Scale", "Add", "Triad" };
+static const int kernel_arrays[STREAM_KERNELS] = { 2, 2, 3, 3 };   // Arrays touched per element
+
+struct StreamOptions {
+    std::string device = "/tmp/cxl_sim/cxl0";
+    size_t device_size = 1UL << 30;
+    int dram_node = -1;
+    size_t elements = STREAM_DEFAULT_ELEMENTS;
+    int ntimes = STREAM_DEFAULT_NTIMES;
+    int threads = 0;
+    bool pin = false;
+    std::string format = "text";
+    std::vector<std::string> placements = { "ddd", "ccc", "dcc" };
+};
+
+struct KernelResult {
+    double best_mbps;
+    double avg_time;
+    double min_time;
+    double max_time;
+};
+
+struct PlacementResult {
+    std::string placement;
+    int threads;
+    bool valid;
+    double max_error;           // Largest relative error of the three arrays
+    KernelResult kernels[STREAM_KERNELS];
+};
+
+// CPUs to run on, from the affinity mask
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    if (cpus.empty()) {
+        cpus.push_back(0);
+    }
+    return cpus;
+}
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Compare against the values the array elements must have after ntimes passes
+static bool check_results(const double* a, const double* b, const double* c, size_t n, int ntimes,
+                          double* max_error) {
+    double aj = 1.0, bj = 2.0, cj = 0.0;
+    aj = 2.0 * aj;              // The first-touch pass below doubles a
+    for (int k = 0; k < ntimes; k++) {
+        cj = aj;
+        bj = STREAM_SCALAR * cj;
+        cj = aj + bj;
+        aj = bj + STREAM_SCALAR * cj;
+    }
+
+    double asum = 0.0, bsum = 0.0, csum = 0.0;
+    for (size_t j = 0; j < n; j++) {
+        asum += std::fabs(a[j] - aj);
+        bsum += std::fabs(b[j] - bj);
+        csum += std::fabs(c[j] - cj);
+    }
+    double errors[3] = { asum / n / std::fabs(aj), bsum / n / std::fabs(bj), csum / n / std::fabs(cj) };
+    *max_error = std::max({ errors[0], errors[1], errors[2] });
+    return *max_error <= 1.0e-13;
+}
+
+// Run every kernel ntimes over arrays already placed, splitting each array
+// statically across the workers like STREAM's OpenMP build
+static void run_stream(double* a, double* b, double* c, size_t n, const StreamOptions& opts,
+                       int threads, PlacementResult& out) {
+    std::vector<int> cpus = allowed_cpus();
+    std::vector<double> times(static_cast<size_t>(opts.ntimes) * STREAM_KERNELS);
+    std::barrier sync(threads);
+
+    auto worker = [&](int id) {
+        if (opts.pin) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[id % cpus.size()], &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+        size_t begin = n * id / threads;
+        size_t end = n * (id + 1) / threads;
+
+        // Each worker first touches its own chunk, so DRAM pages land on its node
+        for (size_t j = begin; j < end; j++) {
+            a[j] = 1.0;
+            b[j] = 2.0;
+            c[j] = 0.0;
+        }
+        for (size_t j = begin; j < end; j++) {
+            a[j] = 2.0 * a[j];
+        }
+
+        for (int k = 0; k < opts.ntimes; k++) {
+            for (int kernel = 0; kernel < STREAM_KERNELS; kernel++) {
+                sync.arrive_and_wait();
+                double start = now_seconds();
+                switch (kernel) {
+                case STREAM_COPY:
+                    for (size_t j = begin; j < end; j++) c[j] = a[j];
+                    break;
+                case STREAM_SCALE:
+                    for (size_t j = begin; j < end; j++) b[j] = STREAM_SCALAR * c[j];
+                    break;
+                case STREAM_ADD:
+                    for (size_t j = begin; j < end; j++) c[j] = a[j] + b[j];
+                    break;
+                case STREAM_TRIAD:
+                    for (size_t j = begin; j < end; j++) a[j] = b[j] + STREAM_SCALAR * c[j];
+                    break;
+                }
+                sync.arrive_and_wait();
+                if (id == 0) {
+                    times[static_cast<size_t>(k) * STREAM_KERNELS + kernel] = now_seconds() - start;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int id = 1; id < threads; id++) {
+        workers.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    for (int kernel = 0; kernel < STREAM_KERNELS; kernel++) {
+        KernelResult& r = out.kernels[kernel];
+        r.min_time = 1e30;
+        r.max_time = 0.0;
+        double total = 0.0;
+        int counted = 0;
+        for (int k = opts.ntimes > 1 ? 1 : 0; k < opts.ntimes; k++) {
+            double t = times[static_cast<size_t>(k) * STREAM_KERNELS + kernel];
+            r.min_time = std::min(r.min_time, t);
+            r.max_time = std::max(r.max_time, t);
+            total += t;
+            counted++;
+        }
+        r.avg_time = total / counted;
+        double bytes = static_cast<double>(kernel_arrays[kernel]) * sizeof(double) * n;
+        r.best_mbps = r.min_time > 0.0 ? 1.0e-6 * bytes / r.min_time : 0.0;
+    }
+    out.valid = check_results(a, b, c, n, opts.ntimes, &out.max_error);
+}
+
+static bool valid_placement(const std::string& p) {
+    return p.size() == 3 && std::all_of(p.begin(), p.end(), [](char ch) { return ch == 'c' || ch == 'd'; });
+}
+
+static void print_text(const std::vector<PlacementResult>& results, const StreamOptions& opts) {
+    std::printf("STREAM on HERMES-CXL: %zu elements per array (%.1f MiB), %d passes\n",
+                opts.elements, opts.elements * sizeof(double) / 1048576.0, opts.ntimes);
+    for (const auto& r : results) {
+        std::printf("\nPlacement %s (a=%s b=%s c=%s), %d threads\n", r.placement.c_str(),
+                    r.placement[0] == 'c' ? "cxl" : "dram", r.placement[1] == 'c' ? "cxl" : "dram",
+                    r.placement[2] == 'c' ? "cxl" : "dram", r.threads);
+        std::printf("Function    Best Rate MB/s  Avg time     Min time     Max time\n");
+        for (int kernel = 0; kernel < STREAM_KERNELS; kernel++) {
+            const KernelResult& k = r.kernels[kernel];
+            std::printf("%-8s %15.1f  %11.6f  %11.6f  %11.6f\n", kernel_names[kernel],
+                        k.best_mbps, k.avg_time, k.min_time, k.max_time);
+        }
+        std::printf("Solution %s (max relative error %.3e)\n", r.valid ? "validates" : "FAILED", r.max_error);
+    }
+}
+
+static void print_json(const std::vector<PlacementResult>& results, const StreamOptions& opts) {
+    std::printf("{\"benchmark\":\"stream\",\"elements\":%zu,\"bytes_per_element\":%zu,\"ntimes\":%d,"
+                "\"unit\":\"MB/s\",\"results\":[", opts.elements, sizeof(double), opts.ntimes);
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::printf("%s{\"placement\":\"%s\",\"threads\":%d,\"valid\":%s,\"max_error\":%.3e,\"kernels\":{",
+                    i ? "," : "", r.placement.c_str(), r.threads, r.valid ? "true" : "false", r.max_error);
+        for (int kernel = 0; kernel < STREAM_KERNELS; kernel++) {
+            const KernelResult& k = r.kernels[kernel];
+            std::printf("%s\"%s\":{\"best_mbps\":%.1f,\"avg_time\":%.6f,\"min_time\":%.6f,\"max_time\":%.6f}",
+                        kernel ? "," : "", kernel_names[kernel], k.best_mbps, k.avg_time, k.min_time, k.max_time);
+        }
+        std::printf("}}");
+    }
+    std::printf("]}\n");
+}
+
+static void print_csv(const std::vector<PlacementResult>& results, const StreamOptions& opts) {
+    std::printf("placement,threads,elements,kernel,best_mbps,avg_time,min_time,max_time,valid\n");
+    for (const auto& r : results) {
+        for (int kernel = 0; kernel < STREAM_KERNELS; kernel++) {
+            const KernelResult& k = r.kernels[kernel];
+            std::printf("%s,%d,%zu,%s,%.1f,%.6f,%.6f,%.6f,%d\n", r.placement.c_str(), r.threads, opts.elements,
+                        kernel_names[kernel], k.best_mbps, k.avg_time, k.min_time, k.max_time, r.valid ? 1 : 0);
+        }
+    }
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [--device PATH] [--device-size BYTES] [--dram-node N]\n"
+              << "       [--elements N] [--ntimes N] [--threads N] [--pin]\n"
+              << "       [--placement abc[,abc...]] [--format text|json|csv]\n"
+              << "Placements give arrays a, b and c as 'c' (CXL) or 'd' (DRAM), e.g. ccc,ddd,dcc" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    StreamOptions opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--device" && has_value) {
+            opts.device = argv[++i];
+        } else if (arg == "--device-size" && has_value) {
+            opts.device_size = strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--dram-node" && has_value) {
+            opts.dram_node = atoi(argv[++i]);
+        } else if (arg == "--elements" && has_value) {
+            opts.elements = strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--ntimes" && has_value) {
+            opts.ntimes = atoi(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            opts.threads = atoi(argv[++i]);
+        } else if (arg == "--pin") {
+            opts.pin = true;
+        } else if (arg == "--format" && has_value) {
+            opts.format = argv[++i];
+        } else if (arg == "--placement" && has_value) {
+            opts.placements.clear();
+            std::stringstream list(argv[++i]);
+            std::string p;
+            while (std::getline(list, p, ',')) {
+                opts.placements.push_back(p);
+            }
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (opts.elements == 0 || opts.ntimes < 1 || opts.threads < 0 ||
+        (opts.format != "text" && opts.format != "json" && opts.format != "csv")) {
+        usage(argv[0]);
+        return 1;
+    }
+    bool need_cxl = false;
+    bool need_dram = false;
+    for (const auto& p : opts.placements) {
+        if (!valid_placement(p)) {
+            std::cerr << "Invalid placement '" << p << "'" << std::endl;
+            usage(argv[0]);
+            return 1;
+        }
+        need_cxl |= p.find('c') != std::string::npos;
+        need_dram |= p.find('d') != std::string::npos;
+    }
+
+    int threads = opts.threads ? opts.threads : static_cast<int>(allowed_cpus().size());
+    size_t array_bytes = opts.elements * sizeof(double);
+    size_t stride = (array_bytes + STREAM_ALIGN - 1) & ~(STREAM_ALIGN - 1);
+
+    // Both tiers come from libcxl: the device region and an anonymous host
+    // region of the same shape, so every array is page aligned and populated
+    // the same way no matter where it lives
+    void* cxl = nullptr;
+    void* dram = nullptr;
+    if (need_cxl) {
+        cxl = cxl_init(opts.device.c_str(), opts.device_size);
+        if (!cxl) {
+            std::cerr << "Failed to map " << opts.device << std::endl;
+            return 1;
+        }
+    }
+    if (need_dram) {
+        // Room for all three arrays in one buddy block
+        size_t dram_size = 1UL << 21;
+        while (dram_size < 3 * stride) {
+            dram_size <<= 1;
+        }
+        cxl_init_options dram_opts = { dram_size, opts.dram_node, 0, 0, 0 };
+        dram = cxl_init_ex(nullptr, &dram_opts);
+        if (!dram) {
+            std::cerr << "Failed to map " << dram_size << " bytes of host memory" << std::endl;
+            if (cxl) {
+                cxl_cleanup(cxl);
+            }
+            return 1;
+        }
+    }
+
+    std::vector<PlacementResult> results;
+    int status = 0;
+    for (const auto& p : opts.placements) {
+        // One allocation per tier, sliced into that tier's arrays, since the
+        // allocator rounds each block up to a power of two
+        double* arrays[3] = { nullptr, nullptr, nullptr };
+        char* blocks[2] = { nullptr, nullptr };
+        void* owners[2] = { cxl, dram };
+        const char tiers[2] = { 'c', 'd' };
+        bool placed = true;
+        for (int t = 0; t < 2 && placed; t++) {
+            size_t count = std::count(p.begin(), p.end(), tiers[t]);
+            if (count == 0) {
+                continue;
+            }
+            blocks[t] = static_cast<char*>(cxl_alloc(owners[t], count * stride, STREAM_ALIGN));
+            if (!blocks[t]) {
+                std::cerr << "Placement " << p << ": no room for " << count << " arrays of " << array_bytes
+                          << " bytes in " << (t == 0 ? opts.device : std::string("host memory")) << std::endl;
+                placed = false;
+                break;
+            }
+            size_t slice = 0;
+            for (int i = 0; i < 3; i++) {
+                if (p[i] == tiers[t]) {
+                    arrays[i] = reinterpret_cast<double*>(blocks[t] + stride * slice++);
+                }
+            }
+        }
+
+        if (placed) {
+            PlacementResult r;
+            r.placement = p;
+            r.threads = threads;
+            run_stream(arrays[0], arrays[1], arrays[2], opts.elements, opts, threads, r);
+            if (!r.valid) {
+                status = 1;
+            }
+            results.push_back(r);
+        } else {
+            status = 1;
+        }
+
+        for (int t = 0; t < 2; t++) {
+            if (blocks[t]) {
+                cxl_free(owners[t], blocks[t]);
+            }
+        }
+    }
+
+    if (opts.format == "json") {
+        print_json(results, opts);
+    } else if (opts.format == "csv") {
+        print_csv(results, opts);
+    } else {
+        print_text(results, opts);
+    }
+
+    if (cxl) {
+        cxl_cleanup(cxl);
+    }
+    if (dram) {
+        cxl_cleanup(dram);
+    }
+    return status;
+}
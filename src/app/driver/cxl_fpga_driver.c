@@ -12,6 +12,16 @@
 #include <linux/mm.h>
 #include <linux/dma-mapping.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/iopoll.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/huge_mm.h>
+#include <linux/pfn_t.h>
+#include <linux/scatterlist.h>
+#include <linux/math64.h>
+
+#include "cxl_common.h"
 
 #define DRIVER_NAME "cxl_fpga"
 #define DRIVER_DESC "CXL FPGA Shared Memory Driver"
@@ -27,12 +37,121 @@
 #define REG_LENGTH         0x14
 #define REG_MEMBASE_LOW    0x18
 #define REG_MEMBASE_HIGH   0x1C
+#define REG_DATA_LOW       0x20
+#define REG_DATA_HIGH      0x24
+#define REG_CAPS           0x28
+
+// REG_STATUS bits
+#define STATUS_BUSY        BIT(0)          // Executing queued commands
+#define STATUS_QUEUE_FULL  BIT(1)          // Command queue cannot take another entry
+#define STATUS_ERROR       BIT(2)          // Last batch failed
+#define STATUS_IRQ         BIT(3)          // Batch-complete interrupt pending (write 1 to clear)
+
+// REG_CAPS bits
+#define CAP_DESC_CHAIN     BIT(0)          // Walks descriptor chains in host memory
+
+// REG_CONTROL bits
+#define CTRL_DOORBELL      BIT(0)          // Start executing everything queued
+#define CTRL_IRQ_ENABLE    BIT(1)          // Raise an interrupt when a batch retires
+
+// Command the driver programs for a descriptor chain: REG_ADDR is the bus
+// address of the first descriptor and REG_LENGTH the number of descriptors.
+// The FPGA fetches and runs them in order, following next, as one queue entry.
+#define FPGA_CMD_DESC_CHAIN  0x80
+
+struct cxl_fpga_desc {
+    __le64 src;                      // Device offset, or bus address with DESC_SRC_HOST
+    __le64 dst;                      // Device offset, or bus address with DESC_DST_HOST
+    __le32 length;
+    __le32 control;                  // DESC_*
+    __le64 next;                     // Bus address of the following descriptor
+};
+
+#define DESC_SRC_HOST      BIT(0)
+#define DESC_DST_HOST      BIT(1)
+#define DESC_LAST          BIT(2)          // next is ignored
+
+// Chains are built in page-sized coherent blocks linked through next
+#define DESC_PER_BLOCK     (PAGE_SIZE / sizeof(struct cxl_fpga_desc))
+
+// Dispatcher tuning
+#define CMD_BATCH_MAX      32              // Commands programmed per doorbell
+#define CMD_TIMEOUT_US     1000000         // Upper bound on one batch
+
+// Completion modes
+#define COMPLETION_ADAPTIVE  0               // Spin for short batches, sleep on the interrupt otherwise
+#define COMPLETION_IRQ       1               // Always sleep on the interrupt
+#define COMPLETION_POLL      2               // Always poll REG_STATUS
+
+static int completion_mode = COMPLETION_ADAPTIVE;
+module_param(completion_mode, int, 0644);
+MODULE_PARM_DESC(completion_mode, "Batch completion: 0=adaptive, 1=interrupt, 2=poll");
+
+static unsigned int poll_threshold_ns = 20000;
+module_param(poll_threshold_ns, uint, 0644);
+MODULE_PARM_DESC(poll_threshold_ns, "Adaptive mode spins when the average batch is shorter than this");
 
-// Command definitions
-#define CMD_NOP            0x00
-#define CMD_MEM_COPY       0x01
-#define CMD_MEM_FILL       0x02
-#define CMD_ACCELERATE     0x03
+static bool huge_mappings = true;
+module_param(huge_mappings, bool, 0644);
+MODULE_PARM_DESC(huge_mappings, "Map shared memory with 2MB/1GB entries on fault instead of 4K PTEs up front");
+
+// Every process has to map the memory with the same attributes, so this is fixed at load time
+static int cache_mode = CXL_MEM_CACHE_UNCACHED;
+module_param(cache_mode, int, 0444);
+MODULE_PARM_DESC(cache_mode, "Shared memory mapping: 0=uncached, 1=write-combining, 2=write-back");
+
+// PCI BARs
+#define BAR_MMIO           0
+#define BAR_SHARED_MEM     2
+
+#define CMD_SLOT(id)       ((id) & (CXL_RING_ENTRIES - 1))
+
+struct cxl_fpga_desc_block {
+    struct cxl_fpga_desc *desc;
+    dma_addr_t dma;
+};
+
+// A host buffer pinned and mapped for one CMD_MEM_COPY, and the chain that covers it
+struct cxl_fpga_chain {
+    struct list_head list;           // On stale_chains after a timed-out batch
+    struct page **pages;
+    unsigned long npages;
+    struct sg_table sgt;
+    enum dma_data_direction dir;
+    struct cxl_fpga_desc_block *blocks;
+    unsigned int nblocks;
+    u32 count;                       // Descriptors in the chain
+};
+
+// Counters behind the stats/ sysfs directory; updated under cmd_lock
+struct cxl_fpga_stats {
+    u64 submitted;                   // Commands accepted or rejected
+    u64 completed;                   // Finished successfully
+    u64 failed;                      // Rejected at submission or finished with an error
+    u64 depth;                       // Queued or executing now
+    u64 doorbells;                   // Batches started
+    u64 latency_count;               // Commands that were queued and have finished
+    u64 latency_total_ns;            // Queueing to completion, over those commands
+    u64 latency_max_ns;
+    u64 bytes[CMD_ACCELERATE + 1];   // Moved by completed commands, per opcode
+};
+
+struct cxl_fpga_cmd {
+    struct list_head list;
+    uint32_t id;
+    uint32_t opcode;
+    uint64_t address;
+    uint64_t data;
+    uint32_t length;
+    uint32_t flags;
+    uint32_t status;
+    uint64_t result;
+    bool in_use;                     // Slot holds a live command
+    bool from_ring;                  // Complete through the CQ instead of QUERY
+    struct cxl_fpga_chain *chain;    // Host buffer of a CXL_CMD_FLAG_HOST_VA copy
+    u64 queued_ns;                   // When the command was queued, for the latency counters
+    struct completion done;
+};
 
 struct cxl_fpga_device {
     struct pci_dev *pdev;
@@ -47,26 +166,31 @@ struct cxl_fpga_device {
     
     struct mutex dev_mutex;          // Protects device access
     struct list_head cmd_list;       // List of pending commands
-    spinlock_t cmd_lock;             // Protects command list
+    spinlock_t cmd_lock;             // Protects command list and table
     
     struct workqueue_struct *wq;     // Workqueue for command processing
-};
-
-struct cxl_fpga_cmd {
-    struct list_head list;
-    uint32_t id;
-    uint32_t opcode;
-    uint64_t address;
-    uint64_t data;
-    uint32_t status;
-    uint64_t result;
-    struct completion done;
+    struct work_struct cmd_work;     // Drains cmd_list in batches
+    
+    int irq;                         // MSI-X/MSI vector, or -1 when polling only
+    struct completion batch_done;    // Signalled by the batch-complete interrupt
+    u64 avg_batch_ns;                // Moving average of batch latency
+    bool desc_chain;                 // FPGA walks descriptor chains (REG_CAPS)
+    struct list_head stale_chains;   // Chains the FPGA may still be reading; freed on remove
+    struct cxl_fpga_stats stats;
+    
+    // Commands are preallocated and indexed by id, so submission never allocates
+    struct cxl_fpga_cmd cmd_table[CXL_RING_ENTRIES];
+    
+    struct cxl_ring *ring;           // Submission/completion ring (vmalloc_user)
+    struct file *ring_owner;         // File that set up the ring
+    u32 ring_inflight;               // Ring commands without a posted CQE
 };
 
 // Global variables
 static struct class *cxl_fpga_class;
-static struct cxl_fpga_device *devices[MAX_DEVICES];
-static int device_count = 0;
+static struct cxl_fpga_device *devices[MAX_DEVICES];   // Indexed by minor
+static DEFINE_MUTEX(devices_lock);
+static dev_t cxl_fpga_devt;
 
 // PCI IDs for supported devices (example values, would be real vendor/device IDs)
 static const struct pci_device_id cxl_fpga_ids[] = {
@@ -94,10 +218,456 @@ static inline bool fpga_is_idle(struct cxl_fpga_device *dev)
     return (status & 0x1) == 0;
 }
 
+// Post a completion to the CQ; space was reserved when the SQE was consumed
+static void cxl_fpga_post_cqe(struct cxl_fpga_device *dev, struct cxl_fpga_cmd *cmd)
+{
+    struct cxl_ring *ring = dev->ring;
+    u32 tail = ring->cq.tail;
+    struct cxl_ring_cqe *cqe = &ring->cqes[tail & (CXL_RING_ENTRIES - 1)];
+    
+    cqe->id = cmd->id;
+    cqe->status = cmd->status;
+    cqe->result = cmd->result;
+    
+    // Publish the entry before the new tail
+    smp_store_release(&ring->cq.tail, tail + 1);
+    dev->ring_inflight--;
+}
+
+// Count a command that failed before it was queued; called with cmd_lock held
+static void cxl_fpga_count_rejected(struct cxl_fpga_device *dev)
+{
+    dev->stats.submitted++;
+    dev->stats.failed++;
+}
+
+// Finish a command; called with cmd_lock held
+static void cxl_fpga_complete_cmd(struct cxl_fpga_device *dev, struct cxl_fpga_cmd *cmd,
+                                  u32 status, u64 result)
+{
+    u64 latency = ktime_get_ns() - cmd->queued_ns;
+    
+    dev->stats.depth--;
+    dev->stats.latency_count++;
+    dev->stats.latency_total_ns += latency;
+    dev->stats.latency_max_ns = max(dev->stats.latency_max_ns, latency);
+    if (status == CXL_CMD_STATUS_COMPLETED) {
+        dev->stats.completed++;
+        if (cmd->opcode <= CMD_ACCELERATE) {
+            dev->stats.bytes[cmd->opcode] += cmd->length;
+        }
+    } else {
+        dev->stats.failed++;
+    }
+    
+    cmd->status = status;
+    cmd->result = result;
+    complete_all(&cmd->done);
+    
+    // Ring commands release their slot as soon as the CQE is visible;
+    // ioctl commands keep it until CXL_MEM_QUERY_CMD collects the status
+    if (cmd->from_ring) {
+        cxl_fpga_post_cqe(dev, cmd);
+        cmd->in_use = false;
+    }
+}
+
+static bool cxl_fpga_in_bounds(struct cxl_fpga_device *dev, u64 offset, u32 length)
+{
+    return offset <= dev->shared_mem_size && length <= dev->shared_mem_size - offset;
+}
+
+// Reject commands the device cannot run as submitted. Offsets go to the FPGA
+// unchecked, so every range it would touch has to lie in shared memory.
+static int cxl_fpga_check_cmd(struct cxl_fpga_device *dev, const struct cxl_ring_sqe *sqe)
+{
+    if (sqe->flags & CXL_CMD_FLAG_HOST_VA) {
+        // Host buffers only take part in copies, through a descriptor chain
+        if (!dev->desc_chain) {
+            return -EOPNOTSUPP;
+        }
+        if (sqe->opcode != CMD_MEM_COPY || !sqe->length || !cxl_fpga_in_bounds(dev, sqe->address, sqe->length)) {
+            return -EINVAL;
+        }
+        return 0;
+    }
+    
+    switch (sqe->opcode) {
+        case CMD_NOP:
+            return 0;
+        case CMD_MEM_COPY:
+            if (!cxl_fpga_in_bounds(dev, sqe->data, sqe->length)) {
+                return -EINVAL;
+            }
+            fallthrough;
+        case CMD_MEM_FILL:
+        case CMD_ACCELERATE:
+            return cxl_fpga_in_bounds(dev, sqe->address, sqe->length) ? 0 : -EINVAL;
+        default:
+            // Including the chain opcode, which would point the FPGA at arbitrary DMA addresses
+            return -EINVAL;
+    }
+}
+
+// Unmap and unpin a host buffer and free its chain; may sleep
+static void cxl_fpga_release_chain(struct cxl_fpga_device *dev, struct cxl_fpga_chain *chain)
+{
+    unsigned int i;
+    
+    for (i = 0; i < chain->nblocks; i++) {
+        dma_free_coherent(&dev->pdev->dev, PAGE_SIZE, chain->blocks[i].desc, chain->blocks[i].dma);
+    }
+    kfree(chain->blocks);
+    if (chain->sgt.sgl) {
+        if (chain->count) {
+            dma_unmap_sgtable(&dev->pdev->dev, &chain->sgt, chain->dir, 0);
+        }
+        sg_free_table(&chain->sgt);
+    }
+    // Pages the device wrote have to reach the page cache or swap
+    unpin_user_pages_dirty_lock(chain->pages, chain->npages, chain->dir == DMA_FROM_DEVICE);
+    kvfree(chain->pages);
+    kfree(chain);
+}
+
+// Pin the submitter's buffer of a CXL_CMD_FLAG_HOST_VA copy and describe it as
+// one descriptor per DMA segment, so the whole copy takes a single queue entry
+// and any number of pages need no bounce buffer. Runs in the submitter's
+// context without cmd_lock, as pinning may fault pages in.
+static int cxl_fpga_map_host(struct cxl_fpga_device *dev, const struct cxl_ring_sqe *sqe,
+                             struct cxl_fpga_chain **out)
+{
+    bool to_host = sqe->flags & CXL_CMD_FLAG_TO_HOST;
+    unsigned long start = sqe->data;
+    unsigned long first = start & PAGE_MASK;
+    unsigned long npages = (PAGE_ALIGN(start + sqe->length) - first) >> PAGE_SHIFT;
+    struct cxl_fpga_chain *chain;
+    struct scatterlist *sg;
+    u64 device = sqe->address;
+    unsigned int nblocks, i;
+    int pinned, ret;
+    
+    if (start + sqe->length < start) {
+        return -EFAULT;
+    }
+    
+    chain = kzalloc(sizeof(*chain), GFP_KERNEL);
+    if (!chain) {
+        return -ENOMEM;
+    }
+    chain->dir = to_host ? DMA_FROM_DEVICE : DMA_TO_DEVICE;
+    chain->pages = kvmalloc_array(npages, sizeof(*chain->pages), GFP_KERNEL);
+    if (!chain->pages) {
+        kfree(chain);
+        return -ENOMEM;
+    }
+    
+    pinned = pin_user_pages_fast(first, npages, to_host ? FOLL_WRITE : 0, chain->pages);
+    if (pinned < 0) {
+        kvfree(chain->pages);
+        kfree(chain);
+        return pinned;
+    }
+    chain->npages = pinned;
+    if (pinned != npages) {
+        ret = -EFAULT;
+        goto err;
+    }
+    
+    ret = sg_alloc_table_from_pages(&chain->sgt, chain->pages, npages, offset_in_page(start),
+                                    sqe->length, GFP_KERNEL);
+    if (ret) {
+        goto err;
+    }
+    ret = dma_map_sgtable(&dev->pdev->dev, &chain->sgt, chain->dir, 0);
+    if (ret) {
+        goto err;
+    }
+    chain->count = chain->sgt.nents;
+    
+    // nblocks counts only blocks allocated so far, so release_chain frees just those
+    nblocks = DIV_ROUND_UP(chain->count, DESC_PER_BLOCK);
+    chain->blocks = kcalloc(nblocks, sizeof(*chain->blocks), GFP_KERNEL);
+    if (!chain->blocks) {
+        ret = -ENOMEM;
+        goto err;
+    }
+    for (i = 0; i < nblocks; i++) {
+        chain->blocks[i].desc = dma_alloc_coherent(&dev->pdev->dev, PAGE_SIZE, &chain->blocks[i].dma,
+                                                   GFP_KERNEL);
+        if (!chain->blocks[i].desc) {
+            ret = -ENOMEM;
+            goto err;
+        }
+        chain->nblocks = i + 1;
+    }
+    
+    // Fill the chain, each descriptor pointing at the next in its block or the following block
+    for_each_sgtable_dma_sg(&chain->sgt, sg, i) {
+        struct cxl_fpga_desc *desc = &chain->blocks[i / DESC_PER_BLOCK].desc[i % DESC_PER_BLOCK];
+        unsigned int n = i + 1;
+        u64 host = sg_dma_address(sg);
+        
+        desc->src = cpu_to_le64(to_host ? device : host);
+        desc->dst = cpu_to_le64(to_host ? host : device);
+        desc->length = cpu_to_le32(sg_dma_len(sg));
+        desc->control = cpu_to_le32((to_host ? DESC_DST_HOST : DESC_SRC_HOST) |
+                                    (n == chain->count ? DESC_LAST : 0));
+        desc->next = cpu_to_le64(n == chain->count ? 0 : chain->blocks[n / DESC_PER_BLOCK].dma +
+                                                          (n % DESC_PER_BLOCK) * sizeof(*desc));
+        device += sg_dma_len(sg);
+    }
+    
+    *out = chain;
+    return 0;
+    
+err:
+    cxl_fpga_release_chain(dev, chain);
+    return ret;
+}
+
+// Claim the table slot for a command id and queue it; called with cmd_lock held
+static struct cxl_fpga_cmd *cxl_fpga_queue_cmd(struct cxl_fpga_device *dev,
+                                               const struct cxl_ring_sqe *sqe,
+                                               struct cxl_fpga_chain *chain,
+                                               bool from_ring)
+{
+    struct cxl_fpga_cmd *cmd = &dev->cmd_table[CMD_SLOT(sqe->id)];
+    
+    if (cmd->in_use) {
+        return NULL;
+    }
+    
+    cmd->id = sqe->id;
+    cmd->opcode = sqe->opcode;
+    cmd->address = sqe->address;
+    cmd->data = sqe->data;
+    cmd->length = sqe->length;
+    cmd->flags = sqe->flags;
+    cmd->status = CXL_CMD_STATUS_ACTIVE;
+    cmd->result = 0;
+    cmd->in_use = true;
+    cmd->from_ring = from_ring;
+    cmd->chain = chain;
+    cmd->queued_ns = ktime_get_ns();
+    reinit_completion(&cmd->done);
+    
+    dev->stats.submitted++;
+    dev->stats.depth++;
+    
+    list_add_tail(&cmd->list, &dev->cmd_list);
+    return cmd;
+}
+
+// Load one command into the FPGA's command queue
+static void cxl_fpga_program_cmd(struct cxl_fpga_device *dev, struct cxl_fpga_cmd *cmd)
+{
+    if (cmd->chain) {
+        dma_addr_t head = cmd->chain->blocks[0].dma;
+        
+        fpga_write32(dev, REG_ADDR_LOW, lower_32_bits(head));
+        fpga_write32(dev, REG_ADDR_HIGH, upper_32_bits(head));
+        fpga_write32(dev, REG_DATA_LOW, 0);
+        fpga_write32(dev, REG_DATA_HIGH, 0);
+        fpga_write32(dev, REG_LENGTH, cmd->chain->count);
+        fpga_write32(dev, REG_COMMAND, FPGA_CMD_DESC_CHAIN);
+        return;
+    }
+    
+    fpga_write32(dev, REG_ADDR_LOW, lower_32_bits(cmd->address));
+    fpga_write32(dev, REG_ADDR_HIGH, upper_32_bits(cmd->address));
+    fpga_write32(dev, REG_DATA_LOW, lower_32_bits(cmd->data));
+    fpga_write32(dev, REG_DATA_HIGH, upper_32_bits(cmd->data));
+    fpga_write32(dev, REG_LENGTH, cmd->length);
+    fpga_write32(dev, REG_COMMAND, cmd->opcode);
+}
+
+// Wait for the FPGA to finish everything behind the last doorbell
+static int cxl_fpga_wait_batch(struct cxl_fpga_device *dev, u32 *status)
+{
+    return readl_poll_timeout(dev->mmio_base + REG_STATUS, *status,
+                              !(*status & STATUS_BUSY), 1, CMD_TIMEOUT_US);
+}
+
+// Wait for a batch that was started by a doorbell
+//
+// Short batches finish before an interrupt could even be delivered, so in
+// adaptive mode we busy-poll REG_STATUS for up to twice the average batch
+// time and only fall back to sleeping on the interrupt when that runs out.
+static int cxl_fpga_wait_doorbell(struct cxl_fpga_device *dev, u32 *status)
+{
+    ktime_t start = ktime_get();
+    int mode = completion_mode;
+    int ret = 0;
+    u64 elapsed;
+    
+    if (dev->irq < 0) {
+        mode = COMPLETION_POLL;
+    }
+    
+    if (mode == COMPLETION_ADAPTIVE && dev->avg_batch_ns < poll_threshold_ns) {
+        u64 budget = max_t(u64, 2 * dev->avg_batch_ns, 1000);
+        
+        do {
+            *status = fpga_read32(dev, REG_STATUS);
+            if (!(*status & STATUS_BUSY)) {
+                goto done;
+            }
+            cpu_relax();
+        } while (ktime_to_ns(ktime_sub(ktime_get(), start)) < budget);
+    }
+    
+    if (mode == COMPLETION_POLL) {
+        ret = cxl_fpga_wait_batch(dev, status);
+    } else {
+        unsigned long deadline = jiffies + usecs_to_jiffies(CMD_TIMEOUT_US);
+        
+        // A late interrupt from a batch the spin above already saw retire can
+        // complete batch_done early, so only an idle REG_STATUS ends the wait
+        for (;;) {
+            long left = (long)(deadline - jiffies);
+            
+            if (left <= 0 || !wait_for_completion_timeout(&dev->batch_done, left)) {
+                *status = fpga_read32(dev, REG_STATUS);
+                ret = (*status & STATUS_BUSY) ? -ETIMEDOUT : 0;
+                break;
+            }
+            *status = fpga_read32(dev, REG_STATUS);
+            if (!(*status & STATUS_BUSY)) {
+                break;
+            }
+            reinit_completion(&dev->batch_done);
+            // The batch may have retired, and its interrupt been taken, before the reinit
+            *status = fpga_read32(dev, REG_STATUS);
+            if (!(*status & STATUS_BUSY)) {
+                break;
+            }
+        }
+    }
+    
+done:
+    elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+    dev->avg_batch_ns = (7 * dev->avg_batch_ns + elapsed) / 8;
+    return ret;
+}
+
+// Batch-complete interrupt
+static irqreturn_t cxl_fpga_irq(int irq, void *data)
+{
+    struct cxl_fpga_device *dev = data;
+    u32 status = fpga_read32(dev, REG_STATUS);
+    
+    if (!(status & STATUS_IRQ)) {
+        return IRQ_NONE;
+    }
+    
+    fpga_write32(dev, REG_STATUS, STATUS_IRQ);
+    complete(&dev->batch_done);
+    return IRQ_HANDLED;
+}
+
 // Command execution work function
+//
+// Takes up to CMD_BATCH_MAX pending commands at a time, programs them
+// back-to-back into the FPGA queue, rings the doorbell once for the whole
+// batch and completes the batch under a single lock hold.
 static void cxl_fpga_cmd_work(struct work_struct *work)
 {
-    // Implementation would handle command execution and completion
+    struct cxl_fpga_device *dev = container_of(work, struct cxl_fpga_device, cmd_work);
+    struct cxl_fpga_cmd *batch[CMD_BATCH_MAX];
+    
+    for (;;) {
+        LIST_HEAD(leftover);
+        u32 status = 0, cmd_status;
+        int taken = 0, programmed = 0, i, ret = 0;
+        bool rang = false;
+        
+        spin_lock(&dev->cmd_lock);
+        while (taken < CMD_BATCH_MAX && !list_empty(&dev->cmd_list)) {
+            batch[taken] = list_first_entry(&dev->cmd_list, struct cxl_fpga_cmd, list);
+            list_del_init(&batch[taken]->list);
+            taken++;
+        }
+        spin_unlock(&dev->cmd_lock);
+        
+        if (!taken) {
+            break;
+        }
+        
+        // The previous doorbell has been waited for, but the FPGA may still be
+        // finishing work started by someone else (e.g. after a reset)
+        if (!fpga_is_idle(dev)) {
+            ret = cxl_fpga_wait_batch(dev, &status);
+            status = 0;
+        }
+        
+        for (i = 0; i < taken && !ret; i++) {
+            if (batch[i]->opcode == CMD_NOP) {
+                continue;
+            }
+            // An idle FPGA always takes the first command of a batch
+            if (programmed && (fpga_read32(dev, REG_STATUS) & STATUS_QUEUE_FULL)) {
+                break;
+            }
+            cxl_fpga_program_cmd(dev, batch[i]);
+            programmed++;
+        }
+        
+        // Commands that didn't fit go back to the front of the queue in order
+        if (!ret && i < taken) {
+            int fitted = i;
+            
+            for (; i < taken; i++) {
+                list_add_tail(&batch[i]->list, &leftover);
+            }
+            taken = fitted;
+            spin_lock(&dev->cmd_lock);
+            list_splice(&leftover, &dev->cmd_list);
+            spin_unlock(&dev->cmd_lock);
+        }
+        
+        // One doorbell for the whole batch
+        if (!ret && programmed) {
+            // Drop an interrupt still pending from a batch that was reaped by spinning
+            fpga_write32(dev, REG_STATUS, STATUS_IRQ);
+            reinit_completion(&dev->batch_done);
+            fpga_write32(dev, REG_CONTROL, dev->irq >= 0 ? CTRL_DOORBELL | CTRL_IRQ_ENABLE
+                                                         : CTRL_DOORBELL);
+            rang = true;
+            ret = cxl_fpga_wait_doorbell(dev, &status);
+        }
+        
+        // Unpin host buffers before their commands complete. After a timeout the
+        // FPGA may still be walking the chains, so they are kept until remove.
+        for (i = 0; i < taken; i++) {
+            struct cxl_fpga_chain *chain = batch[i]->chain;
+            
+            if (!chain) {
+                continue;
+            }
+            batch[i]->chain = NULL;
+            if (rang && ret) {
+                spin_lock(&dev->cmd_lock);
+                list_add_tail(&chain->list, &dev->stale_chains);
+                spin_unlock(&dev->cmd_lock);
+            } else {
+                cxl_fpga_release_chain(dev, chain);
+            }
+        }
+        
+        cmd_status = (ret || (status & STATUS_ERROR)) ? CXL_CMD_STATUS_ERROR
+                                                     : CXL_CMD_STATUS_COMPLETED;
+        
+        spin_lock(&dev->cmd_lock);
+        if (rang) {
+            dev->stats.doorbells++;
+        }
+        for (i = 0; i < taken; i++) {
+            cxl_fpga_complete_cmd(dev, batch[i], cmd_status,
+                                  ret ? (u64)ret : batch[i]->length);
+        }
+        spin_unlock(&dev->cmd_lock);
+    }
 }
 
 // Open device file operation
@@ -114,16 +684,130 @@ static int cxl_fpga_open(struct inode *inode, struct file *file)
 // Close device file operation
 static int cxl_fpga_release(struct inode *inode, struct file *file)
 {
+    struct cxl_fpga_device *dev = file->private_data;
+    
+    // In-flight ring commands still complete into the ring; a new owner
+    // can take it over once they have drained
+    mutex_lock(&dev->dev_mutex);
+    if (dev->ring_owner == file) {
+        dev->ring_owner = NULL;
+    }
+    mutex_unlock(&dev->dev_mutex);
+    
     return 0;
 }
 
+// Map the submission/completion ring
+static int cxl_fpga_mmap_ring(struct cxl_fpga_device *dev, struct vm_area_struct *vma)
+{
+    unsigned long size = vma->vm_end - vma->vm_start;
+    int ret;
+    
+    mutex_lock(&dev->dev_mutex);
+    if (!dev->ring) {
+        ret = -ENXIO;
+    } else if (size > PAGE_ALIGN(sizeof(struct cxl_ring))) {
+        ret = -EINVAL;
+    } else {
+        ret = remap_vmalloc_range(vma, dev->ring, 0);
+    }
+    mutex_unlock(&dev->dev_mutex);
+    
+    return ret;
+}
+
 // Memory mapping operation
+// Physical address behind a user address in a shared memory mapping
+static phys_addr_t cxl_fpga_vma_phys(struct vm_area_struct *vma, unsigned long addr)
+{
+    struct cxl_fpga_device *dev = vma->vm_private_data;
+    
+    return dev->shared_mem_phys + (vma->vm_pgoff << PAGE_SHIFT) + (addr - vma->vm_start);
+}
+
+static vm_fault_t cxl_fpga_vm_fault(struct vm_fault *vmf)
+{
+    struct vm_area_struct *vma = vmf->vma;
+    
+    return vmf_insert_pfn(vma, vmf->address,
+                          PHYS_PFN(cxl_fpga_vma_phys(vma, vmf->address & PAGE_MASK)));
+}
+
+// Insert one leaf entry of the given size if both the user and physical ranges line up
+static vm_fault_t cxl_fpga_vm_huge_fault(struct vm_fault *vmf, enum page_entry_size pe_size)
+{
+    struct vm_area_struct *vma = vmf->vma;
+    bool write = vmf->flags & FAULT_FLAG_WRITE;
+    unsigned long size, addr;
+    phys_addr_t phys;
+    
+    switch (pe_size) {
+    case PE_SIZE_PMD:
+        size = PMD_SIZE;
+        break;
+#ifdef CONFIG_HAVE_ARCH_TRANSPARENT_HUGEPAGE_PUD
+    case PE_SIZE_PUD:
+        size = PUD_SIZE;
+        break;
+#endif
+    default:
+        return VM_FAULT_FALLBACK;
+    }
+    
+    addr = vmf->address & ~(size - 1);
+    if (addr < vma->vm_start || addr + size > vma->vm_end) {
+        return VM_FAULT_FALLBACK;
+    }
+    phys = cxl_fpga_vma_phys(vma, addr);
+    if (!IS_ALIGNED(phys, size)) {
+        return VM_FAULT_FALLBACK;
+    }
+    
+#ifdef CONFIG_HAVE_ARCH_TRANSPARENT_HUGEPAGE_PUD
+    if (pe_size == PE_SIZE_PUD) {
+        return vmf_insert_pfn_pud(vmf, phys_to_pfn_t(phys, PFN_DEV), write);
+    }
+#endif
+    return vmf_insert_pfn_pmd(vmf, phys_to_pfn_t(phys, PFN_DEV), write);
+}
+
+static const struct vm_operations_struct cxl_fpga_vm_ops = {
+    .fault = cxl_fpga_vm_fault,
+    .huge_fault = cxl_fpga_vm_huge_fault,
+};
+
+// Hand out PMD-aligned addresses so large mappings can use huge entries
+static unsigned long cxl_fpga_get_unmapped_area(struct file *file, unsigned long addr,
+                                                unsigned long len, unsigned long pgoff,
+                                                unsigned long flags)
+{
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+    if (huge_mappings && (pgoff << PAGE_SHIFT) != CXL_RING_MMAP_OFFSET) {
+        return thp_get_unmapped_area(file, addr, len, pgoff, flags);
+    }
+#endif
+    return current->mm->get_unmapped_area(file, addr, len, pgoff, flags);
+}
+
+// Mapping attributes in effect; anything unrecognised stays uncached
+static u32 cxl_fpga_cache_mode(void)
+{
+    if (cache_mode == CXL_MEM_CACHE_WRITE_COMBINING || cache_mode == CXL_MEM_CACHE_WRITE_BACK) {
+        return cache_mode;
+    }
+    return CXL_MEM_CACHE_UNCACHED;
+}
+
 static int cxl_fpga_mmap(struct file *file, struct vm_area_struct *vma)
 {
     struct cxl_fpga_device *dev = file->private_data;
     unsigned long size = vma->vm_end - vma->vm_start;
     unsigned long offset = vma->vm_pgoff << PAGE_SHIFT;
     
+    if (offset == CXL_RING_MMAP_OFFSET) {
+        return cxl_fpga_mmap_ring(dev, vma);
+    }
+    
     // Check if requested mapping is within our shared memory region
     if (offset + size > dev->shared_mem_size) {
         return -EINVAL;
@@ -131,7 +815,27 @@ static int cxl_fpga_mmap(struct file *file, struct vm_area_struct *vma)
     
     // Set up the memory mapping
     vma->vm_flags |= VM_IO | VM_PFNMAP;
-    vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+    switch (cxl_fpga_cache_mode()) {
+        case CXL_MEM_CACHE_WRITE_BACK:
+            // Cached like RAM; userspace flushes and invalidates around device access
+            break;
+        case CXL_MEM_CACHE_WRITE_COMBINING:
+            vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+            break;
+        default:
+            vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+            break;
+    }
+    
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+    // Populate on fault, in the largest entries the alignment allows
+    if (huge_mappings) {
+        vma->vm_flags |= VM_HUGEPAGE | VM_DONTEXPAND | VM_DONTDUMP;
+        vma->vm_private_data = dev;
+        vma->vm_ops = &cxl_fpga_vm_ops;
+        return 0;
+    }
+#endif
     
     // Map the memory region
     if (io_remap_pfn_range(vma, vma->vm_start,
@@ -143,6 +847,170 @@ static int cxl_fpga_mmap(struct file *file, struct vm_area_struct *vma)
     return 0;
 }
 
+// Set up (or take over) the submission/completion ring; called with dev_mutex held
+static int cxl_fpga_ring_setup(struct cxl_fpga_device *dev, struct file *file,
+                               struct cxl_ring_setup *setup)
+{
+    if (dev->ring_owner && dev->ring_owner != file) {
+        return -EBUSY;
+    }
+    
+    if (!dev->ring) {
+        dev->ring = vmalloc_user(PAGE_ALIGN(sizeof(struct cxl_ring)));
+        if (!dev->ring) {
+            return -ENOMEM;
+        }
+    } else if (dev->ring_owner != file) {
+        // Only reset indices left behind by a previous owner once it has drained
+        if (dev->ring_inflight) {
+            return -EBUSY;
+        }
+        memset(dev->ring, 0, sizeof(struct cxl_ring));
+    }
+    
+    dev->ring_owner = file;
+    
+    setup->entries = CXL_RING_ENTRIES;
+    setup->flags = 0;
+    setup->mmap_offset = CXL_RING_MMAP_OFFSET;
+    setup->mmap_size = PAGE_ALIGN(sizeof(struct cxl_ring));
+    return 0;
+}
+
+// Consume posted SQEs in one pass; called with dev_mutex held
+static int cxl_fpga_ring_enter(struct cxl_fpga_device *dev, struct file *file)
+{
+    struct cxl_ring *ring = dev->ring;
+    u32 head, tail, cq_pending;
+    int consumed = 0;
+    
+    if (!ring || dev->ring_owner != file) {
+        return -ENXIO;
+    }
+    
+    head = ring->sq.head;
+    tail = smp_load_acquire(&ring->sq.tail);
+    
+    if (tail - head > CXL_RING_ENTRIES) {
+        return -EINVAL;
+    }
+    
+    while (head != tail) {
+        struct cxl_ring_sqe sqe = ring->sqes[head & (CXL_RING_ENTRIES - 1)];
+        struct cxl_fpga_chain *chain = NULL;
+        int err;
+        
+        // Every consumed SQE owns a CQ slot until its completion is posted
+        spin_lock(&dev->cmd_lock);
+        cq_pending = ring->cq.tail - READ_ONCE(ring->cq.head);
+        if (dev->ring_inflight + cq_pending >= CXL_RING_ENTRIES) {
+            spin_unlock(&dev->cmd_lock);
+            break;
+        }
+        dev->ring_inflight++;
+        spin_unlock(&dev->cmd_lock);
+        
+        // Pinning a host buffer can sleep, so it happens outside cmd_lock
+        err = cxl_fpga_check_cmd(dev, &sqe);
+        if (!err && (sqe.flags & CXL_CMD_FLAG_HOST_VA)) {
+            err = cxl_fpga_map_host(dev, &sqe, &chain);
+        }
+        
+        spin_lock(&dev->cmd_lock);
+        if (!err && !cxl_fpga_queue_cmd(dev, &sqe, chain, true)) {
+            // Id collides with a live command
+            err = -EBUSY;
+        }
+        if (err) {
+            // Fail it straight away
+            struct cxl_fpga_cmd failed = { .id = sqe.id,
+                                           .status = err == -EBUSY ? CXL_CMD_STATUS_ERROR
+                                                                   : CXL_CMD_STATUS_INVALID,
+                                           .result = (u64)err };
+            cxl_fpga_post_cqe(dev, &failed);
+            cxl_fpga_count_rejected(dev);
+        }
+        spin_unlock(&dev->cmd_lock);
+        
+        if (err && chain) {
+            cxl_fpga_release_chain(dev, chain);
+        }
+        head++;
+        consumed++;
+    }
+    
+    smp_store_release(&ring->sq.head, head);
+    
+    // Queue work to process commands
+    if (consumed) {
+        queue_work(dev->wq, &dev->cmd_work);
+    }
+    
+    return consumed;
+}
+
+// Sleep until a command completes; runs without dev_mutex so other
+// submitters and the dispatcher keep going
+static long cxl_fpga_wait_cmd(struct cxl_fpga_device *dev, unsigned long arg)
+{
+    struct cxl_mem_wait_cmd wait;
+    struct cxl_fpga_cmd *cmd;
+    long left;
+    
+    if (copy_from_user(&wait, (void __user *)arg, sizeof(wait))) {
+        return -EFAULT;
+    }
+    
+    cmd = &dev->cmd_table[CMD_SLOT(wait.id)];
+    
+    spin_lock(&dev->cmd_lock);
+    if (cmd->id != wait.id || (!cmd->in_use && cmd->status == CXL_CMD_STATUS_ACTIVE)) {
+        spin_unlock(&dev->cmd_lock);
+        wait.status = CXL_CMD_STATUS_INVALID;
+        wait.result = 0;
+        goto out;
+    }
+    spin_unlock(&dev->cmd_lock);
+    
+    // A zero timeout polls; a finished command is collected below as usual
+    if (!wait.timeout_ms && !completion_done(&cmd->done)) {
+        wait.status = CXL_CMD_STATUS_ACTIVE;
+        wait.result = 0;
+        goto out;
+    }
+    
+    // Finished commands return at once even with a zero timeout
+    left = wait_for_completion_interruptible_timeout(&cmd->done,
+                                                     msecs_to_jiffies(wait.timeout_ms));
+    if (left < 0) {
+        return left;
+    }
+    if (left == 0) {
+        return -ETIMEDOUT;
+    }
+    
+    spin_lock(&dev->cmd_lock);
+    if (cmd->id == wait.id) {
+        wait.status = cmd->status;
+        wait.result = cmd->result;
+        
+        // Waiting collects an ioctl command just like CXL_MEM_QUERY_CMD
+        if (cmd->in_use && !cmd->from_ring) {
+            cmd->in_use = false;
+        }
+    } else {
+        wait.status = CXL_CMD_STATUS_INVALID;
+        wait.result = 0;
+    }
+    spin_unlock(&dev->cmd_lock);
+    
+out:
+    if (copy_to_user((void __user *)arg, &wait, sizeof(wait))) {
+        return -EFAULT;
+    }
+    return 0;
+}
+
 // IOCTL operation
 static long cxl_fpga_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
@@ -153,70 +1021,417 @@ static long cxl_fpga_ioctl(struct file *file, unsigned int cmd, unsigned long ar
         return -ENODEV;
     }
     
+    if (cmd == CXL_MEM_WAIT_CMD) {
+        return cxl_fpga_wait_cmd(dev, arg);
+    }
+    
     mutex_lock(&dev->dev_mutex);
     
     switch (cmd) {
         case CXL_MEM_SEND_COMMAND: {
             struct cxl_mem_command user_cmd;
-            struct cxl_fpga_cmd *fpga_cmd;
+            struct cxl_fpga_chain *chain = NULL;
+            struct cxl_ring_sqe sqe;
             
             if (copy_from_user(&user_cmd, (void __user *)arg, sizeof(user_cmd))) {
                 ret = -EFAULT;
                 break;
             }
             
-            fpga_cmd = kzalloc(sizeof(*fpga_cmd), GFP_KERNEL);
-            if (!fpga_cmd) {
-                ret = -ENOMEM;
-                break;
-            }
+            sqe.id = user_cmd.id;
+            sqe.opcode = user_cmd.opcode;
+            sqe.address = user_cmd.address;
+            sqe.data = user_cmd.data;
+            sqe.length = user_cmd.length;
+            sqe.flags = user_cmd.flags;
             
-            // Set up command
-            fpga_cmd->id = user_cmd.id;
-            fpga_cmd->opcode = user_cmd.opcode;
-            fpga_cmd->address = user_cmd.address;
-            fpga_cmd->data = user_cmd.data;
-            fpga_cmd->status = CXL_CMD_STATUS_ACTIVE;
-            init_completion(&fpga_cmd->done);
+            ret = cxl_fpga_check_cmd(dev, &sqe);
+            if (!ret && (sqe.flags & CXL_CMD_FLAG_HOST_VA)) {
+                ret = cxl_fpga_map_host(dev, &sqe, &chain);
+            }
             
-            // Add to command list
+            // Claim the command's table slot and add it to the pending list
             spin_lock(&dev->cmd_lock);
-            list_add_tail(&fpga_cmd->list, &dev->cmd_list);
+            if (!ret && !cxl_fpga_queue_cmd(dev, &sqe, chain, false)) {
+                ret = -EBUSY;
+            }
+            if (ret) {
+                cxl_fpga_count_rejected(dev);
+            }
             spin_unlock(&dev->cmd_lock);
+            if (ret && chain) {
+                cxl_fpga_release_chain(dev, chain);
+            }
             
             // Queue work to process command
-            // queue_work(dev->wq, &dev->cmd_work);
+            if (!ret) {
+                queue_work(dev->wq, &dev->cmd_work);
+            }
             
             break;
         }
         
         case CXL_MEM_QUERY_CMD: {
             struct cxl_mem_query_cmd query;
-            struct cxl_fpga_cmd *cmd, *found = NULL;
+            struct cxl_fpga_cmd *found;
             
             if (copy_from_user(&query, (void __user *)arg, sizeof(query))) {
                 ret = -EFAULT;
                 break;
             }
             
-            // Find command in the list
+            // Commands are indexed by id, so lookup is a single slot check
             spin_lock(&dev->cmd_lock);
-            list_for_each_entry(cmd, &dev->cmd_list, list) {
-                if (cmd->id == query.id) {
-                    found = cmd;
-                    break;
-                }
-            }
+            found = &dev->cmd_table[CMD_SLOT(query.id)];
             
-            if (found) {
+            if (found->in_use && !found->from_ring && found->id == query.id) {
                 query.status = found->status;
                 query.result = found->result;
                 
-                // If command is complete, remove it from the list
+                // If command is complete, release its slot
                 if (found->status != CXL_CMD_STATUS_ACTIVE) {
-                    list_del(&found->list);
-                    kfree(found);
+                    found->in_use = false;
                 }
             } else {
                 query.status = CXL_CMD_STATUS_INVALID;
-                query.result = 0;
\ No newline at end of file
+                query.result = 0;
+            }
+            spin_unlock(&dev->cmd_lock);
+            
+            if (copy_to_user((void __user *)arg, &query, sizeof(query))) {
+                ret = -EFAULT;
+            }
+            break;
+        }
+        
+        case CXL_MEM_RING_SETUP: {
+            struct cxl_ring_setup setup;
+            
+            ret = cxl_fpga_ring_setup(dev, file, &setup);
+            if (ret == 0 && copy_to_user((void __user *)arg, &setup, sizeof(setup))) {
+                ret = -EFAULT;
+            }
+            break;
+        }
+        
+        case CXL_MEM_RING_ENTER:
+            ret = cxl_fpga_ring_enter(dev, file);
+            break;
+        
+        case CXL_MEM_GET_CACHE_MODE: {
+            u32 mode = cxl_fpga_cache_mode();
+            
+            if (copy_to_user((void __user *)arg, &mode, sizeof(mode))) {
+                ret = -EFAULT;
+            }
+            break;
+        }
+        
+        default:
+            ret = -ENOTTY;
+            break;
+    }
+    
+    mutex_unlock(&dev->dev_mutex);
+    return ret;
+}
+
+// Consistent copy of the counters for sysfs
+static void cxl_fpga_read_stats(struct cxl_fpga_device *dev, struct cxl_fpga_stats *stats)
+{
+    spin_lock(&dev->cmd_lock);
+    *stats = dev->stats;
+    spin_unlock(&dev->cmd_lock);
+}
+
+// One read-only stats/ file per counter, each printing a single decimal value
+#define CXL_FPGA_STAT_ATTR(name, value)                                             \
+static ssize_t name##_show(struct device *d, struct device_attribute *attr, char *buf) \
+{                                                                                   \
+    struct cxl_fpga_stats s;                                                        \
+                                                                                    \
+    cxl_fpga_read_stats(dev_get_drvdata(d), &s);                                    \
+    return sysfs_emit(buf, "%llu\n", (unsigned long long)(value));                  \
+}                                                                                   \
+static DEVICE_ATTR_RO(name)
+
+CXL_FPGA_STAT_ATTR(commands_submitted, s.submitted);
+CXL_FPGA_STAT_ATTR(commands_completed, s.completed);
+CXL_FPGA_STAT_ATTR(commands_failed, s.failed);
+CXL_FPGA_STAT_ATTR(queue_depth, s.depth);
+CXL_FPGA_STAT_ATTR(doorbells, s.doorbells);
+CXL_FPGA_STAT_ATTR(latency_avg_ns, s.latency_count ? div64_u64(s.latency_total_ns, s.latency_count) : 0);
+CXL_FPGA_STAT_ATTR(latency_max_ns, s.latency_max_ns);
+CXL_FPGA_STAT_ATTR(bytes_copy, s.bytes[CMD_MEM_COPY]);
+CXL_FPGA_STAT_ATTR(bytes_fill, s.bytes[CMD_MEM_FILL]);
+CXL_FPGA_STAT_ATTR(bytes_accelerate, s.bytes[CMD_ACCELERATE]);
+
+// Writing anything clears the counters; the queue depth is live state and stays
+static ssize_t reset_store(struct device *d, struct device_attribute *attr, const char *buf, size_t count)
+{
+    struct cxl_fpga_device *dev = dev_get_drvdata(d);
+    u64 depth;
+    
+    spin_lock(&dev->cmd_lock);
+    depth = dev->stats.depth;
+    memset(&dev->stats, 0, sizeof(dev->stats));
+    dev->stats.depth = depth;
+    spin_unlock(&dev->cmd_lock);
+    return count;
+}
+static DEVICE_ATTR_WO(reset);
+
+static struct attribute *cxl_fpga_stats_attrs[] = {
+    &dev_attr_commands_submitted.attr,
+    &dev_attr_commands_completed.attr,
+    &dev_attr_commands_failed.attr,
+    &dev_attr_queue_depth.attr,
+    &dev_attr_doorbells.attr,
+    &dev_attr_latency_avg_ns.attr,
+    &dev_attr_latency_max_ns.attr,
+    &dev_attr_bytes_copy.attr,
+    &dev_attr_bytes_fill.attr,
+    &dev_attr_bytes_accelerate.attr,
+    &dev_attr_reset.attr,
+    NULL,
+};
+
+static const struct attribute_group cxl_fpga_stats_group = {
+    .name = "stats",
+    .attrs = cxl_fpga_stats_attrs,
+};
+
+static const struct attribute_group *cxl_fpga_groups[] = {
+    &cxl_fpga_stats_group,
+    NULL,
+};
+
+static const struct file_operations cxl_fpga_fops = {
+    .owner = THIS_MODULE,
+    .open = cxl_fpga_open,
+    .release = cxl_fpga_release,
+    .mmap = cxl_fpga_mmap,
+    .get_unmapped_area = cxl_fpga_get_unmapped_area,
+    .unlocked_ioctl = cxl_fpga_ioctl,
+};
+
+// PCI probe
+static int cxl_fpga_probe(struct pci_dev *pdev, const struct pci_device_id *id)
+{
+    struct cxl_fpga_device *dev;
+    struct device *char_dev;
+    int minor, i, ret;
+    
+    // The command table makes the device structure too large for kzalloc
+    dev = vzalloc(sizeof(*dev));
+    if (!dev) {
+        return -ENOMEM;
+    }
+    
+    // Claim the lowest free minor, so unbound devices give theirs back
+    mutex_lock(&devices_lock);
+    minor = 0;
+    while (minor < MAX_DEVICES && devices[minor]) {
+        minor++;
+    }
+    if (minor < MAX_DEVICES) {
+        devices[minor] = dev;
+    }
+    mutex_unlock(&devices_lock);
+    if (minor == MAX_DEVICES) {
+        vfree(dev);
+        return -ENOSPC;
+    }
+    
+    dev->pdev = pdev;
+    dev->minor = minor;
+    dev->dev_num = MKDEV(MAJOR(cxl_fpga_devt), dev->minor);
+    mutex_init(&dev->dev_mutex);
+    INIT_LIST_HEAD(&dev->cmd_list);
+    spin_lock_init(&dev->cmd_lock);
+    INIT_WORK(&dev->cmd_work, cxl_fpga_cmd_work);
+    init_completion(&dev->batch_done);
+    INIT_LIST_HEAD(&dev->stale_chains);
+    dev->irq = -1;
+    for (i = 0; i < CXL_RING_ENTRIES; i++) {
+        init_completion(&dev->cmd_table[i].done);
+    }
+    
+    ret = pci_enable_device(pdev);
+    if (ret) {
+        goto err_free;
+    }
+    
+    ret = pci_request_regions(pdev, DRIVER_NAME);
+    if (ret) {
+        goto err_disable;
+    }
+    pci_set_master(pdev);
+    
+    dev->mmio_base = pci_iomap(pdev, BAR_MMIO, 0);
+    if (!dev->mmio_base) {
+        ret = -ENOMEM;
+        goto err_regions;
+    }
+    
+    dev->shared_mem_phys = pci_resource_start(pdev, BAR_SHARED_MEM);
+    dev->shared_mem_size = pci_resource_len(pdev, BAR_SHARED_MEM);
+    
+    // Tell the FPGA where the host sees its memory
+    fpga_write32(dev, REG_MEMBASE_LOW, lower_32_bits(dev->shared_mem_phys));
+    fpga_write32(dev, REG_MEMBASE_HIGH, upper_32_bits(dev->shared_mem_phys));
+    
+    // Host-buffer copies need the FPGA to walk descriptor chains and reach all of host memory
+    if (fpga_read32(dev, REG_CAPS) & CAP_DESC_CHAIN) {
+        if (dma_set_mask_and_coherent(&pdev->dev, DMA_BIT_MASK(64)) == 0) {
+            dev->desc_chain = true;
+        } else {
+            dev_warn(&pdev->dev, "no 64-bit DMA, host-buffer copies disabled\n");
+        }
+    }
+    
+    // One vector is enough: it only ever signals batch completion
+    if (pci_alloc_irq_vectors(pdev, 1, 1, PCI_IRQ_MSIX | PCI_IRQ_MSI) == 1) {
+        dev->irq = pci_irq_vector(pdev, 0);
+        if (request_irq(dev->irq, cxl_fpga_irq, 0, DRIVER_NAME, dev)) {
+            pci_free_irq_vectors(pdev);
+            dev->irq = -1;
+        }
+    }
+    if (dev->irq < 0) {
+        dev_warn(&pdev->dev, "no MSI-X/MSI vector, completing commands by polling\n");
+    }
+    
+    dev->wq = alloc_workqueue("%s%d", WQ_UNBOUND | WQ_HIGHPRI, 1, DRIVER_NAME, dev->minor);
+    if (!dev->wq) {
+        ret = -ENOMEM;
+        goto err_irq;
+    }
+    
+    cdev_init(&dev->cdev, &cxl_fpga_fops);
+    dev->cdev.owner = THIS_MODULE;
+    ret = cdev_add(&dev->cdev, dev->dev_num, 1);
+    if (ret) {
+        goto err_wq;
+    }
+    
+    char_dev = device_create_with_groups(cxl_fpga_class, &pdev->dev, dev->dev_num, dev,
+                                         cxl_fpga_groups, "cxl%d", dev->minor);
+    if (IS_ERR(char_dev)) {
+        ret = PTR_ERR(char_dev);
+        goto err_cdev;
+    }
+    
+    pci_set_drvdata(pdev, dev);
+    
+    dev_info(&pdev->dev, "%s: %pa shared memory at %pa\n", DRIVER_DESC,
+             &dev->shared_mem_size, &dev->shared_mem_phys);
+    return 0;
+    
+err_cdev:
+    cdev_del(&dev->cdev);
+err_wq:
+    destroy_workqueue(dev->wq);
+err_irq:
+    if (dev->irq >= 0) {
+        free_irq(dev->irq, dev);
+        pci_free_irq_vectors(pdev);
+    }
+    pci_iounmap(pdev, dev->mmio_base);
+err_regions:
+    pci_release_regions(pdev);
+err_disable:
+    pci_disable_device(pdev);
+err_free:
+    mutex_lock(&devices_lock);
+    devices[dev->minor] = NULL;
+    mutex_unlock(&devices_lock);
+    vfree(dev);
+    return ret;
+}
+
+// PCI remove
+static void cxl_fpga_remove(struct pci_dev *pdev)
+{
+    struct cxl_fpga_device *dev = pci_get_drvdata(pdev);
+    
+    device_destroy(cxl_fpga_class, dev->dev_num);
+    cdev_del(&dev->cdev);
+    
+    // Let the dispatcher drain whatever is still queued
+    flush_work(&dev->cmd_work);
+    destroy_workqueue(dev->wq);
+    vfree(dev->ring);
+    
+    // With bus mastering off nothing can still be reading a timed-out chain
+    pci_clear_master(pdev);
+    while (!list_empty(&dev->stale_chains)) {
+        struct cxl_fpga_chain *chain = list_first_entry(&dev->stale_chains, struct cxl_fpga_chain, list);
+        
+        list_del(&chain->list);
+        cxl_fpga_release_chain(dev, chain);
+    }
+    
+    if (dev->irq >= 0) {
+        free_irq(dev->irq, dev);
+        pci_free_irq_vectors(pdev);
+    }
+    
+    pci_iounmap(pdev, dev->mmio_base);
+    pci_release_regions(pdev);
+    pci_disable_device(pdev);
+    
+    mutex_lock(&devices_lock);
+    devices[dev->minor] = NULL;
+    mutex_unlock(&devices_lock);
+    vfree(dev);
+}
+
+static struct pci_driver cxl_fpga_pci_driver = {
+    .name = DRIVER_NAME,
+    .id_table = cxl_fpga_ids,
+    .probe = cxl_fpga_probe,
+    .remove = cxl_fpga_remove,
+};
+
+static int __init cxl_fpga_init(void)
+{
+    int ret;
+    
+    ret = alloc_chrdev_region(&cxl_fpga_devt, 0, MAX_DEVICES, DRIVER_NAME);
+    if (ret) {
+        return ret;
+    }
+    
+    cxl_fpga_class = class_create(THIS_MODULE, DRIVER_NAME);
+    if (IS_ERR(cxl_fpga_class)) {
+        ret = PTR_ERR(cxl_fpga_class);
+        goto err_chrdev;
+    }
+    
+    ret = pci_register_driver(&cxl_fpga_pci_driver);
+    if (ret) {
+        goto err_class;
+    }
+    
+    return 0;
+    
+err_class:
+    class_destroy(cxl_fpga_class);
+err_chrdev:
+    unregister_chrdev_region(cxl_fpga_devt, MAX_DEVICES);
+    return ret;
+}
+
+static void __exit cxl_fpga_exit(void)
+{
+    pci_unregister_driver(&cxl_fpga_pci_driver);
+    class_destroy(cxl_fpga_class);
+    unregister_chrdev_region(cxl_fpga_devt, MAX_DEVICES);
+}
+
+module_init(cxl_fpga_init);
+module_exit(cxl_fpga_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION(DRIVER_DESC);
@@ -0,0 +1,323 @@
+// CXL Region Allocator
+// Size-class slabs on top of a buddy allocator, with host-side metadata
+
+#include "cxl_allocator.h"
+
+#include <algorithm>
+#include <cstring>
+
+CXLAllocator::CXLAllocator()
+    : base(0), capacity(0), bytes_allocated(0), num_allocations(0), free_blocks(MAX_ORDER + 1) {}
+
+void CXLAllocator::init(size_t start, size_t size) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (auto& list : free_blocks) {
+        list.clear();
+    }
+    block_orders.clear();
+    slabs.clear();
+    reserved.clear();
+    for (auto& partial : partial_slabs) {
+        partial.clear();
+    }
+
+    base = start;
+    capacity = size & ~((static_cast<size_t>(1) << MIN_ORDER) - 1);
+    bytes_allocated = 0;
+    num_allocations = 0;
+
+    add_free_range(0, capacity);
+}
+
+void CXLAllocator::reset() {
+    init(0, 0);
+}
+
+// Carve [rel, rel + size) into the largest naturally aligned buddy blocks
+void CXLAllocator::add_free_range(size_t rel, size_t size) {
+    size_t end = rel + size;
+    while (rel + (static_cast<size_t>(1) << MIN_ORDER) <= end) {
+        unsigned order = MAX_ORDER;
+        while (order > MIN_ORDER &&
+               ((rel & ((static_cast<size_t>(1) << order) - 1)) != 0 ||
+                rel + (static_cast<size_t>(1) << order) > end)) {
+            order--;
+        }
+        free_blocks[order].insert(rel);
+        rel += static_cast<size_t>(1) << order;
+    }
+}
+
+unsigned CXLAllocator::order_for(size_t size) {
+    unsigned order = MIN_ORDER;
+    while (order < MAX_ORDER && (static_cast<size_t>(1) << order) < size) {
+        order++;
+    }
+    return order;
+}
+
+bool CXLAllocator::buddy_allocate(unsigned order, size_t* rel) {
+    unsigned found = order;
+    while (found <= MAX_ORDER && free_blocks[found].empty()) {
+        found++;
+    }
+    if (found > MAX_ORDER) {
+        return false;
+    }
+
+    // Take the lowest block so allocations pack towards the start of the region
+    size_t block = *free_blocks[found].begin();
+    free_blocks[found].erase(free_blocks[found].begin());
+
+    // Split down to the requested order, returning upper halves to the free lists
+    while (found > order) {
+        found--;
+        free_blocks[found].insert(block + (static_cast<size_t>(1) << found));
+    }
+
+    *rel = block;
+    return true;
+}
+
+void CXLAllocator::buddy_release(size_t rel, unsigned order) {
+    // Coalesce with free buddies as far up as they go
+    while (order < MAX_ORDER) {
+        size_t buddy = rel ^ (static_cast<size_t>(1) << order);
+        auto it = free_blocks[order].find(buddy);
+        if (it == free_blocks[order].end()) {
+            break;
+        }
+        free_blocks[order].erase(it);
+        rel = std::min(rel, buddy);
+        order++;
+    }
+    free_blocks[order].insert(rel);
+}
+
+bool CXLAllocator::slab_allocate(unsigned size_class, size_t* rel) {
+    auto& partial = partial_slabs[size_class];
+
+    if (partial.empty()) {
+        size_t slab_rel;
+        if (!buddy_allocate(SLAB_ORDER, &slab_rel)) {
+            return false;
+        }
+
+        Slab slab;
+        slab.size_class = size_class;
+        slab.total_slots = static_cast<uint32_t>((static_cast<size_t>(1) << SLAB_ORDER) /
+                                                 class_size(size_class));
+        slab.free_slots = slab.total_slots;
+        slab.bitmap.assign((slab.total_slots + 63) / 64, 0);
+
+        slabs.emplace(slab_rel, std::move(slab));
+        partial.insert(slab_rel);
+    }
+
+    size_t slab_rel = *partial.begin();
+    Slab& slab = slabs.at(slab_rel);
+
+    for (size_t word = 0; word < slab.bitmap.size(); word++) {
+        if (slab.bitmap[word] == ~static_cast<uint64_t>(0)) {
+            continue;
+        }
+        unsigned bit = __builtin_ctzll(~slab.bitmap[word]);
+        size_t slot = word * 64 + bit;
+        if (slot >= slab.total_slots) {
+            break;
+        }
+
+        slab.bitmap[word] |= static_cast<uint64_t>(1) << bit;
+        if (--slab.free_slots == 0) {
+            partial.erase(slab_rel);
+        }
+
+        *rel = slab_rel + slot * class_size(size_class);
+        return true;
+    }
+
+    return false;
+}
+
+bool CXLAllocator::slab_release(size_t rel) {
+    size_t slab_rel = rel & ~((static_cast<size_t>(1) << SLAB_ORDER) - 1);
+    auto it = slabs.find(slab_rel);
+    if (it == slabs.end()) {
+        return false;
+    }
+
+    Slab& slab = it->second;
+    size_t size = class_size(slab.size_class);
+    if ((rel - slab_rel) % size != 0) {
+        return false;
+    }
+
+    size_t slot = (rel - slab_rel) / size;
+    uint64_t mask = static_cast<uint64_t>(1) << (slot % 64);
+    if (!(slab.bitmap[slot / 64] & mask)) {
+        return false;  // Double free
+    }
+
+    slab.bitmap[slot / 64] &= ~mask;
+    auto& partial = partial_slabs[slab.size_class];
+    if (slab.free_slots++ == 0) {
+        partial.insert(slab_rel);
+    }
+
+    // Give empty slabs back to the buddy allocator, keeping one per class warm
+    if (slab.free_slots == slab.total_slots && partial.size() > 1) {
+        partial.erase(slab_rel);
+        slabs.erase(it);
+        buddy_release(slab_rel, SLAB_ORDER);
+    }
+
+    bytes_allocated -= size;
+    return true;
+}
+
+bool CXLAllocator::allocate(size_t size, size_t align, size_t* offset) {
+    if (size == 0 || !offset || (align & (align - 1)) != 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    size_t need = std::max(size, align);
+    size_t rel;
+
+    if (need <= MAX_CLASS_SIZE) {
+        // Slots are aligned to their class size, so alignment is covered by the class
+        unsigned size_class = 0;
+        while (class_size(size_class) < need) {
+            size_class++;
+        }
+        if (!slab_allocate(size_class, &rel)) {
+            return false;
+        }
+        bytes_allocated += class_size(size_class);
+    } else {
+        // Buddy blocks are naturally aligned to their own size
+        unsigned order = order_for(need);
+        if (!buddy_allocate(order, &rel)) {
+            return false;
+        }
+        block_orders[rel] = order;
+        bytes_allocated += static_cast<size_t>(1) << order;
+    }
+
+    num_allocations++;
+    *offset = base + rel;
+    return true;
+}
+
+bool CXLAllocator::release(size_t offset) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (offset < base || offset >= base + capacity) {
+        return false;
+    }
+    size_t rel = offset - base;
+
+    auto it = block_orders.find(rel);
+    if (it != block_orders.end()) {
+        unsigned order = it->second;
+        block_orders.erase(it);
+        buddy_release(rel, order);
+        bytes_allocated -= static_cast<size_t>(1) << order;
+        num_allocations--;
+        return true;
+    }
+
+    auto range = reserved.find(rel);
+    if (range != reserved.end()) {
+        size_t end = rel + range->second;
+        bytes_allocated -= range->second;
+        reserved.erase(range);
+        num_allocations--;
+
+        // Hand the range back as naturally aligned blocks so they coalesce
+        while (rel < end) {
+            unsigned order = MIN_ORDER;
+            while (order < MAX_ORDER && (rel & ((static_cast<size_t>(1) << (order + 1)) - 1)) == 0 &&
+                   rel + (static_cast<size_t>(1) << (order + 1)) <= end) {
+                order++;
+            }
+            buddy_release(rel, order);
+            rel += static_cast<size_t>(1) << order;
+        }
+        return true;
+    }
+
+    if (slab_release(rel)) {
+        num_allocations--;
+        return true;
+    }
+    return false;
+}
+
+bool CXLAllocator::reserve(size_t offset, size_t length) {
+    std::lock_guard<std::mutex> guard(lock);
+    const size_t page = static_cast<size_t>(1) << MIN_ORDER;
+    if (!length || offset < base || offset - base >= capacity || length > capacity) {
+        return false;
+    }
+    size_t rel = (offset - base) & ~(page - 1);
+    size_t end = std::min(capacity, (offset - base + length + page - 1) & ~(page - 1));
+
+    // Free blocks never overlap, so the range is free iff their overlap with it adds up
+    std::vector<std::pair<size_t, unsigned>> overlapping;
+    size_t covered = 0;
+    for (unsigned order = MIN_ORDER; order <= MAX_ORDER; order++) {
+        size_t block = static_cast<size_t>(1) << order;
+        auto& list = free_blocks[order];
+        for (auto it = list.lower_bound(rel >= block ? rel - block + 1 : 0);
+             it != list.end() && *it < end; ++it) {
+            overlapping.emplace_back(*it, order);
+            covered += std::min(end, *it + block) - std::max(rel, *it);
+        }
+    }
+    if (covered != end - rel) {
+        return false;
+    }
+
+    // Split each block around the range, keeping the parts outside it free
+    for (const auto& entry : overlapping) {
+        size_t start = entry.first;
+        size_t block_end = start + (static_cast<size_t>(1) << entry.second);
+        free_blocks[entry.second].erase(start);
+        if (start < rel) {
+            add_free_range(start, rel - start);
+        }
+        if (block_end > end) {
+            add_free_range(end, block_end - end);
+        }
+    }
+
+    reserved[rel] = end - rel;
+    bytes_allocated += end - rel;
+    num_allocations++;
+    return true;
+}
+
+void CXLAllocator::get_stats(cxl_alloc_stats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = capacity;
+    stats->bytes_allocated = bytes_allocated;
+    stats->num_allocations = num_allocations;
+
+    for (unsigned order = MIN_ORDER; order <= MAX_ORDER; order++) {
+        size_t block = static_cast<size_t>(1) << order;
+        stats->bytes_free += free_blocks[order].size() * block;
+        if (!free_blocks[order].empty()) {
+            stats->largest_free_block = block;
+        }
+    }
+    for (const auto& entry : slabs) {
+        stats->bytes_free += entry.second.free_slots * class_size(entry.second.size_class);
+        stats->num_slabs++;
+    }
+}
@@ -0,0 +1,506 @@
+// CXL Asynchronous Operations
+// Futures and coroutines over the FPGA command ring
+
+#include "cxl_async.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "cxl_compute.h"
+
+#define CXL_ASYNC_MAX_INFLIGHT  (CXL_RING_ENTRIES / 2)  // The rest is left to the library's chains
+#define CXL_ASYNC_MAX_COMMAND   (1U << 30)              // Bytes per command
+#define CXL_ASYNC_REAP_BATCH    64
+#define CXL_ASYNC_WAIT_MS       1                       // Reactor sleep in the driver per round
+#define CXL_ASYNC_IDLE_US       20                      // Reactor backoff with nothing to wait on
+#define CXL_ASYNC_ID_SLOT_MASK  (CXL_RING_ENTRIES - 1)
+
+struct CXLOperationState {
+    CXLAsync* owner;
+    bool polled;                    // Owner has no reactor: waiting means polling
+    uint64_t dst;                   // Range the operation writes
+    size_t length;
+    uint32_t commands;              // Commands still running (owner's lock)
+
+    std::mutex lock;
+    bool done;
+    std::coroutine_handle<> waiter;
+    cxl_completion completion;
+    std::promise<cxl_completion> promise;
+    std::shared_future<cxl_completion> future;
+
+    CXLOperationState(CXLAsync* async, bool poll, uint32_t id, uint64_t offset, size_t bytes)
+        : owner(async), polled(poll), dst(offset), length(bytes), commands(0), done(false),
+          completion{id, CXL_CMD_STATUS_COMPLETED, 0}, future(promise.get_future().share()) {}
+};
+
+struct CXLTaskState {
+    std::mutex lock;
+    std::condition_variable finished;
+    bool done = false;
+    bool detached = false;          // The CXLTask is gone; the frame frees itself
+};
+
+// CXLOperation
+
+bool CXLOperation::done() const {
+    if (!state) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->done;
+}
+
+cxl_completion CXLOperation::wait() const {
+    if (!state) {
+        return cxl_completion{0, CXL_CMD_STATUS_INVALID, static_cast<uint64_t>(EINVAL)};
+    }
+    if (state->polled) {
+        while (!done()) {
+            if (!state->owner->poll() && !state->owner->wait_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    return state->future.get();
+}
+
+std::shared_future<cxl_completion> CXLOperation::future() const {
+    return state ? state->future : std::shared_future<cxl_completion>();
+}
+
+bool CXLOperation::await_suspend(std::coroutine_handle<> waiter) const {
+    std::lock_guard<std::mutex> guard(state->lock);
+    if (state->done) {
+        return false;
+    }
+    state->waiter = waiter;
+    return true;
+}
+
+cxl_completion CXLOperation::await_resume() const {
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->completion;
+}
+
+// CXLTask
+
+CXLTask::promise_type::promise_type() : state(std::make_shared<CXLTaskState>()) {}
+
+CXLTask CXLTask::promise_type::get_return_object() {
+    return CXLTask(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+CXLTask::CXLTask(std::coroutine_handle<promise_type> coroutine)
+    : frame(coroutine), state(coroutine.promise().state) {}
+
+CXLTask::CXLTask(CXLTask&& other) noexcept : frame(other.frame), state(std::move(other.state)) {
+    other.frame = nullptr;
+}
+
+CXLTask& CXLTask::operator=(CXLTask&& other) noexcept {
+    if (this != &other) {
+        release();
+        frame = other.frame;
+        state = std::move(other.state);
+        other.frame = nullptr;
+    }
+    return *this;
+}
+
+CXLTask::~CXLTask() {
+    release();
+}
+
+void CXLTask::release() {
+    if (!frame) {
+        return;
+    }
+    bool finished;
+    {
+        std::lock_guard<std::mutex> guard(state->lock);
+        finished = state->done;
+        state->detached = !finished;
+    }
+    if (finished) {
+        frame.destroy();
+    }
+    frame = nullptr;
+}
+
+bool CXLTask::finish(const std::shared_ptr<CXLTaskState>& task) {
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->done = true;
+    task->finished.notify_all();
+    return !task->detached;
+}
+
+bool CXLTask::done() const {
+    if (!state) {
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(state->lock);
+    return state->done;
+}
+
+void CXLTask::wait() const {
+    if (!state) {
+        return;
+    }
+    std::unique_lock<std::mutex> guard(state->lock);
+    state->finished.wait(guard, [this] { return state->done; });
+}
+
+// CXLAsync
+
+CXLAsync::CXLAsync(void* region, bool reactor_thread)
+    : handle(region), base(nullptr), size(0), use_ring(false), coherence(false),
+      slots(CXL_RING_ENTRIES), slot_cursor(0), in_flight(0), active(0), sequence(0), stopping(false) {
+    base = static_cast<char*>(cxl_get_region(handle, &size));
+    use_ring = cxl_has_command_ring(handle) != 0;
+    coherence = use_ring && cxl_get_cache_mode(handle) == CXL_CACHE_WRITE_BACK;
+    size_t granule = 0;
+    layout.ways = std::max(cxl_get_interleave(handle, &granule), 1);
+    layout.granule = granule;
+    if (reactor_thread) {
+        reactor = std::thread(&CXLAsync::run_reactor, this);
+    }
+}
+
+CXLAsync::~CXLAsync() {
+    drain();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    if (reactor.joinable()) {
+        reactor.join();
+    }
+    // Coroutines resumed by the reactor may have started more work on their way out
+    while (outstanding()) {
+        if (!poll() && !wait_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+CXLOperation CXLAsync::copy(uint64_t dst, uint64_t src, size_t length) {
+    if (src > size || length > size - src) {
+        return failed("Async copy source lies outside the region");
+    }
+    return start(CMD_MEM_COPY, dst, src, length, 0);
+}
+
+CXLOperation CXLAsync::fill(uint64_t dst, uint8_t value, size_t length) {
+    return start(CMD_MEM_FILL, dst, value, length, 0);
+}
+
+CXLOperation CXLAsync::accelerate(uint64_t offset, size_t length, float scale) {
+    if (offset % sizeof(float) || length % sizeof(float)) {
+        return failed("Async accelerate needs a float-aligned range");
+    }
+    uint32_t bits;
+    memcpy(&bits, &scale, sizeof(bits));
+    return start(CMD_ACCELERATE, offset, bits, length, 0);
+}
+
+CXLOperation CXLAsync::failed(const char* why) {
+    std::cerr << why << std::endl;
+    std::lock_guard<std::mutex> guard(lock);
+    auto op = std::make_shared<CXLOperationState>(this, !reactor.joinable(), ++sequence, 0, 0);
+    op->done = true;
+    op->completion.status = CXL_CMD_STATUS_INVALID;
+    op->completion.result = EINVAL;
+    op->promise.set_value(op->completion);
+    return CXLOperation(op);
+}
+
+CXLOperation CXLAsync::start(uint32_t opcode, uint64_t dst, uint64_t data, size_t length, uint32_t flags) {
+    if (!base || dst > size || length > size - dst) {
+        return failed("Async operation lies outside the region");
+    }
+
+    // One command per stripe unit, a copy's source on the same device as its destination
+    std::vector<cxl_command> cmds;
+    for (size_t done = 0; done < length;) {
+        cxl_command cmd = {};
+        cmd.opcode = opcode;
+        cmd.address = dst + done;
+        cmd.data = data;
+        cmd.flags = flags;
+        uint64_t chunk = std::min<uint64_t>(length - done, CXL_ASYNC_MAX_COMMAND);
+        chunk = std::min(chunk, layout.run(cmd.address));
+        if (opcode == CMD_MEM_COPY) {
+            cmd.data = data + done;
+            if (use_ring && layout.device_of(cmd.data) != layout.device_of(cmd.address)) {
+                return failed("Async copy crosses devices of the interleave set");
+            }
+            chunk = std::min(chunk, layout.run(cmd.data));
+        }
+        cmd.length = static_cast<uint32_t>(chunk);
+        cmds.push_back(cmd);
+        done += chunk;
+    }
+
+    // Push out what the CPU wrote and drop the lines the device rewrites
+    if (coherence) {
+        if (opcode == CMD_MEM_COPY) {
+            cxl_flush_range(handle, base + data, length);
+            cxl_persist_barrier(handle);
+        }
+        cxl_invalidate_range(handle, base + dst, length);
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    auto op = std::make_shared<CXLOperationState>(this, !reactor.joinable(), ++sequence, dst, length);
+    if (cmds.empty()) {
+        op->done = true;
+        op->promise.set_value(op->completion);
+        return CXLOperation(op);
+    }
+    op->commands = static_cast<uint32_t>(cmds.size());
+    active++;
+    for (const cxl_command& cmd : cmds) {
+        pending.push_back(Pending{cmd, op});
+    }
+    if (use_ring) {
+        submit_pending();
+    }
+    guard.unlock();
+    work_ready.notify_one();
+    return CXLOperation(op);
+}
+
+// Move queued commands into free ring slots; callers hold lock
+void CXLAsync::submit_pending() {
+    std::vector<cxl_command> batch;
+    std::vector<uint32_t> used;
+    while (!pending.empty() && in_flight + batch.size() < CXL_ASYNC_MAX_INFLIGHT) {
+        while (slots[slot_cursor].op) {
+            slot_cursor = (slot_cursor + 1) & CXL_ASYNC_ID_SLOT_MASK;
+        }
+        Slot& slot = slots[slot_cursor];
+        slot.generation++;
+        slot.id = ((slot.generation << 8) | slot_cursor) & 0x7fffffffu;
+        slot.op = pending.front().op;
+        pending.front().cmd.id = slot.id;
+        batch.push_back(pending.front().cmd);
+        used.push_back(slot_cursor);
+        pending.pop_front();
+        slot_cursor = (slot_cursor + 1) & CXL_ASYNC_ID_SLOT_MASK;
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    int posted = cxl_submit_commands(handle, batch.data(), static_cast<int>(batch.size()));
+    if (posted < 0) {
+        // The doorbell failed: nothing can be trusted to run, so fail the batch
+        std::cerr << "FPGA command ring rejected async commands" << std::endl;
+        for (uint32_t index : used) {
+            auto op = std::move(slots[index].op);
+            bool finished;
+            retire(op, cxl_completion{slots[index].id, CXL_CMD_STATUS_ERROR, static_cast<uint64_t>(EIO)},
+                   &finished);
+            if (finished) {
+                failures.push_back(op);
+            }
+        }
+        return;
+    }
+
+    in_flight += static_cast<size_t>(posted);
+    // Ring full: requeue the rest in order for the next round
+    for (size_t i = batch.size(); i-- > static_cast<size_t>(posted);) {
+        Slot& slot = slots[used[i]];
+        pending.push_front(Pending{batch[i], std::move(slot.op)});
+        slot.op = nullptr;
+    }
+}
+
+// Account one finished command; callers hold lock
+void CXLAsync::retire(const std::shared_ptr<CXLOperationState>& op, const cxl_completion& cqe, bool* finished) {
+    std::lock_guard<std::mutex> guard(op->lock);
+    if (cqe.status != CXL_CMD_STATUS_COMPLETED) {
+        if (op->completion.status == CXL_CMD_STATUS_COMPLETED) {
+            op->completion.status = cqe.status;
+            op->completion.result = cqe.result;
+        }
+    } else if (op->completion.status == CXL_CMD_STATUS_COMPLETED) {
+        op->completion.result = cqe.result;
+    }
+    *finished = --op->commands == 0;
+}
+
+// Complete an operation whose commands have all finished and resume its waiter
+void CXLAsync::finish(const std::shared_ptr<CXLOperationState>& op) {
+    // Drop whatever was refetched while the device wrote
+    if (coherence) {
+        cxl_invalidate_range(handle, base + op->dst, op->length);
+    }
+
+    std::coroutine_handle<> waiter;
+    {
+        std::lock_guard<std::mutex> guard(op->lock);
+        op->done = true;
+        waiter = op->waiter;
+        op->waiter = nullptr;
+        op->promise.set_value(op->completion);
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (--active == 0) {
+            idle.notify_all();
+        }
+    }
+    if (waiter) {
+        waiter.resume();
+    }
+}
+
+// CPU path: what the device would do with the command
+void CXLAsync::execute(const cxl_command& cmd) const {
+    char* dst = base + cmd.address;
+    switch (cmd.opcode) {
+        case CMD_MEM_COPY:
+            memmove(dst, base + cmd.data, cmd.length);
+            break;
+        case CMD_MEM_FILL:
+            memset(dst, static_cast<int>(cmd.data & 0xFF), cmd.length);
+            break;
+        case CMD_ACCELERATE: {
+            float scale;
+            uint32_t bits = static_cast<uint32_t>(cmd.data);
+            memcpy(&scale, &bits, sizeof(scale));
+            float* values = reinterpret_cast<float*>(dst);
+            cxl_compute_ops(CXL_COMPUTE_ISA_AUTO)->scale(values, values, scale, cmd.length / sizeof(float));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int CXLAsync::poll() {
+    std::vector<std::shared_ptr<CXLOperationState>> finished;
+    if (use_ring) {
+        cxl_completion cqes[CXL_ASYNC_REAP_BATCH];
+        int reaped = cxl_reap_completions(handle, cqes, CXL_ASYNC_REAP_BATCH);
+        std::unique_lock<std::mutex> guard(lock);
+        for (int i = 0; i < reaped; i++) {
+            Slot& slot = slots[cqes[i].id & CXL_ASYNC_ID_SLOT_MASK];
+            if (!slot.op || slot.id != cqes[i].id) {
+                continue;   // Not one of ours
+            }
+            auto op = std::move(slot.op);
+            slot.op = nullptr;
+            in_flight--;
+            bool last;
+            retire(op, cqes[i], &last);
+            if (last) {
+                finished.push_back(std::move(op));
+            }
+        }
+        submit_pending();
+        finished.insert(finished.end(), failures.begin(), failures.end());
+        failures.clear();
+    } else {
+        std::deque<Pending> work;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            work.swap(pending);
+        }
+        for (const Pending& item : work) {
+            execute(item.cmd);
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        for (const Pending& item : work) {
+            bool last;
+            retire(item.op, cxl_completion{0, CXL_CMD_STATUS_COMPLETED, 0}, &last);
+            if (last) {
+                finished.push_back(item.op);
+            }
+        }
+    }
+
+    for (const auto& op : finished) {
+        finish(op);
+    }
+    return static_cast<int>(finished.size());
+}
+
+// Sleep in the driver until one of our commands finishes; false if there is none
+bool CXLAsync::wait_one() {
+    if (!use_ring) {
+        return false;
+    }
+    uint32_t id = 0;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (uint32_t i = 0; i < CXL_RING_ENTRIES && !found; i++) {
+            const Slot& slot = slots[(slot_cursor + i) & CXL_ASYNC_ID_SLOT_MASK];
+            if (slot.op) {
+                id = slot.id;
+                found = true;
+            }
+        }
+    }
+    if (!found) {
+        return false;
+    }
+    // A command the driver hasn't taken from the SQ yet reports INVALID at once;
+    // that is no progress, and the next poll() rings for it again
+    cxl_completion cqe;
+    int status = cxl_wait_command(handle, id, CXL_ASYNC_WAIT_MS, &cqe);
+    return (status == 0 && cqe.status != CXL_CMD_STATUS_INVALID) || status == -ETIMEDOUT;
+}
+
+void CXLAsync::drain() {
+    if (reactor.joinable()) {
+        std::unique_lock<std::mutex> guard(lock);
+        idle.wait(guard, [this] { return active == 0; });
+        return;
+    }
+    while (outstanding()) {
+        if (!poll() && !wait_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void CXLAsync::wait(const CXLTask& task) {
+    if (reactor.joinable()) {
+        task.wait();
+        return;
+    }
+    while (!task.done()) {
+        if (!poll() && !wait_one()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+size_t CXLAsync::outstanding() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return active;
+}
+
+void CXLAsync::run_reactor() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (!stopping) {
+        if (!active) {
+            work_ready.wait(guard);
+            continue;
+        }
+        guard.unlock();
+        if (!poll() && !wait_one()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(CXL_ASYNC_IDLE_US));
+        }
+        guard.lock();
+    }
+}
@@ -0,0 +1,286 @@
+// CXL Compute Kernels
+// Scale, add, triad, dot and sum with scalar, AVX2/FMA and AVX-512 variants
+
+#include "cxl_compute.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define CXL_SCALAR_KERNEL __attribute__((optimize("no-tree-vectorize")))
+
+CXL_SCALAR_KERNEL static void scale_scalar(float* dst, const float* src, float s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = s * src[i];
+    }
+}
+
+CXL_SCALAR_KERNEL static void add_scalar(float* dst, const float* a, const float* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = a[i] + b[i];
+    }
+}
+
+CXL_SCALAR_KERNEL static void triad_scalar(float* dst, const float* a, const float* b, float s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = a[i] + s * b[i];
+    }
+}
+
+CXL_SCALAR_KERNEL static double dot_scalar(const float* a, const float* b, size_t n) {
+    double acc = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        acc += static_cast<double>(a[i]) * b[i];
+    }
+    return acc;
+}
+
+CXL_SCALAR_KERNEL static double sum_scalar(const float* a, size_t n) {
+    double acc = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        acc += a[i];
+    }
+    return acc;
+}
+
+#if defined(__x86_64__)
+
+// Vector kernels: a 4x unrolled body, a single-vector loop, then a scalar tail.
+// Loads and stores are unaligned since tiles start wherever the caller's arrays do.
+#define CXL_DEFINE_COMPUTE(NAME, TARGET, VEC, LANES, LOADU, STOREU, SET1, MUL, ADD, FMA, HSUM) \
+    __attribute__((target(TARGET)))                                                     \
+    static void scale_##NAME(float* dst, const float* src, float s, size_t n) {         \
+        VEC vs = SET1(s);                                                               \
+        size_t i = 0;                                                                   \
+        for (; i + 4 * LANES <= n; i += 4 * LANES) {                                    \
+            STOREU(dst + i, MUL(vs, LOADU(src + i)));                                   \
+            STOREU(dst + i + LANES, MUL(vs, LOADU(src + i + LANES)));                   \
+            STOREU(dst + i + 2 * LANES, MUL(vs, LOADU(src + i + 2 * LANES)));           \
+            STOREU(dst + i + 3 * LANES, MUL(vs, LOADU(src + i + 3 * LANES)));           \
+        }                                                                               \
+        for (; i + LANES <= n; i += LANES) {                                            \
+            STOREU(dst + i, MUL(vs, LOADU(src + i)));                                   \
+        }                                                                               \
+        scale_scalar(dst + i, src + i, s, n - i);                                       \
+    }                                                                                   \
+    __attribute__((target(TARGET)))                                                     \
+    static void add_##NAME(float* dst, const float* a, const float* b, size_t n) {      \
+        size_t i = 0;                                                                   \
+        for (; i + 4 * LANES <= n; i += 4 * LANES) {                                    \
+            STOREU(dst + i, ADD(LOADU(a + i), LOADU(b + i)));                           \
+            STOREU(dst + i + LANES, ADD(LOADU(a + i + LANES), LOADU(b + i + LANES)));   \
+            STOREU(dst + i + 2 * LANES, ADD(LOADU(a + i + 2 * LANES), LOADU(b + i + 2 * LANES))); \
+            STOREU(dst + i + 3 * LANES, ADD(LOADU(a + i + 3 * LANES), LOADU(b + i + 3 * LANES))); \
+        }                                                                               \
+        for (; i + LANES <= n; i += LANES) {                                            \
+            STOREU(dst + i, ADD(LOADU(a + i), LOADU(b + i)));                           \
+        }                                                                               \
+        add_scalar(dst + i, a + i, b + i, n - i);                                       \
+    }                                                                                   \
+    __attribute__((target(TARGET)))                                                     \
+    static void triad_##NAME(float* dst, const float* a, const float* b, float s, size_t n) { \
+        VEC vs = SET1(s);                                                               \
+        size_t i = 0;                                                                   \
+        for (; i + 4 * LANES <= n; i += 4 * LANES) {                                    \
+            STOREU(dst + i, FMA(vs, LOADU(b + i), LOADU(a + i)));                       \
+            STOREU(dst + i + LANES, FMA(vs, LOADU(b + i + LANES), LOADU(a + i + LANES))); \
+            STOREU(dst + i + 2 * LANES, FMA(vs, LOADU(b + i + 2 * LANES), LOADU(a + i + 2 * LANES))); \
+            STOREU(dst + i + 3 * LANES, FMA(vs, LOADU(b + i + 3 * LANES), LOADU(a + i + 3 * LANES))); \
+        }                                                                               \
+        for (; i + LANES <= n; i += LANES) {                                            \
+            STOREU(dst + i, FMA(vs, LOADU(b + i), LOADU(a + i)));                       \
+        }                                                                               \
+        triad_scalar(dst + i, a + i, b + i, s, n - i);                                  \
+    }                                                                                   \
+    __attribute__((target(TARGET)))                                                     \
+    static double dot_##NAME(const float* a, const float* b, size_t n) {                \
+        VEC acc0 = SET1(0.0f), acc1 = SET1(0.0f), acc2 = SET1(0.0f), acc3 = SET1(0.0f);  \
+        size_t i = 0;                                                                   \
+        for (; i + 4 * LANES <= n; i += 4 * LANES) {                                    \
+            acc0 = FMA(LOADU(a + i), LOADU(b + i), acc0);                               \
+            acc1 = FMA(LOADU(a + i + LANES), LOADU(b + i + LANES), acc1);               \
+            acc2 = FMA(LOADU(a + i + 2 * LANES), LOADU(b + i + 2 * LANES), acc2);       \
+            acc3 = FMA(LOADU(a + i + 3 * LANES), LOADU(b + i + 3 * LANES), acc3);       \
+        }                                                                               \
+        for (; i + LANES <= n; i += LANES) {                                            \
+            acc0 = FMA(LOADU(a + i), LOADU(b + i), acc0);                               \
+        }                                                                               \
+        return HSUM(ADD(ADD(acc0, acc1), ADD(acc2, acc3))) + dot_scalar(a + i, b + i, n - i); \
+    }                                                                                   \
+    __attribute__((target(TARGET)))                                                     \
+    static double sum_##NAME(const float* a, size_t n) {                                \
+        VEC acc0 = SET1(0.0f), acc1 = SET1(0.0f), acc2 = SET1(0.0f), acc3 = SET1(0.0f);  \
+        size_t i = 0;                                                                   \
+        for (; i + 4 * LANES <= n; i += 4 * LANES) {                                    \
+            acc0 = ADD(acc0, LOADU(a + i));                                             \
+            acc1 = ADD(acc1, LOADU(a + i + LANES));                                     \
+            acc2 = ADD(acc2, LOADU(a + i + 2 * LANES));                                 \
+            acc3 = ADD(acc3, LOADU(a + i + 3 * LANES));                                 \
+        }                                                                               \
+        for (; i + LANES <= n; i += LANES) {                                            \
+            acc0 = ADD(acc0, LOADU(a + i));                                             \
+        }                                                                               \
+        return HSUM(ADD(ADD(acc0, acc1), ADD(acc2, acc3))) + sum_scalar(a + i, n - i);   \
+    }
+
+__attribute__((target("avx2,fma")))
+static double hsum_avx2(__m256 v) {
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+// Through memory: GCC's AVX-512 reduction and lane-extract intrinsics trip -Wuninitialized
+__attribute__((target("avx512f")))
+static double hsum_avx512(__m512 v) {
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float total = 0.0f;
+    for (float lane : lanes) {
+        total += lane;
+    }
+    return total;
+}
+
+CXL_DEFINE_COMPUTE(avx2, "avx2,fma", __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+                   _mm256_mul_ps, _mm256_add_ps, _mm256_fmadd_ps, hsum_avx2)
+CXL_DEFINE_COMPUTE(avx512, "avx512f", __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, _mm512_set1_ps,
+                   _mm512_mul_ps, _mm512_add_ps, _mm512_fmadd_ps, hsum_avx512)
+
+#endif // __x86_64__
+
+static const CXLComputeOps compute_table[CXL_COMPUTE_ISA_COUNT] = {
+    { CXL_COMPUTE_ISA_AUTO,   "auto",   nullptr,      nullptr,    nullptr,      nullptr,    nullptr },
+    { CXL_COMPUTE_ISA_SCALAR, "scalar", scale_scalar, add_scalar, triad_scalar, dot_scalar, sum_scalar },
+#if defined(__x86_64__)
+    { CXL_COMPUTE_ISA_AVX2,   "avx2",   scale_avx2,   add_avx2,   triad_avx2,   dot_avx2,   sum_avx2 },
+    { CXL_COMPUTE_ISA_AVX512, "avx512", scale_avx512, add_avx512, triad_avx512, dot_avx512, sum_avx512 },
+#else
+    { CXL_COMPUTE_ISA_AVX2,   "avx2",   nullptr,      nullptr,    nullptr,      nullptr,    nullptr },
+    { CXL_COMPUTE_ISA_AVX512, "avx512", nullptr,      nullptr,    nullptr,      nullptr,    nullptr },
+#endif
+};
+
+bool cxl_compute_isa_supported(int isa) {
+    if (isa < 0 || isa >= CXL_COMPUTE_ISA_COUNT) {
+        return false;
+    }
+    if (isa == CXL_COMPUTE_ISA_AUTO) {
+        return true;
+    }
+    if (!compute_table[isa].scale) {
+        return false;
+    }
+
+#if defined(__x86_64__)
+    switch (isa) {
+        case CXL_COMPUTE_ISA_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case CXL_COMPUTE_ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return true;
+    }
+#else
+    return true;
+#endif
+}
+
+const CXLComputeOps* cxl_compute_ops(int isa) {
+    if (isa == CXL_COMPUTE_ISA_AUTO) {
+        isa = CXL_COMPUTE_ISA_SCALAR;
+        for (int wider : { CXL_COMPUTE_ISA_AVX512, CXL_COMPUTE_ISA_AVX2 }) {
+            if (cxl_compute_isa_supported(wider)) {
+                isa = wider;
+                break;
+            }
+        }
+    }
+    if (!cxl_compute_isa_supported(isa)) {
+        return nullptr;
+    }
+    return &compute_table[isa];
+}
+
+void cxl_compute_cost(int op, double* flops, double* bytes) {
+    // Per element: floating-point operations, and bytes read plus written
+    static const double cost[CXL_COMPUTE_OP_COUNT][2] = {
+        { 1, 8 },   // scale: 1 mul, read src, write dst
+        { 1, 12 },  // add:   1 add, read a and b, write dst
+        { 2, 12 },  // triad: 1 fma, read a and b, write dst
+        { 2, 8 },   // dot:   1 fma, read a and b
+        { 1, 4 },   // sum:   1 add, read a
+    };
+    bool valid = op >= 0 && op < CXL_COMPUTE_OP_COUNT;
+    if (flops) {
+        *flops = valid ? cost[op][0] : 0.0;
+    }
+    if (bytes) {
+        *bytes = valid ? cost[op][1] : 0.0;
+    }
+}
+
+double cxl_compute_run(const CXLComputeOps* ops, int op, float* dst, const float* a,
+                       const float* b, float s, size_t n, size_t tile) {
+    tile = std::max<size_t>(tile, 64);
+    double acc = 0.0;
+
+    for (size_t start = 0; start < n; start += tile) {
+        size_t count = std::min(tile, n - start);
+
+#if defined(__x86_64__)
+        // Pull the next tile of each input in while this one is worked on
+        size_t next = start + tile;
+        if (next < n) {
+            size_t ahead = std::min(tile, n - next);
+            for (size_t i = 0; i < ahead; i += 64 / sizeof(float)) {
+                _mm_prefetch(reinterpret_cast<const char*>(a + next + i), _MM_HINT_T0);
+                if (b) {
+                    _mm_prefetch(reinterpret_cast<const char*>(b + next + i), _MM_HINT_T0);
+                }
+            }
+        }
+#endif
+
+        switch (op) {
+            case CXL_COMPUTE_SCALE:
+                ops->scale(dst + start, a + start, s, count);
+                break;
+            case CXL_COMPUTE_ADD:
+                ops->add(dst + start, a + start, b + start, count);
+                break;
+            case CXL_COMPUTE_TRIAD:
+                ops->triad(dst + start, a + start, b + start, s, count);
+                break;
+            case CXL_COMPUTE_DOT:
+                acc += ops->dot(a + start, b + start, count);
+                break;
+            case CXL_COMPUTE_SUM:
+                acc += ops->sum(a + start, count);
+                break;
+            default:
+                return 0.0;
+        }
+    }
+    return acc;
+}
+
+// C interface for ISA discovery
+
+extern "C" {
+
+int cxl_compute_supported(int isa) {
+    return cxl_compute_isa_supported(isa) ? 1 : 0;
+}
+
+const char* cxl_compute_isa_name(int isa) {
+    if (isa < 0 || isa >= CXL_COMPUTE_ISA_COUNT) {
+        return "invalid";
+    }
+    return compute_table[isa].name;
+}
+
+} // extern "C"
@@ -0,0 +1,133 @@
+// CXL DAX Backends
+// Device-DAX and filesystem-DAX mappings of kernel-managed CXL memory
+
+#include "cxl_dax.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#ifndef MAP_SHARED_VALIDATE
+#define MAP_SHARED_VALIDATE 0x03
+#endif
+#ifndef MAP_SYNC
+#define MAP_SYNC            0x80000
+#endif
+#ifndef STATX_ATTR_DAX
+#define STATX_ATTR_DAX      0x00200000
+#endif
+
+#define DAX_DEFAULT_ALIGN   (2UL << 20)
+
+// First number in a sysfs attribute, or fallback if it is missing
+static long read_sysfs_long(const std::string& path, long fallback) {
+    std::ifstream in(path);
+    long value;
+    if (in >> value) {
+        return value;
+    }
+    return fallback;
+}
+
+static bool is_device_dax(const std::string& sysfs) {
+    char target[256];
+    ssize_t len = readlink((sysfs + "/subsystem").c_str(), target, sizeof(target) - 1);
+    if (len <= 0) {
+        return false;
+    }
+    target[len] = '\0';
+    const char* name = strrchr(target, '/');
+    return strcmp(name ? name + 1 : target, "dax") == 0;
+}
+
+bool cxl_dax_probe(int fd, CXLDaxInfo* info) {
+    info->kind = CXL_DAX_NONE;
+    info->capacity = 0;
+    info->align = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    info->numa_node = -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+
+    if (S_ISCHR(st.st_mode)) {
+        std::string sysfs = "/sys/dev/char/" + std::to_string(major(st.st_rdev)) + ":" +
+                            std::to_string(minor(st.st_rdev));
+        if (!is_device_dax(sysfs)) {
+            return false;
+        }
+        info->kind = CXL_DAX_DEVICE;
+        info->capacity = static_cast<size_t>(read_sysfs_long(sysfs + "/size", 0));
+        // Kernels before align was exposed only created 2MB-aligned devices
+        long align = read_sysfs_long(sysfs + "/align", DAX_DEFAULT_ALIGN);
+        info->align = align > 0 ? static_cast<size_t>(align) : DAX_DEFAULT_ALIGN;
+        info->numa_node = static_cast<int>(read_sysfs_long(sysfs + "/target_node", -1));
+        return true;
+    }
+
+    if (S_ISREG(st.st_mode)) {
+        struct statx stx;
+        if (statx(fd, "", AT_EMPTY_PATH, STATX_BASIC_STATS, &stx) != 0 ||
+            !(stx.stx_attributes_mask & STATX_ATTR_DAX) || !(stx.stx_attributes & STATX_ATTR_DAX)) {
+            return false;
+        }
+        info->kind = CXL_DAX_FS;
+        info->capacity = static_cast<size_t>(st.st_size);
+        info->align = DAX_DEFAULT_ALIGN;
+        return true;
+    }
+    return false;
+}
+
+size_t cxl_dax_map_size(const CXLDaxInfo& info, size_t size) {
+    if (info.kind != CXL_DAX_DEVICE) {
+        return size;
+    }
+    return (size + info.align - 1) / info.align * info.align;
+}
+
+void* cxl_dax_map(int fd, const CXLDaxInfo& info, size_t size) {
+    // Reserve enough address space to place the mapping on an aligned start
+    const size_t align = info.align;
+    void* reserve = mmap(nullptr, size + align, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserve == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    uintptr_t first = reinterpret_cast<uintptr_t>(reserve);
+    uintptr_t start = (first + align - 1) & ~(static_cast<uintptr_t>(align) - 1);
+
+    void* addr = mmap(reinterpret_cast<void*>(start), size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED_VALIDATE | MAP_SYNC | MAP_FIXED, fd, 0);
+    if (addr == MAP_FAILED && (errno == EOPNOTSUPP || errno == EINVAL) && info.kind == CXL_DAX_FS) {
+        // DAX file on a filesystem that can't promise synchronous faults
+        std::cerr << "MAP_SYNC not supported here; metadata updates need msync to be durable" << std::endl;
+        addr = mmap(reinterpret_cast<void*>(start), size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    }
+    if (addr == MAP_FAILED) {
+        int saved = errno;
+        munmap(reserve, size + align);
+        errno = saved;
+        return MAP_FAILED;
+    }
+
+    // Hand back the unaligned head and the tail of the reservation
+    if (start > first) {
+        munmap(reserve, start - first);
+    }
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t end = start + (size + page - 1) / page * page;
+    uintptr_t last = first + size + align;
+    if (last > end) {
+        munmap(reinterpret_cast<void*>(end), last - end);
+    }
+    return addr;
+}
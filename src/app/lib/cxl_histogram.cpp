@@ -0,0 +1,163 @@
+// CXL Latency Histogram
+// HDR-style bucketing, percentile queries, JSON export and TSC calibration
+
+#include "cxl_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// Enough buckets for the full 64-bit range
+static constexpr size_t NUM_BUCKETS =
+    (64 - CXLHistogram::SUB_BUCKET_BITS + 1) * CXLHistogram::SUB_BUCKETS;
+
+CXLHistogram::CXLHistogram() : counts(NUM_BUCKETS, 0), total(0), sum(0),
+                               min_value(UINT64_MAX), max_value(0) {}
+
+void CXLHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+}
+
+size_t CXLHistogram::bucket_index(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    unsigned magnitude = 63 - __builtin_clzll(value);
+    unsigned shift = magnitude - SUB_BUCKET_BITS;
+    return SUB_BUCKETS * (shift + 1) + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t CXLHistogram::bucket_low(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+uint64_t CXLHistogram::bucket_high(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    return bucket_low(index) + ((1ULL << shift) - 1);
+}
+
+void CXLHistogram::record(uint64_t value) {
+    counts[bucket_index(value)]++;
+    total++;
+    sum += value;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+}
+
+void CXLHistogram::merge(const CXLHistogram& other) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    min_value = std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+}
+
+uint64_t CXLHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0;
+    }
+
+    fraction = std::min(std::max(fraction, 0.0), 1.0);
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * total + 0.5));
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            // Report the top of the bucket, clamped to what was actually seen
+            return std::min(bucket_high(i), max_value);
+        }
+    }
+    return max_value;
+}
+
+size_t CXLHistogram::to_json(char* buf, size_t len, const char* unit) const {
+    std::string json;
+    char item[128];
+
+    snprintf(item, sizeof(item),
+             "{\"unit\":\"%s\",\"samples\":%llu,\"min\":%llu,\"mean\":%.2f,\"max\":%llu,",
+             unit, static_cast<unsigned long long>(total),
+             static_cast<unsigned long long>(min()), mean(),
+             static_cast<unsigned long long>(max()));
+    json += item;
+
+    snprintf(item, sizeof(item),
+             "\"percentiles\":{\"50\":%llu,\"90\":%llu,\"99\":%llu,\"99.9\":%llu},",
+             static_cast<unsigned long long>(percentile(0.50)),
+             static_cast<unsigned long long>(percentile(0.90)),
+             static_cast<unsigned long long>(percentile(0.99)),
+             static_cast<unsigned long long>(percentile(0.999)));
+    json += item;
+
+    // Only non-empty buckets, as [low, high, count]
+    json += "\"buckets\":[";
+    bool first = true;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        if (!counts[i]) {
+            continue;
+        }
+        snprintf(item, sizeof(item), "%s[%llu,%llu,%llu]", first ? "" : ",",
+                 static_cast<unsigned long long>(bucket_low(i)),
+                 static_cast<unsigned long long>(bucket_high(i)),
+                 static_cast<unsigned long long>(counts[i]));
+        json += item;
+        first = false;
+    }
+    json += "]}";
+
+    if (buf && len) {
+        size_t n = std::min(json.size(), len - 1);
+        memcpy(buf, json.data(), n);
+        buf[n] = '\0';
+    }
+    return json.size();
+}
+
+double cxl_tsc_ns_per_tick() {
+#if defined(__x86_64__)
+    // Function-local static: calibrated once, thread-safe
+    static const double ns_per_tick = [] {
+        auto wall_start = std::chrono::steady_clock::now();
+        uint64_t tsc_start = cxl_rdtscp();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t tsc_end = cxl_rdtscp();
+        auto wall_end = std::chrono::steady_clock::now();
+
+        std::chrono::duration<double, std::nano> elapsed = wall_end - wall_start;
+        return elapsed.count() / static_cast<double>(tsc_end - tsc_start);
+    }();
+    return ns_per_tick;
+#else
+    return 1.0;
+#endif
+}
+
+uint64_t cxl_tsc_overhead_ticks() {
+    static const uint64_t overhead = [] {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 1000; i++) {
+            uint64_t start = cxl_rdtscp();
+            uint64_t end = cxl_rdtscp();
+            best = std::min(best, end - start);
+        }
+        return best;
+    }();
+    return overhead;
+}
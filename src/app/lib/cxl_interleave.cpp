@@ -0,0 +1,117 @@
+// CXL Device Interleaving
+// One logical region striped over several device mappings
+
+#include "cxl_interleave.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define INTERLEAVE_MIN_GRANULE  4096
+
+// Mappings a region may take: half the process limit, the rest is left to everything else
+static size_t mapping_budget() {
+    std::ifstream in("/proc/sys/vm/max_map_count");
+    size_t limit = 65530;
+    in >> limit;
+    return limit / 2;
+}
+
+std::vector<std::string> cxl_interleave_devices(const char* device_path) {
+    std::vector<std::string> devices;
+    std::stringstream list(device_path ? device_path : "");
+    std::string device;
+    while (std::getline(list, device, ',')) {
+        if (!device.empty()) {
+            devices.push_back(device);
+        }
+    }
+    return devices;
+}
+
+size_t cxl_interleave_granule(size_t requested, size_t size, int ways) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t budget = mapping_budget();
+    if (requested) {
+        if (requested < page) {
+            std::cerr << "Interleave granularity " << requested << " is below the " << page
+                      << "-byte page; sub-page interleaving needs the devices in one hardware-interleaved "
+                      << "CXL region" << std::endl;
+            return 0;
+        }
+        if (requested & (requested - 1)) {
+            std::cerr << "Interleave granularity must be a power of two" << std::endl;
+            return 0;
+        }
+        if ((size + requested - 1) / requested > budget) {
+            std::cerr << "Interleaving " << size << " bytes at " << requested << " takes more than " << budget
+                      << " mappings; use a larger granularity or raise vm.max_map_count" << std::endl;
+            return 0;
+        }
+        return requested;
+    }
+
+    size_t granule = std::max<size_t>(INTERLEAVE_MIN_GRANULE, page);
+    while ((size + granule - 1) / granule > budget) {
+        granule *= 2;
+    }
+    // At least one unit per device
+    while (granule > page && granule * ways > size) {
+        granule /= 2;
+    }
+    return granule;
+}
+
+void* cxl_interleave_map(const std::vector<int>& fds, const CXLInterleave& layout, size_t size) {
+    const int ways = static_cast<int>(fds.size());
+    if (ways < 1 || layout.ways != ways || !layout.granule || size % layout.granule) {
+        errno = EINVAL;
+        return MAP_FAILED;
+    }
+
+    // Regular files fault with SIGBUS past their end, so check them up front
+    for (int fd : fds) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+            static_cast<size_t>(st.st_size) < layout.device_size(size)) {
+            std::cerr << "Interleaved device file holds " << st.st_size << " bytes, "
+                      << layout.device_size(size) << " needed" << std::endl;
+            errno = EINVAL;
+            return MAP_FAILED;
+        }
+    }
+
+    // Start on a stripe unit boundary, which DAX devices require of every mapping
+    void* reserve = mmap(nullptr, size + layout.granule, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                         -1, 0);
+    if (reserve == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    uintptr_t first = reinterpret_cast<uintptr_t>(reserve);
+    uintptr_t aligned = (first + layout.granule - 1) & ~(static_cast<uintptr_t>(layout.granule) - 1);
+    if (aligned > first) {
+        munmap(reserve, aligned - first);
+    }
+    if (first + layout.granule > aligned) {
+        munmap(reinterpret_cast<void*>(aligned + size), first + layout.granule - aligned);
+    }
+    void* base = reinterpret_cast<void*>(aligned);
+    char* start = static_cast<char*>(base);
+    for (size_t offset = 0; offset < size; offset += layout.granule) {
+        void* addr = mmap(start + offset, layout.granule, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                          fds[layout.device_of(offset)], static_cast<off_t>(layout.device_offset(offset)));
+        if (addr == MAP_FAILED) {
+            int saved = errno;
+            munmap(base, size);
+            errno = saved;
+            return MAP_FAILED;
+        }
+    }
+    return base;
+}
@@ -0,0 +1,295 @@
+// CXL Copy/Fill Kernels
+// Scalar, SSE2, AVX2 and AVX-512 variants with temporal and streaming stores,
+// and the cache line flushes used on write-back mappings
+
+#include "cxl_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+static void copy_scalar(void* dst, const void* src, size_t n) {
+    memcpy(dst, src, n);
+}
+
+static void fill_scalar(void* dst, int value, size_t n) {
+    memset(dst, value, n);
+}
+
+#if defined(__x86_64__)
+
+// Vector kernels: scalar head up to destination alignment, a 4x unrolled body
+// with aligned stores, a single-vector loop, then a scalar tail.
+#define CXL_DEFINE_KERNELS(NAME, TARGET, VEC, WIDTH, LOADU, STORE, SET1, FENCE)        \
+    __attribute__((target(TARGET)))                                                     \
+    static void copy_##NAME(void* dst, const void* src, size_t n) {                     \
+        char* d = static_cast<char*>(dst);                                              \
+        const char* s = static_cast<const char*>(src);                                  \
+        size_t head = std::min(n, (WIDTH - reinterpret_cast<uintptr_t>(d) % WIDTH) % WIDTH); \
+        memcpy(d, s, head);                                                             \
+        d += head; s += head; n -= head;                                                \
+        for (; n >= 4 * WIDTH; n -= 4 * WIDTH, d += 4 * WIDTH, s += 4 * WIDTH) {        \
+            VEC v0 = LOADU(s);                                                          \
+            VEC v1 = LOADU(s + WIDTH);                                                  \
+            VEC v2 = LOADU(s + 2 * WIDTH);                                              \
+            VEC v3 = LOADU(s + 3 * WIDTH);                                              \
+            STORE(d, v0);                                                               \
+            STORE(d + WIDTH, v1);                                                       \
+            STORE(d + 2 * WIDTH, v2);                                                   \
+            STORE(d + 3 * WIDTH, v3);                                                   \
+        }                                                                               \
+        for (; n >= WIDTH; n -= WIDTH, d += WIDTH, s += WIDTH) {                        \
+            STORE(d, LOADU(s));                                                         \
+        }                                                                               \
+        FENCE();                                                                        \
+        memcpy(d, s, n);                                                                \
+    }                                                                                   \
+    __attribute__((target(TARGET)))                                                     \
+    static void fill_##NAME(void* dst, int value, size_t n) {                           \
+        char* d = static_cast<char*>(dst);                                              \
+        size_t head = std::min(n, (WIDTH - reinterpret_cast<uintptr_t>(d) % WIDTH) % WIDTH); \
+        memset(d, value, head);                                                         \
+        d += head; n -= head;                                                           \
+        VEC v = SET1(value);                                                            \
+        for (; n >= 4 * WIDTH; n -= 4 * WIDTH, d += 4 * WIDTH) {                        \
+            STORE(d, v);                                                                \
+            STORE(d + WIDTH, v);                                                        \
+            STORE(d + 2 * WIDTH, v);                                                    \
+            STORE(d + 3 * WIDTH, v);                                                    \
+        }                                                                               \
+        for (; n >= WIDTH; n -= WIDTH, d += WIDTH) {                                    \
+            STORE(d, v);                                                                \
+        }                                                                               \
+        FENCE();                                                                        \
+        memset(d, value, n);                                                            \
+    }
+
+#define NO_FENCE() do {} while (0)
+#define SFENCE() _mm_sfence()
+
+#define SSE2_LOADU(p)      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))
+#define SSE2_STORE(p, v)   _mm_store_si128(reinterpret_cast<__m128i*>(p), v)
+#define SSE2_STREAM(p, v)  _mm_stream_si128(reinterpret_cast<__m128i*>(p), v)
+#define SSE2_SET1(c)       _mm_set1_epi8(static_cast<char>(c))
+
+#define AVX2_LOADU(p)      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))
+#define AVX2_STORE(p, v)   _mm256_store_si256(reinterpret_cast<__m256i*>(p), v)
+#define AVX2_STREAM(p, v)  _mm256_stream_si256(reinterpret_cast<__m256i*>(p), v)
+#define AVX2_SET1(c)       _mm256_set1_epi8(static_cast<char>(c))
+
+#define AVX512_LOADU(p)     _mm512_loadu_si512(static_cast<const void*>(p))
+#define AVX512_STORE(p, v)  _mm512_store_si512(static_cast<void*>(p), v)
+#define AVX512_STREAM(p, v) _mm512_stream_si512(reinterpret_cast<__m512i*>(p), v)
+#define AVX512_SET1(c)      _mm512_set1_epi32(static_cast<int>(0x01010101u * static_cast<uint8_t>(c)))
+
+CXL_DEFINE_KERNELS(sse2,      "sse2",    __m128i, 16, SSE2_LOADU,   SSE2_STORE,    SSE2_SET1,   NO_FENCE)
+CXL_DEFINE_KERNELS(sse2_nt,   "sse2",    __m128i, 16, SSE2_LOADU,   SSE2_STREAM,   SSE2_SET1,   SFENCE)
+CXL_DEFINE_KERNELS(avx2,      "avx2",    __m256i, 32, AVX2_LOADU,   AVX2_STORE,    AVX2_SET1,   NO_FENCE)
+CXL_DEFINE_KERNELS(avx2_nt,   "avx2",    __m256i, 32, AVX2_LOADU,   AVX2_STREAM,   AVX2_SET1,   SFENCE)
+CXL_DEFINE_KERNELS(avx512,    "avx512f", __m512i, 64, AVX512_LOADU, AVX512_STORE,  AVX512_SET1, NO_FENCE)
+CXL_DEFINE_KERNELS(avx512_nt, "avx512f", __m512i, 64, AVX512_LOADU, AVX512_STREAM, AVX512_SET1, SFENCE)
+
+#endif // __x86_64__
+
+static const CXLKernelOps kernel_table[CXL_KERNEL_COUNT] = {
+    { CXL_KERNEL_AUTO,      "auto",      nullptr,        nullptr,        false },
+    { CXL_KERNEL_SCALAR,    "scalar",    copy_scalar,    fill_scalar,    false },
+#if defined(__x86_64__)
+    { CXL_KERNEL_SSE2,      "sse2",      copy_sse2,      fill_sse2,      false },
+    { CXL_KERNEL_SSE2_NT,   "sse2-nt",   copy_sse2_nt,   fill_sse2_nt,   true },
+    { CXL_KERNEL_AVX2,      "avx2",      copy_avx2,      fill_avx2,      false },
+    { CXL_KERNEL_AVX2_NT,   "avx2-nt",   copy_avx2_nt,   fill_avx2_nt,   true },
+    { CXL_KERNEL_AVX512,    "avx512",    copy_avx512,    fill_avx512,    false },
+    { CXL_KERNEL_AVX512_NT, "avx512-nt", copy_avx512_nt, fill_avx512_nt, true },
+#else
+    { CXL_KERNEL_SSE2,      "sse2",      nullptr,        nullptr,        false },
+    { CXL_KERNEL_SSE2_NT,   "sse2-nt",   nullptr,        nullptr,        true },
+    { CXL_KERNEL_AVX2,      "avx2",      nullptr,        nullptr,        false },
+    { CXL_KERNEL_AVX2_NT,   "avx2-nt",   nullptr,        nullptr,        true },
+    { CXL_KERNEL_AVX512,    "avx512",    nullptr,        nullptr,        false },
+    { CXL_KERNEL_AVX512_NT, "avx512-nt", nullptr,        nullptr,        true },
+#endif
+};
+
+bool cxl_kernel_is_supported(int kernel) {
+    if (kernel < 0 || kernel >= CXL_KERNEL_COUNT) {
+        return false;
+    }
+    if (kernel == CXL_KERNEL_AUTO) {
+        return true;
+    }
+    if (!kernel_table[kernel].copy) {
+        return false;
+    }
+
+#if defined(__x86_64__)
+    switch (kernel) {
+        case CXL_KERNEL_AVX2:
+        case CXL_KERNEL_AVX2_NT:
+            return __builtin_cpu_supports("avx2");
+        case CXL_KERNEL_AVX512:
+        case CXL_KERNEL_AVX512_NT:
+            return __builtin_cpu_supports("avx512f");
+        default:
+            return true;
+    }
+#else
+    return true;
+#endif
+}
+
+int cxl_kernel_best(bool non_temporal) {
+    static const int preference[][2] = {
+        { CXL_KERNEL_AVX512, CXL_KERNEL_AVX512_NT },
+        { CXL_KERNEL_AVX2,   CXL_KERNEL_AVX2_NT },
+        { CXL_KERNEL_SSE2,   CXL_KERNEL_SSE2_NT },
+    };
+
+    for (const auto& pair : preference) {
+        int kernel = pair[non_temporal ? 1 : 0];
+        if (cxl_kernel_is_supported(kernel)) {
+            return kernel;
+        }
+    }
+    return CXL_KERNEL_SCALAR;
+}
+
+const CXLKernelOps* cxl_kernel_ops(int kernel) {
+    if (kernel == CXL_KERNEL_AUTO) {
+        // Streaming stores are the right default for device memory mapped uncached
+        kernel = cxl_kernel_best(true);
+    }
+    if (!cxl_kernel_is_supported(kernel)) {
+        return nullptr;
+    }
+    return &kernel_table[kernel];
+}
+
+typedef void (*cxl_range_fn)(const void* addr, size_t n, size_t line_size);
+
+// Range flushes: one instruction per line the range touches, four lines per step
+#define CXL_DEFINE_FLUSH(NAME, ATTR, LINE_OP)                                           \
+    ATTR                                                                                \
+    static void NAME(const void* addr, size_t n, size_t line_size) {                    \
+        uintptr_t line = reinterpret_cast<uintptr_t>(addr) & ~(line_size - 1);          \
+        const uintptr_t end = reinterpret_cast<uintptr_t>(addr) + n;                    \
+        for (; line + 4 * line_size <= end; line += 4 * line_size) {                    \
+            LINE_OP(line);                                                              \
+            LINE_OP(line + line_size);                                                  \
+            LINE_OP(line + 2 * line_size);                                              \
+            LINE_OP(line + 3 * line_size);                                              \
+        }                                                                               \
+        for (; line < end; line += line_size) {                                         \
+            LINE_OP(line);                                                              \
+        }                                                                               \
+    }
+
+#if defined(__x86_64__)
+
+#define CLWB_LINE(p)        _mm_clwb(reinterpret_cast<void*>(p))
+#define CLFLUSHOPT_LINE(p)  _mm_clflushopt(reinterpret_cast<void*>(p))
+#define CLFLUSH_LINE(p)     _mm_clflush(reinterpret_cast<void*>(p))
+
+CXL_DEFINE_FLUSH(flush_clwb,       __attribute__((target("clwb"))),       CLWB_LINE)
+CXL_DEFINE_FLUSH(flush_clflushopt, __attribute__((target("clflushopt"))), CLFLUSHOPT_LINE)
+CXL_DEFINE_FLUSH(flush_clflush,    __attribute__((target("sse2"))),       CLFLUSH_LINE)
+
+#elif defined(__aarch64__)
+
+#define DC_CVAC_LINE(p)     asm volatile("dc cvac, %0" : : "r"(p) : "memory")
+#define DC_CIVAC_LINE(p)    asm volatile("dc civac, %0" : : "r"(p) : "memory")
+
+CXL_DEFINE_FLUSH(flush_dc_cvac,  , DC_CVAC_LINE)
+CXL_DEFINE_FLUSH(flush_dc_civac, , DC_CIVAC_LINE)
+
+#endif
+
+struct CXLCacheOps {
+    const char* name;
+    cxl_range_fn writeback;
+    cxl_range_fn invalidate;
+    size_t line_size;
+};
+
+static CXLCacheOps pick_cache_ops() {
+#if defined(__x86_64__)
+    // CPUID.(EAX=7,ECX=0):EBX bit 23 is CLFLUSHOPT, bit 24 CLWB
+    unsigned int eax, ebx = 0, ecx, edx;
+    __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+    bool clflushopt = ebx & (1u << 23);
+    bool clwb = ebx & (1u << 24);
+    cxl_range_fn invalidate = clflushopt ? flush_clflushopt : flush_clflush;
+    if (clwb) {
+        return { "clwb", flush_clwb, invalidate, 64 };
+    }
+    return { clflushopt ? "clflushopt" : "clflush", invalidate, invalidate, 64 };
+#elif defined(__aarch64__)
+    // Smallest data cache line from CTR_EL0.DminLine (log2 words)
+    uint64_t ctr;
+    asm volatile("mrs %0, ctr_el0" : "=r"(ctr));
+    return { "dc cvac", flush_dc_cvac, flush_dc_civac, static_cast<size_t>(4) << ((ctr >> 16) & 0xf) };
+#else
+    return { "none", nullptr, nullptr, 64 };
+#endif
+}
+
+static const CXLCacheOps& cache_ops() {
+    static const CXLCacheOps ops = pick_cache_ops();
+    return ops;
+}
+
+void cxl_cache_writeback(const void* addr, size_t n) {
+    const CXLCacheOps& ops = cache_ops();
+    if (ops.writeback) {
+        ops.writeback(addr, n, ops.line_size);
+    }
+}
+
+void cxl_cache_invalidate(const void* addr, size_t n) {
+    const CXLCacheOps& ops = cache_ops();
+    if (ops.invalidate) {
+        ops.invalidate(addr, n, ops.line_size);
+    }
+}
+
+void cxl_cache_fence(bool full) {
+#if defined(__x86_64__)
+    if (full) {
+        _mm_mfence();
+    } else {
+        _mm_sfence();
+    }
+#elif defined(__aarch64__)
+    (void)full;
+    asm volatile("dsb ish" : : : "memory");
+#else
+    (void)full;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+const char* cxl_cache_flush_name() {
+    return cache_ops().name;
+}
+
+// C interface for kernel discovery
+
+extern "C" {
+
+int cxl_kernel_supported(int kernel) {
+    return cxl_kernel_is_supported(kernel) ? 1 : 0;
+}
+
+const char* cxl_kernel_name(int kernel) {
+    if (kernel < 0 || kernel >= CXL_KERNEL_COUNT) {
+        return "invalid";
+    }
+    return kernel_table[kernel].name;
+}
+
+} // extern "C"
@@ -0,0 +1,194 @@
+// CXL LZ4 Codec
+// LZ4 block compression and bounds-checked decompression
+
+#include "cxl_lz4.h"
+
+#include <cstring>
+
+#define MIN_MATCH       4
+#define LAST_LITERALS   5       // The last five bytes are always literals
+#define MATCH_LIMIT     12      // No match starts in the last twelve bytes
+#define MAX_OFFSET      65535
+#define HASH_BITS       12
+#define SKIP_SHIFT      6       // Search step grows by one every 64 misses
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Token nibble overflow: runs of 255 then the remainder
+static inline uint8_t* write_length(uint8_t* op, size_t length) {
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+// Emit literals [anchor, anchor + literals) and, unless last, a match; returns
+// the new output position or nullptr if the sequence doesn't fit
+static uint8_t* write_sequence(uint8_t* op, uint8_t* out_end, const uint8_t* anchor, size_t literals,
+                               size_t offset, size_t match, bool last) {
+    size_t need = 1 + literals / 255 + 1 + literals + (last ? 0 : 2 + match / 255 + 1);
+    if (need > static_cast<size_t>(out_end - op)) {
+        return nullptr;
+    }
+
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>((literals >= 15 ? 15 : literals) << 4);
+    if (literals >= 15) {
+        op = write_length(op, literals - 15);
+    }
+    memcpy(op, anchor, literals);
+    op += literals;
+    if (last) {
+        return op;
+    }
+
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    match -= MIN_MATCH;
+    *token |= static_cast<uint8_t>(match >= 15 ? 15 : match);
+    if (match >= 15) {
+        op = write_length(op, match - 15);
+    }
+    return op;
+}
+
+size_t cxl_lz4_bound(size_t size) {
+    return size > CXL_LZ4_MAX_INPUT ? 0 : size + size / 255 + 16;
+}
+
+size_t cxl_lz4_compress(const void* src, size_t size, void* dst, size_t capacity) {
+    if (size > CXL_LZ4_MAX_INPUT) {
+        return 0;
+    }
+    const uint8_t* in = static_cast<const uint8_t*>(src);
+    const uint8_t* in_end = in + size;
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    uint8_t* out_end = out + capacity;
+    uint8_t* op = out;
+    const uint8_t* anchor = in;
+
+    if (size > MATCH_LIMIT) {
+        uint32_t table[1 << HASH_BITS] = {};    // Input offset last seen for each hash
+        const uint8_t* match_end_limit = in_end - LAST_LITERALS;
+        const uint8_t* search_limit = in_end - MATCH_LIMIT;
+        const uint8_t* ip = in + 1;
+        table[hash4(read32(in))] = 0;
+
+        while (ip <= search_limit) {
+            uint32_t h = hash4(read32(ip));
+            const uint8_t* ref = in + table[h];
+            table[h] = static_cast<uint32_t>(ip - in);
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != read32(ip)) {
+                ip += 1 + ((ip - anchor) >> SKIP_SHIFT);
+                continue;
+            }
+
+            // Grow the match backwards over pending literals, then forwards
+            while (ip > anchor && ref > in && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t* mp = ip + MIN_MATCH;
+            const uint8_t* rp = ref + MIN_MATCH;
+            while (mp < match_end_limit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+
+            op = write_sequence(op, out_end, anchor, static_cast<size_t>(ip - anchor),
+                                static_cast<size_t>(ip - ref), static_cast<size_t>(mp - ip), false);
+            if (!op) {
+                return 0;
+            }
+            ip = mp;
+            anchor = ip;
+            if (ip - 2 > in && ip <= search_limit) {
+                table[hash4(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - in);
+            }
+        }
+    }
+
+    op = write_sequence(op, out_end, anchor, static_cast<size_t>(in_end - anchor), 0, 0, true);
+    return op ? static_cast<size_t>(op - out) : 0;
+}
+
+int64_t cxl_lz4_decompress(const void* src, size_t size, void* dst, size_t capacity) {
+    const uint8_t* ip = static_cast<const uint8_t*>(src);
+    const uint8_t* in_end = ip + size;
+    uint8_t* out = static_cast<uint8_t*>(dst);
+    uint8_t* op = out;
+    uint8_t* out_end = out + capacity;
+
+    // Lengths past a 15 nibble continue in 255-valued bytes
+    auto read_length = [&](size_t* length) {
+        uint8_t b;
+        do {
+            if (ip >= in_end) {
+                return false;
+            }
+            b = *ip++;
+            *length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    if (!size) {
+        return -1;
+    }
+    while (ip < in_end) {
+        uint8_t token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !read_length(&literals)) {
+            return -1;
+        }
+        if (literals > static_cast<size_t>(in_end - ip) || literals > static_cast<size_t>(out_end - op)) {
+            return -1;
+        }
+        memcpy(op, ip, literals);
+        op += literals;
+        ip += literals;
+        if (ip == in_end) {
+            break;              // The last sequence is literals only
+        }
+
+        if (in_end - ip < 2) {
+            return -1;
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match = token & 15;
+        if (match == 15 && !read_length(&match)) {
+            return -1;
+        }
+        match += MIN_MATCH;
+        if (!offset || offset > static_cast<size_t>(op - out) || match > static_cast<size_t>(out_end - op)) {
+            return -1;
+        }
+
+        // Overlapping matches repeat the last offset bytes; copy in steps that never
+        // read ahead of what has been written
+        const uint8_t* from = op - offset;
+        if (offset >= match) {
+            memcpy(op, from, match);
+        } else if (offset >= 8) {
+            for (size_t i = 0; i < match; i += 8) {
+                memcpy(op + i, from + i, match - i < 8 ? match - i : 8);
+            }
+        } else {
+            for (size_t i = 0; i < match; i++) {
+                op[i] = from[i];
+            }
+        }
+        op += match;
+    }
+    return static_cast<int64_t>(op - out);
+}
@@ -0,0 +1,107 @@
+// CXL NUMA Support
+// Node topology from sysfs and mbind/get_mempolicy without libnuma
+
+#include "cxl_numa.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Parse a sysfs list such as "0-3,8,10-11"
+static std::vector<int> read_list(const std::string& path) {
+    std::vector<int> values;
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        return values;
+    }
+
+    char buf[4096];
+    if (fgets(buf, sizeof(buf), f)) {
+        char* p = buf;
+        while (*p && *p != '\n') {
+            char* end;
+            long first = strtol(p, &end, 10);
+            if (end == p) {
+                break;
+            }
+            long last = first;
+            p = end;
+            if (*p == '-') {
+                last = strtol(p + 1, &end, 10);
+                p = end;
+            }
+            for (long v = first; v <= last; v++) {
+                values.push_back(static_cast<int>(v));
+            }
+            if (*p == ',') {
+                p++;
+            }
+        }
+    }
+    fclose(f);
+    return values;
+}
+
+std::vector<int> cxl_numa_online_nodes() {
+    std::vector<int> nodes = read_list("/sys/devices/system/node/online");
+    if (nodes.empty()) {
+        nodes.push_back(0);
+    }
+    return nodes;
+}
+
+std::vector<int> cxl_numa_node_cpus(int node) {
+    return read_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+}
+
+bool cxl_numa_node_has_memory(int node) {
+    std::vector<int> nodes = read_list("/sys/devices/system/node/has_memory");
+    if (nodes.empty()) {
+        return node == 0;
+    }
+    return std::find(nodes.begin(), nodes.end(), node) != nodes.end();
+}
+
+bool cxl_numa_node_is_cpuless(int node) {
+    return cxl_numa_node_has_memory(node) && cxl_numa_node_cpus(node).empty();
+}
+
+int cxl_numa_cpu_node(int cpu) {
+    if (cpu < 0) {
+        return -1;
+    }
+    for (int node : cxl_numa_online_nodes()) {
+        std::vector<int> cpus = cxl_numa_node_cpus(node);
+        if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+bool cxl_numa_bind(void* addr, size_t length, int node) {
+    if (node < 0) {
+        return false;
+    }
+
+    const size_t bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(node / bits + 1, 0);
+    mask[node / bits] |= 1UL << (node % bits);
+
+    // The kernel counts maxnode one past the last bit it reads
+    long ret = syscall(SYS_mbind, addr, length, MPOL_BIND, mask.data(),
+                       mask.size() * bits + 1, MPOL_MF_STRICT | MPOL_MF_MOVE);
+    return ret == 0;
+}
+
+int cxl_numa_addr_node(const void* addr) {
+    int node = -1;
+    long ret = syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void*>(addr),
+                       MPOL_F_NODE | MPOL_F_ADDR);
+    return ret == 0 ? node : -1;
+}
@@ -0,0 +1,53 @@
+// CXL Access Patterns
+// Slot permutations behind the sequential, strided, random, gather and scatter tests
+
+#include "cxl_pattern.h"
+
+#include <numeric>
+
+CXLAccessPattern::CXLAccessPattern() : random(false), unit(0), count(0), step(1), position(0),
+                                       state(0), mask(0) {}
+
+bool CXLAccessPattern::init(int pattern, size_t span, size_t unit_size, size_t step_units, uint64_t seed) {
+    if (pattern < 0 || pattern >= CXL_PATTERN_COUNT || unit_size == 0 || span < unit_size) {
+        return false;
+    }
+
+    unit = unit_size;
+    count = span / unit_size;
+    random = pattern == CXL_PATTERN_RANDOM || pattern == CXL_PATTERN_GATHER ||
+             pattern == CXL_PATTERN_SCATTER;
+    step = 1;
+    position = 0;
+
+    if (pattern == CXL_PATTERN_STRIDED && count > 1) {
+        // A step sharing a factor with the slot count would revisit a subset forever
+        step = step_units % count ? step_units % count : 1;
+        while (std::gcd(step, count) != 1) {
+            step++;
+        }
+    }
+
+    mask = 1;
+    while (mask < count) {
+        mask <<= 1;
+    }
+    mask -= 1;
+    state = seed & mask;
+    return true;
+}
+
+static const char* pattern_names[CXL_PATTERN_COUNT] = {
+    "sequential", "strided", "random", "gather", "scatter"
+};
+
+extern "C" {
+
+const char* cxl_pattern_name(int pattern) {
+    if (pattern < 0 || pattern >= CXL_PATTERN_COUNT) {
+        return "invalid";
+    }
+    return pattern_names[pattern];
+}
+
+} // extern "C"
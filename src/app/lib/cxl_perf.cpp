@@ -0,0 +1,319 @@
+// CXL Performance Counters
+// perf_event_open core and uncore counters, with sysfs event-name resolution
+
+#include "cxl_perf.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_SYSFS "/sys/bus/event_source/devices"
+#define CXL_PERF_DEFAULT_UNCORE "uncore_imc/cas_count_read/;uncore_imc/cas_count_write/"
+
+static const char* core_names[CXL_PERF_CORE_EVENTS] = { "cycles", "instructions", "LLC-load-misses",
+                                                        "dTLB-load-misses" };
+
+static int perf_event_open(perf_event_attr* attr, pid_t pid, int cpu) {
+    return static_cast<int>(syscall(SYS_perf_event_open, attr, pid, cpu, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+static std::string read_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+static uint64_t cache_config(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+// Value of one counter, scaled up if it was multiplexed off the PMU part of the time
+static uint64_t read_scaled(int fd) {
+    uint64_t values[3] = { 0, 0, 0 };      // value, time enabled, time running
+    if (read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        return 0;
+    }
+    if (values[2] >= values[1]) {
+        return values[0];
+    }
+    return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+}
+
+// CPUs listed in a PMU cpumask ("0", "0,28" or "0-3")
+// pmu itself or a numbered instance pmu_N, but not pmu_free_running_N and the like
+static bool is_pmu_instance(const std::string& name, const std::string& pmu) {
+    if (name == pmu) {
+        return true;
+    }
+    if (name.size() <= pmu.size() + 1 || name.compare(0, pmu.size() + 1, pmu + "_") != 0) {
+        return false;
+    }
+    return name.find_first_not_of("0123456789", pmu.size() + 1) == std::string::npos;
+}
+
+static std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        int lo, hi;
+        int n = sscanf(range.c_str(), "%d-%d", &lo, &hi);
+        if (n == 1) {
+            cpus.push_back(lo);
+        } else if (n == 2) {
+            for (int cpu = lo; cpu <= hi; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+// Place value into attr fields as described by a format file ("config:0-7", "config1:8-15,32-35")
+static bool apply_format(perf_event_attr& attr, const std::string& format, uint64_t value) {
+    size_t colon = format.find(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    std::string field = format.substr(0, colon);
+    uint64_t* target = field == "config" ? reinterpret_cast<uint64_t*>(&attr.config)
+                     : field == "config1" ? reinterpret_cast<uint64_t*>(&attr.config1)
+                     : field == "config2" ? reinterpret_cast<uint64_t*>(&attr.config2) : nullptr;
+    if (!target) {
+        return false;
+    }
+
+    std::stringstream ranges(format.substr(colon + 1));
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        int lo, hi;
+        int n = sscanf(range.c_str(), "%d-%d", &lo, &hi);
+        if (n == 1) {
+            hi = lo;
+        } else if (n != 2 || lo < 0 || hi > 63 || lo > hi) {
+            return false;
+        }
+        int width = hi - lo + 1;
+        uint64_t bits = width == 64 ? value : value & ((1ULL << width) - 1);
+        *target |= bits << lo;
+        value = width == 64 ? 0 : value >> width;
+    }
+    return true;
+}
+
+// Fill attr.config* from "event=0x04,umask=0x03" style terms using the PMU's format directory
+static bool apply_terms(perf_event_attr& attr, const std::string& pmu, const std::string& terms) {
+    std::stringstream in(terms);
+    std::string term;
+    while (std::getline(in, term, ',')) {
+        if (term.empty()) {
+            continue;
+        }
+        size_t eq = term.find('=');
+        std::string key = term.substr(0, eq);
+        uint64_t value = eq == std::string::npos ? 1 : strtoull(term.c_str() + eq + 1, nullptr, 0);
+        std::string format = read_line(PERF_SYSFS "/" + pmu + "/format/" + key);
+        if (format.empty() || !apply_format(attr, format, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+CXLPerfCounters::CXLPerfCounters() : opened(false), valid(0) {
+    for (int& fd : core_fds) {
+        fd = -1;
+    }
+}
+
+CXLPerfCounters::~CXLPerfCounters() {
+    close();
+}
+
+uint32_t CXLPerfCounters::open(const char* uncore_events) {
+    close();
+
+    const std::pair<uint32_t, uint64_t> core[CXL_PERF_CORE_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+                                           PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        { PERF_TYPE_HW_CACHE, cache_config(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                           PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    };
+    int core_errno = 0;
+    for (int i = 0; i < CXL_PERF_CORE_EVENTS; i++) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = core[i].first;
+        attr.config = core[i].second;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        core_fds[i] = perf_event_open(&attr, 0, -1);
+        if (core_fds[i] >= 0) {
+            valid |= 1u << i;
+        } else if (!core_errno) {
+            core_errno = errno;
+        }
+    }
+
+    // The default list is best effort; events asked for by name are reported when missing
+    bool quiet = uncore_events == nullptr;
+    std::stringstream list(uncore_events ? uncore_events : CXL_PERF_DEFAULT_UNCORE);
+    std::string spec;
+    while (std::getline(list, spec, ';')) {
+        if (!spec.empty() && uncore.size() < CXL_PERF_MAX_UNCORE && !open_uncore(spec, quiet) && !quiet) {
+            std::cerr << "Uncore event " << spec << " unavailable" << std::endl;
+        }
+    }
+
+    opened = valid != 0 || !uncore.empty();
+    if (!opened) {
+        std::cerr << "No performance counters available (" << core_names[0] << ": "
+                  << strerror(core_errno) << ")" << std::endl;
+    }
+    return valid;
+}
+
+bool CXLPerfCounters::open_uncore(const std::string& spec, bool quiet) {
+    // "pmu/event/" with the event an alias or a list of format terms
+    size_t slash = spec.find('/');
+    if (slash == std::string::npos || slash == 0) {
+        return false;
+    }
+    std::string pmu = spec.substr(0, slash);
+    std::string event = spec.substr(slash + 1);
+    if (!event.empty() && event.back() == '/') {
+        event.pop_back();
+    }
+
+    // Every instance: the PMU itself, or pmu_0, pmu_1, ...
+    std::vector<std::string> instances;
+    if (DIR* dir = opendir(PERF_SYSFS)) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if (is_pmu_instance(name, pmu)) {
+                instances.push_back(name);
+            }
+        }
+        closedir(dir);
+    }
+
+    Uncore counter;
+    counter.name = pmu + "/" + event + "/";
+    for (const std::string& instance : instances) {
+        std::string base = PERF_SYSFS "/" + instance;
+        std::string type = read_line(base + "/type");
+        std::string alias = read_line(base + "/events/" + event);
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = static_cast<uint32_t>(strtoul(type.c_str(), nullptr, 10));
+        attr.disabled = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        if (type.empty() || !apply_terms(attr, instance, alias.empty() ? event : alias)) {
+            continue;
+        }
+
+        std::vector<int> cpus = parse_cpulist(read_line(base + "/cpumask"));
+        if (cpus.empty()) {
+            cpus.push_back(0);
+        }
+        for (int cpu : cpus) {
+            int fd = perf_event_open(&attr, -1, cpu);
+            if (fd >= 0) {
+                counter.fds.push_back(fd);
+            } else if (!quiet) {
+                std::cerr << "Opening " << instance << "/" << event << "/ on CPU " << cpu << ": "
+                          << strerror(errno) << std::endl;
+            }
+        }
+    }
+
+    if (counter.fds.empty()) {
+        return false;
+    }
+    uncore.push_back(counter);
+    return true;
+}
+
+void CXLPerfCounters::close() {
+    for (int& fd : core_fds) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    for (Uncore& u : uncore) {
+        for (int fd : u.fds) {
+            ::close(fd);
+        }
+    }
+    uncore.clear();
+    valid = 0;
+    opened = false;
+}
+
+void CXLPerfCounters::start() {
+    auto each = [this](unsigned long request) {
+        for (int fd : core_fds) {
+            if (fd >= 0) {
+                ioctl(fd, request, 0);
+            }
+        }
+        for (Uncore& u : uncore) {
+            for (int fd : u.fds) {
+                ioctl(fd, request, 0);
+            }
+        }
+    };
+    each(PERF_EVENT_IOC_RESET);
+    started = std::chrono::steady_clock::now();
+    each(PERF_EVENT_IOC_ENABLE);
+}
+
+void CXLPerfCounters::stop(cxl_perf_counters* out) {
+    for (int fd : core_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (Uncore& u : uncore) {
+        for (int fd : u.fds) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    memset(out, 0, sizeof(*out));
+    out->valid = valid;
+    out->seconds = elapsed.count();
+    uint64_t* core_values[CXL_PERF_CORE_EVENTS] = { &out->cycles, &out->instructions, &out->llc_misses,
+                                                    &out->dtlb_misses };
+    for (int i = 0; i < CXL_PERF_CORE_EVENTS; i++) {
+        if (core_fds[i] >= 0) {
+            *core_values[i] = read_scaled(core_fds[i]);
+        }
+    }
+    for (const Uncore& u : uncore) {
+        int slot = out->num_uncore++;
+        snprintf(out->uncore_name[slot], CXL_PERF_NAME_MAX, "%s", u.name.c_str());
+        for (int fd : u.fds) {
+            out->uncore_count[slot] += read_scaled(fd);
+        }
+    }
+}
@@ -0,0 +1,447 @@
+// CXL Region Header
+// Superblock, region id and named-object table shared by every process mapping a device
+
+#include "cxl_region.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "cxl_kernels.h"
+
+#define REGION_PAGE 4096
+
+// The first layout: one header, unchecked, with the directory right after it
+struct region_header_v1 {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t region_id;
+    uint64_t region_size;
+    uint32_t lock;
+    uint32_t generation;
+    uint32_t num_objects;
+    uint32_t reserved[7];
+    struct {
+        char name[CXL_OBJECT_NAME_MAX + 1];
+        uint64_t offset;
+        uint64_t length;
+    } entries[CXL_REGION_DIR_ENTRIES];
+};
+
+static_assert(sizeof(region_header_v1) <= CXL_REGION_HEADER_SIZE, "v1 header too large");
+
+// CRC-32C (Castagnoli), with the SSE4.2 instruction where the CPU has it
+static const uint32_t* crc32c_table() {
+    static uint32_t table[256];
+    static bool built = [] {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+            }
+            table[i] = crc;
+        }
+        return true;
+    }();
+    (void)built;
+    return table;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char* p, size_t n) {
+    uint64_t crc64 = crc;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; n; n--, p++) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+    return crc;
+}
+#endif
+
+static uint32_t crc32c(const void* data, size_t n, uint32_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint32_t crc = ~seed;
+#if defined(__x86_64__)
+    static const bool hardware = __builtin_cpu_supports("sse4.2");
+    if (hardware) {
+        return ~crc32c_sse42(crc, p, n);
+    }
+#endif
+    const uint32_t* table = crc32c_table();
+    for (; n; n--, p++) {
+        crc = (crc >> 8) ^ table[(crc ^ *p) & 0xFF];
+    }
+    return ~crc;
+}
+
+// Push an update out of the CPU cache; a no-op on uncached mappings
+static void persist(const void* addr, size_t length) {
+    cxl_cache_writeback(addr, length);
+    cxl_cache_fence(false);
+}
+
+static uint32_t super_checksum(const cxl_region_superblock& super) {
+    return crc32c(&super, offsetof(cxl_region_superblock, checksum), 0);
+}
+
+static bool super_valid(const cxl_region_superblock& super) {
+    return super.magic == CXL_REGION_MAGIC && super.version == CXL_REGION_VERSION &&
+           super.checksum == super_checksum(super);
+}
+
+static uint64_t round_up(uint64_t value, uint64_t unit) {
+    return (value + unit - 1) / unit * unit;
+}
+
+CXLObjectDirectory::CXLObjectDirectory()
+    : header(nullptr), super(), mapped_size(0), formatted(false), repaired(0) {}
+
+bool CXLObjectDirectory::fits(size_t size) {
+    return size >= 2 * CXL_REGION_HEADER_SIZE;
+}
+
+bool CXLObjectDirectory::attach(void* region, size_t size, size_t scratch_size, bool format_region) {
+    detach();
+    if (!region || !fits(size)) {
+        return false;
+    }
+
+    header = static_cast<cxl_region_header*>(region);
+    mapped_size = size;
+    if (format_region) {
+        format(size, scratch_size, 0, {});
+        return true;
+    }
+
+    // Every layout starts with the magic and its version, the first one included
+    cxl_region_superblock copies[CXL_REGION_COPIES];
+    bool marked = false;
+    for (int i = 0; i < CXL_REGION_COPIES; i++) {
+        memcpy(&copies[i], &header->copies[i].super, sizeof(copies[i]));
+        marked = marked || copies[i].magic == CXL_REGION_MAGIC;
+    }
+    if (!marked) {
+        format(size, scratch_size, 0, {});
+        return true;
+    }
+    if (copies[0].magic == CXL_REGION_MAGIC && copies[0].version == 1) {
+        upgrade(size, scratch_size);
+        return true;
+    }
+
+    int best = -1;
+    for (int i = 0; i < CXL_REGION_COPIES; i++) {
+        if (copies[i].magic == CXL_REGION_MAGIC && copies[i].version > CXL_REGION_VERSION) {
+            std::cerr << "Region layout version " << copies[i].version << " is newer than this library ("
+                      << CXL_REGION_VERSION << ")" << std::endl;
+            header = nullptr;
+            return false;
+        }
+        if (super_valid(copies[i]) && (best < 0 || copies[i].sequence > copies[best].sequence)) {
+            best = i;
+        }
+    }
+    if (best < 0) {
+        std::cerr << "Region header is damaged: no superblock copy passes its checksum "
+                  << "(CXL_INIT_FORMAT starts the region over)" << std::endl;
+        header = nullptr;
+        return false;
+    }
+    super = copies[best];
+    if (super.header_size != CXL_REGION_HEADER_SIZE ||
+        super.table_offset != offsetof(cxl_region_header, entries) ||
+        super.table_entries != CXL_REGION_DIR_ENTRIES || super.entry_size != sizeof(cxl_region_dir_entry) ||
+        super.region_id == 0 || super.region_id > 0xFFFF) {
+        std::cerr << "Region superblock describes a layout this library cannot read" << std::endl;
+        header = nullptr;
+        return false;
+    }
+
+    // Bring a damaged or stale copy back in line with the intact one
+    for (int i = 0; i < CXL_REGION_COPIES; i++) {
+        if (memcmp(&copies[i], &super, sizeof(super)) != 0) {
+            write_copy(i, super);
+            repaired++;
+        }
+    }
+    return true;
+}
+
+void CXLObjectDirectory::detach() {
+    header = nullptr;
+    super = cxl_region_superblock();
+    mapped_size = 0;
+    formatted = false;
+    repaired = 0;
+}
+
+// Write one superblock copy with its magic last, so a torn write never looks intact
+void CXLObjectDirectory::write_copy(int index, const cxl_region_superblock& copy) {
+    cxl_region_superblock* target = &header->copies[index].super;
+    __atomic_store_n(&target->magic, 0, __ATOMIC_RELEASE);
+    persist(&target->magic, sizeof(target->magic));
+    memcpy(reinterpret_cast<char*>(target) + sizeof(target->magic),
+           reinterpret_cast<const char*>(&copy) + sizeof(copy.magic), sizeof(copy) - sizeof(copy.magic));
+    persist(target, sizeof(*target));
+    __atomic_store_n(&target->magic, copy.magic, __ATOMIC_RELEASE);
+    persist(&target->magic, sizeof(target->magic));
+}
+
+// Only the first process to map a blank region gets here; opening one from two
+// processes at the same instant is not supported. keep holds objects carried
+// over from an older layout, which the scratch extent is placed around.
+void CXLObjectDirectory::format(size_t size, size_t scratch_size, uint32_t id,
+                                const std::vector<cxl_region_dir_entry>& keep) {
+    // Unmark the region first: a format cut short leaves it blank, never half-written
+    for (auto& copy : header->copies) {
+        __atomic_store_n(&copy.super.magic, 0, __ATOMIC_RELEASE);
+    }
+    persist(header->copies, sizeof(header->copies));
+    memset(&header->lock, 0, sizeof(*header) - offsetof(cxl_region_header, lock));
+
+    if (id == 0) {
+        std::random_device rd;
+        do {
+            id = rd() & 0xFFFF;
+        } while (id == 0);
+    }
+    super = cxl_region_superblock();
+    super.magic = CXL_REGION_MAGIC;
+    super.version = CXL_REGION_VERSION;
+    super.region_id = id;
+    super.sequence = 1;
+    super.region_size = size;
+    super.header_size = CXL_REGION_HEADER_SIZE;
+    super.table_offset = offsetof(cxl_region_header, entries);
+    super.table_entries = CXL_REGION_DIR_ENTRIES;
+    super.entry_size = sizeof(cxl_region_dir_entry);
+
+    size_t slot = 0;
+    for (const cxl_region_dir_entry& entry : keep) {
+        if (slot < CXL_REGION_DIR_ENTRIES) {
+            header->entries[slot] = entry;
+            header->entries[slot].reserved = 0;
+            header->entries[slot].checksum = entry_checksum(entry);
+            slot++;
+        }
+    }
+    persist(&header->lock, sizeof(*header) - offsetof(cxl_region_header, lock));
+
+    // Scratch: the requested size (CXL_SCRATCH_ALL = everything past the header,
+    // 0 = half the region) in the first gap between the kept objects that holds
+    // it, or the largest gap if none does
+    const uint64_t area = size - CXL_REGION_HEADER_SIZE;
+    uint64_t want = scratch_size == CXL_SCRATCH_ALL ? area : scratch_size ? round_up(scratch_size, REGION_PAGE)
+                                                                        : area / 2 / REGION_PAGE * REGION_PAGE;
+    want = std::min(want, area);
+    std::vector<std::pair<uint64_t, uint64_t>> used;
+    for (const cxl_region_dir_entry& entry : keep) {
+        used.emplace_back(entry.offset, round_up(entry.offset + entry.length, REGION_PAGE));
+    }
+    std::sort(used.begin(), used.end());
+    used.emplace_back(size, size);
+    uint64_t cursor = CXL_REGION_HEADER_SIZE, best_start = cursor, best_length = 0;
+    for (const auto& object : used) {
+        uint64_t gap = object.first > cursor ? object.first - cursor : 0;
+        if (gap >= want) {
+            best_start = cursor;
+            best_length = want;
+            break;
+        }
+        if (gap > best_length) {
+            best_start = cursor;
+            best_length = gap;
+        }
+        cursor = std::max(cursor, object.second);
+    }
+    super.scratch_offset = best_start;
+    super.scratch_size = best_length;
+    super.checksum = super_checksum(super);
+
+    for (int i = 0; i < CXL_REGION_COPIES; i++) {
+        write_copy(i, super);
+    }
+    formatted = true;
+}
+
+// Rewrite a version 1 header in place, keeping its id and objects. The old
+// header overlaps the new one, so this is the one update a crash can lose.
+void CXLObjectDirectory::upgrade(size_t size, size_t scratch_size) {
+    const region_header_v1* old = reinterpret_cast<const region_header_v1*>(header);
+    std::vector<cxl_region_dir_entry> keep;
+    for (const auto& entry : old->entries) {
+        if (entry.name[0] != '\0' && entry.offset >= CXL_REGION_HEADER_SIZE && entry.offset < size &&
+            entry.length <= size - entry.offset) {
+            cxl_region_dir_entry kept = {};
+            memcpy(kept.name, entry.name, sizeof(kept.name));
+            kept.name[sizeof(kept.name) - 1] = '\0';
+            kept.offset = entry.offset;
+            kept.length = entry.length;
+            keep.push_back(kept);
+        }
+    }
+    uint32_t id = old->region_id <= 0xFFFF ? old->region_id : 0;
+    format(size, scratch_size, id, keep);
+}
+
+uint32_t CXLObjectDirectory::entry_checksum(const cxl_region_dir_entry& entry) const {
+    uint32_t sum = crc32c(&entry, offsetof(cxl_region_dir_entry, checksum), super.region_id);
+    return sum ? sum : 1;
+}
+
+bool CXLObjectDirectory::entry_valid(const cxl_region_dir_entry& entry) const {
+    return entry.name[0] != '\0' && entry.checksum == entry_checksum(entry);
+}
+
+uint16_t CXLObjectDirectory::region_id() const {
+    return header ? static_cast<uint16_t>(super.region_id) : 0;
+}
+
+uint64_t CXLObjectDirectory::scratch_offset() const {
+    return std::min<uint64_t>(super.scratch_offset, mapped_size);
+}
+
+uint64_t CXLObjectDirectory::scratch_size() const {
+    return std::min<uint64_t>(super.scratch_size, mapped_size - scratch_offset());
+}
+
+void CXLObjectDirectory::get_info(cxl_region_info* info) const {
+    memset(info, 0, sizeof(*info));
+    if (!header) {
+        return;
+    }
+    info->version = super.version;
+    info->region_id = static_cast<uint16_t>(super.region_id);
+    for (const cxl_region_dir_entry& entry : header->entries) {
+        info->objects += entry_valid(entry) ? 1 : 0;
+    }
+    info->max_objects = CXL_REGION_DIR_ENTRIES;
+    info->scratch_offset = scratch_offset();
+    info->scratch_size = scratch_size();
+    info->formatted = formatted ? 1 : 0;
+    info->repaired = repaired;
+}
+
+uint32_t CXLObjectDirectory::generation() const {
+    return header ? __atomic_load_n(&header->generation, __ATOMIC_ACQUIRE) : 0;
+}
+
+void CXLObjectDirectory::lock() {
+    const uint32_t self = static_cast<uint32_t>(getpid());
+    for (unsigned spins = 0;; spins++) {
+        uint32_t owner = 0;
+        if (__atomic_compare_exchange_n(&header->lock, &owner, self, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+
+        // Take over a lock whose holder exited without releasing it
+        if (kill(static_cast<pid_t>(owner), 0) != 0 && errno == ESRCH &&
+            __atomic_compare_exchange_n(&header->lock, &owner, self, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return;
+        }
+        if (spins > 64) {
+            sched_yield();
+        }
+    }
+}
+
+void CXLObjectDirectory::unlock() {
+    __atomic_store_n(&header->lock, 0, __ATOMIC_RELEASE);
+}
+
+bool CXLObjectDirectory::insert(const char* name, uint64_t offset, uint64_t length) {
+    cxl_region_dir_entry* slot = nullptr;
+    for (cxl_region_dir_entry& entry : header->entries) {
+        if (!entry_valid(entry)) {
+            slot = slot ? slot : &entry;
+        } else if (strncmp(entry.name, name, sizeof(entry.name)) == 0) {
+            return false;
+        }
+    }
+    if (!slot) {
+        return false;
+    }
+
+    // The entry counts once its checksum lands, so that goes in last
+    cxl_region_dir_entry staged = {};
+    strncpy(staged.name, name, sizeof(staged.name) - 1);
+    staged.offset = offset;
+    staged.length = length;
+    staged.checksum = entry_checksum(staged);
+    __atomic_store_n(&slot->checksum, 0, __ATOMIC_RELEASE);
+    memcpy(slot, &staged, offsetof(cxl_region_dir_entry, checksum));
+    persist(slot, sizeof(*slot));
+    __atomic_store_n(&slot->checksum, staged.checksum, __ATOMIC_RELEASE);
+    persist(&slot->checksum, sizeof(slot->checksum));
+    __atomic_add_fetch(&header->generation, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool CXLObjectDirectory::find(const char* name, uint64_t* offset, uint64_t* length) const {
+    for (const cxl_region_dir_entry& entry : header->entries) {
+        if (entry_valid(entry) && strncmp(entry.name, name, sizeof(entry.name)) == 0) {
+            *offset = entry.offset;
+            *length = entry.length;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CXLObjectDirectory::remove(const char* name, uint64_t* offset) {
+    for (cxl_region_dir_entry& entry : header->entries) {
+        if (entry_valid(entry) && strncmp(entry.name, name, sizeof(entry.name)) == 0) {
+            *offset = entry.offset;
+            // Invalid from the first store on, then cleared
+            __atomic_store_n(&entry.checksum, 0, __ATOMIC_RELEASE);
+            persist(&entry.checksum, sizeof(entry.checksum));
+            memset(&entry, 0, sizeof(entry));
+            persist(&entry, sizeof(entry));
+            __atomic_add_fetch(&header->generation, 1, __ATOMIC_RELEASE);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> CXLObjectDirectory::extents() const {
+    std::vector<std::pair<uint64_t, uint64_t>> result;
+    for (const cxl_region_dir_entry& entry : header->entries) {
+        if (entry_valid(entry)) {
+            result.emplace_back(entry.offset, entry.length);
+        }
+    }
+    return result;
+}
+
+uint32_t CXLObjectDirectory::scrub() {
+    uint32_t cleared = 0;
+    for (cxl_region_dir_entry& entry : header->entries) {
+        if ((entry.name[0] != '\0' || entry.checksum != 0) && !entry_valid(entry)) {
+            memset(&entry, 0, sizeof(entry));
+            persist(&entry, sizeof(entry));
+            cleared++;
+        }
+    }
+    repaired += cleared;
+    return cleared;
+}
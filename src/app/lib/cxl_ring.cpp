@@ -0,0 +1,277 @@
+// CXL Command Ring
+// Batched command submission and syscall-free completion reaping
+
+#include "cxl_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#define RING_BACKLOG_US 10     // Pause while the driver has yet to take a command
+
+static uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+CXLCommandRing::CXLCommandRing() : fd(-1), ring(nullptr), map_size(0), slots() {
+    reset_stats();
+}
+
+CXLCommandRing::~CXLCommandRing() {
+    close();
+}
+
+bool CXLCommandRing::open(int device_fd) {
+    close();
+
+    struct cxl_ring_setup setup;
+    if (ioctl(device_fd, CXL_MEM_RING_SETUP, &setup) != 0) {
+        return false;
+    }
+    if (setup.entries != CXL_RING_ENTRIES || setup.mmap_size < sizeof(struct cxl_ring)) {
+        return false;
+    }
+
+    void* addr = mmap(nullptr, setup.mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      device_fd, static_cast<off_t>(setup.mmap_offset));
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    fd = device_fd;
+    ring = static_cast<struct cxl_ring*>(addr);
+    map_size = setup.mmap_size;
+    return true;
+}
+
+void CXLCommandRing::close() {
+    if (ring) {
+        munmap(ring, map_size);
+        ring = nullptr;
+        map_size = 0;
+    }
+    fd = -1;
+}
+
+int CXLCommandRing::submit(const struct cxl_ring_sqe* cmds, int count) {
+    if (!ring || !cmds || count <= 0) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(submit_lock);
+
+    uint32_t tail = ring->sq.tail;
+    uint32_t head = __atomic_load_n(&ring->sq.head, __ATOMIC_ACQUIRE);
+    uint32_t space = CXL_RING_ENTRIES - (tail - head);
+    int posted = std::min<int>(count, static_cast<int>(space));
+
+    const uint64_t start = now_ns();
+    for (int i = 0; i < posted; i++) {
+        ring->sqes[(tail + i) & (CXL_RING_ENTRIES - 1)] = cmds[i];
+        slots[cmds[i].id & (CXL_RING_ENTRIES - 1)] = { cmds[i].id, cmds[i].opcode, cmds[i].length, start };
+    }
+    submitted.fetch_add(posted, std::memory_order_relaxed);
+
+    // Entries must be visible before the driver sees the new tail
+    __atomic_store_n(&ring->sq.tail, tail + posted, __ATOMIC_RELEASE);
+
+    // Once the tail is published the entries are live: a failed doorbell leaves
+    // them for the next enter, so they still count as posted (errno says why)
+    if (posted > 0 && ioctl(fd, CXL_MEM_RING_ENTER, 0) < 0 && errno != EINTR) {
+        std::cerr << "Ring doorbell failed: " << strerror(errno) << std::endl;
+    }
+    return posted;
+}
+
+int CXLCommandRing::reap(struct cxl_ring_cqe* out, int max) {
+    if (!ring || !out || max <= 0) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(reap_lock);
+
+    // Completions collect() set aside come first
+    int reaped = std::min<int>(max, static_cast<int>(held.size()));
+    std::copy(held.begin(), held.begin() + reaped, out);
+    held.erase(held.begin(), held.begin() + reaped);
+
+    uint32_t head = ring->cq.head;
+    uint32_t tail = __atomic_load_n(&ring->cq.tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail && reaped < max) {
+        out[reaped] = ring->cqes[head & (CXL_RING_ENTRIES - 1)];
+        account(out[reaped]);
+        head++;
+        if (!abandoned.erase(out[reaped].id)) {
+            reaped++;
+        }
+    }
+
+    // Hand the slots back to the driver, which may now take SQEs it left behind
+    __atomic_store_n(&ring->cq.head, head, __ATOMIC_RELEASE);
+    if (enter() < 0) {
+        return -1;
+    }
+    return reaped;
+}
+
+int CXLCommandRing::enter() {
+    if (ring->sq.head == __atomic_load_n(&ring->sq.tail, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    return ioctl(fd, CXL_MEM_RING_ENTER, 0) < 0 ? -1 : 0;
+}
+
+int CXLCommandRing::collect(const uint32_t* ids, int count, struct cxl_ring_cqe* out,
+                            uint32_t timeout_ms) {
+    if (!ring || !ids || !out || count <= 0) {
+        return -EINVAL;
+    }
+
+    std::vector<char> done(count, 0);
+    int remaining = count;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    auto take = [&](const struct cxl_ring_cqe& cqe) {
+        for (int i = 0; i < count; i++) {
+            if (!done[i] && ids[i] == cqe.id) {
+                out[i] = cqe;
+                done[i] = 1;
+                remaining--;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (remaining) {
+        {
+            std::lock_guard<std::mutex> guard(reap_lock);
+
+            for (auto it = held.begin(); it != held.end() && remaining;) {
+                it = take(*it) ? held.erase(it) : it + 1;
+            }
+
+            uint32_t head = ring->cq.head;
+            uint32_t tail = __atomic_load_n(&ring->cq.tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const struct cxl_ring_cqe& cqe = ring->cqes[head & (CXL_RING_ENTRIES - 1)];
+                account(cqe);
+                if (!take(cqe) && !abandoned.erase(cqe.id)) {
+                    held.push_back(cqe);
+                }
+            }
+            __atomic_store_n(&ring->cq.head, head, __ATOMIC_RELEASE);
+        }
+
+        if (!remaining) {
+            break;
+        }
+        if (enter() < 0) {
+            return -errno;
+        }
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+            return -ETIMEDOUT;
+        }
+
+        // Sleep on the oldest outstanding command instead of spinning on the CQ;
+        // its CQE is posted before the waiter is woken
+        int next = static_cast<int>(std::find(done.begin(), done.end(), 0) - done.begin());
+        struct cxl_ring_cqe cqe;
+        int ret = wait(ids[next], static_cast<uint32_t>(left), &cqe);
+        if (ret != 0 && ret != -EINTR) {
+            return ret;
+        }
+        if (ret == 0 && cqe.status == CXL_CMD_STATUS_INVALID) {
+            // Still in the SQ (or rejected, with its CQE on the way): nothing to sleep on yet
+            std::this_thread::sleep_for(std::chrono::microseconds(RING_BACKLOG_US));
+        }
+    }
+    return 0;
+}
+
+void CXLCommandRing::abandon(const uint32_t* ids, int count) {
+    std::lock_guard<std::mutex> guard(reap_lock);
+    for (int i = 0; i < count; i++) {
+        abandoned.insert(ids[i]);
+    }
+    // Some may already have been set aside by another collect()
+    for (auto it = held.begin(); it != held.end();) {
+        it = abandoned.erase(it->id) ? held.erase(it) : it + 1;
+    }
+}
+
+int CXLCommandRing::wait(uint32_t id, uint32_t timeout_ms, struct cxl_ring_cqe* out) {
+    if (!ring) {
+        return -ENXIO;
+    }
+
+    struct cxl_mem_wait_cmd request = {};
+    request.id = id;
+    request.timeout_ms = timeout_ms;
+    if (ioctl(fd, CXL_MEM_WAIT_CMD, &request) != 0) {
+        return -errno;
+    }
+
+    if (out) {
+        out->id = request.id;
+        out->status = request.status;
+        out->result = request.result;
+    }
+    return 0;
+}
+
+void CXLCommandRing::account(const struct cxl_ring_cqe& cqe) {
+    const Posted& slot = slots[cqe.id & (CXL_RING_ENTRIES - 1)];
+    bool ok = cqe.status == CXL_CMD_STATUS_COMPLETED;
+    (ok ? completed : failed).fetch_add(1, std::memory_order_relaxed);
+
+    // Commands posted some other way have no matching slot
+    if (slot.id != cqe.id || !slot.start_ns) {
+        return;
+    }
+    if (ok && slot.opcode <= CMD_ACCELERATE) {
+        bytes[slot.opcode].fetch_add(slot.length, std::memory_order_relaxed);
+    }
+    uint64_t elapsed = now_ns() - slot.start_ns;
+    latency_count.fetch_add(1, std::memory_order_relaxed);
+    latency_total_ns.fetch_add(elapsed, std::memory_order_relaxed);
+    uint64_t max = latency_max_ns.load(std::memory_order_relaxed);
+    while (elapsed > max && !latency_max_ns.compare_exchange_weak(max, elapsed, std::memory_order_relaxed)) {
+    }
+}
+
+void CXLCommandRing::add_stats(CXLRingStats* stats) const {
+    stats->submitted += submitted.load(std::memory_order_relaxed);
+    stats->completed += completed.load(std::memory_order_relaxed);
+    stats->failed += failed.load(std::memory_order_relaxed);
+    stats->latency_count += latency_count.load(std::memory_order_relaxed);
+    stats->latency_total_ns += latency_total_ns.load(std::memory_order_relaxed);
+    stats->latency_max_ns = std::max(stats->latency_max_ns, latency_max_ns.load(std::memory_order_relaxed));
+    for (int op = 0; op <= CMD_ACCELERATE; op++) {
+        stats->bytes[op] += bytes[op].load(std::memory_order_relaxed);
+    }
+}
+
+void CXLCommandRing::reset_stats() {
+    submitted.store(0, std::memory_order_relaxed);
+    completed.store(0, std::memory_order_relaxed);
+    failed.store(0, std::memory_order_relaxed);
+    latency_count.store(0, std::memory_order_relaxed);
+    latency_total_ns.store(0, std::memory_order_relaxed);
+    latency_max_ns.store(0, std::memory_order_relaxed);
+    for (auto& count : bytes) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,84 @@
+// CXL Simulation Model
+// Injected access latency and a shared bandwidth-limited link
+
+#include "cxl_sim_model.h"
+#include "cxl_histogram.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+CXLSimModel::CXLSimModel() : enabled(false), latency(0.0), bandwidth(0.0),
+                             latency_ticks(0), link_free_ns(0) {}
+
+void CXLSimModel::reset() {
+    enabled = false;
+    latency = 0.0;
+    bandwidth = 0.0;
+    latency_ticks = 0;
+    link_free_ns.store(0, std::memory_order_relaxed);
+}
+
+bool CXLSimModel::load(const char* device_path) {
+    reset();
+
+    std::string path = std::string(device_path) + ".model";
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+        return false;
+    }
+
+    char key[64];
+    double value;
+    while (fscanf(f, "%63s %lf", key, &value) == 2) {
+        if (strcmp(key, "latency_ns") == 0) {
+            latency = std::max(value, 0.0);
+        } else if (strcmp(key, "bandwidth_gbps") == 0) {
+            bandwidth = std::max(value, 0.0);
+        }
+    }
+    fclose(f);
+
+    latency_ticks = static_cast<uint64_t>(latency / cxl_tsc_ns_per_tick());
+    enabled = latency > 0.0 || bandwidth > 0.0;
+    return enabled;
+}
+
+void CXLSimModel::add_link(const CXLSimModel& other) {
+    bandwidth = bandwidth > 0.0 && other.bandwidth > 0.0 ? bandwidth + other.bandwidth : 0.0;
+    latency = std::max(latency, other.latency);
+    latency_ticks = static_cast<uint64_t>(latency / cxl_tsc_ns_per_tick());
+    enabled = latency > 0.0 || bandwidth > 0.0;
+}
+
+void CXLSimModel::spin(uint64_t ticks) {
+    uint64_t start = cxl_rdtscp();
+    while (cxl_rdtscp() - start < ticks) {
+    }
+}
+
+void CXLSimModel::transfer(size_t bytes, std::chrono::steady_clock::time_point start) {
+    using namespace std::chrono;
+
+    int64_t begin = duration_cast<nanoseconds>(start.time_since_epoch()).count();
+    int64_t done = begin;
+
+    if (bandwidth > 0.0) {
+        // Bandwidth is in the same 2^30-byte GB/s the tests report
+        int64_t busy = static_cast<int64_t>(bytes / (bandwidth * 1.073741824));
+
+        // Queue behind whatever else is on the link
+        int64_t free_at = link_free_ns.load(std::memory_order_relaxed);
+        int64_t slot;
+        do {
+            slot = std::max(begin, free_at);
+        } while (!link_free_ns.compare_exchange_weak(free_at, slot + busy,
+                                                     std::memory_order_relaxed));
+        done = slot + busy;
+    }
+    done += static_cast<int64_t>(latency);
+
+    while (duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count() < done) {
+    }
+}
@@ -0,0 +1,661 @@
+// CXL Memory Tiering
+// Hot/cold chunk migration between a local DRAM pool and a CXL extent
+
+#include "cxl_tier.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "cxl_kernels.h"
+#include "cxl_numa.h"
+
+#define CXL_TIER_DEFAULT_GRANULE    (2UL << 20)
+#define CXL_TIER_MAX_INSTANCES      16
+#define CXL_TIER_IDLE_SAMPLES       8       // Pages sampled per chunk through page_idle
+#define CXL_TIER_HEAT_SCALE         64      // Heat added by a scan that saw every sample touched
+#define CXL_TIER_PROMOTE_MARGIN     (CXL_TIER_HEAT_SCALE / 2)   // Hysteresis for a DRAM/CXL swap
+#define CXL_TIER_DRAM_RESERVE_DIV   32      // Keep 1/32 of DRAM free by demoting idle chunks
+
+#define PAGEMAP_PRESENT             (1ULL << 63)
+#define PAGEMAP_PFN_MASK            ((1ULL << 55) - 1)
+
+// Tiers whose faults the SIGSEGV handler resolves
+static std::atomic<CXLTierManager*> tier_registry[CXL_TIER_MAX_INSTANCES];
+static std::mutex registry_lock;
+static int registry_users = 0;
+static struct sigaction previous_segv;
+
+static void tier_fault(int sig, siginfo_t* info, void* context) {
+    int saved_errno = errno;
+    for (auto& entry : tier_registry) {
+        CXLTierManager* tier = entry.load(std::memory_order_acquire);
+        if (tier && tier->handle_fault(info->si_addr)) {
+            errno = saved_errno;
+            return;
+        }
+    }
+    errno = saved_errno;
+
+    // Not tiered memory: whatever was installed before us decides
+    if (previous_segv.sa_flags & SA_SIGINFO) {
+        previous_segv.sa_sigaction(sig, info, context);
+    } else if (previous_segv.sa_handler != SIG_DFL && previous_segv.sa_handler != SIG_IGN) {
+        previous_segv.sa_handler(sig);
+    } else {
+        // Returning re-runs the access, which now takes the default action
+        signal(sig, SIG_DFL);
+    }
+}
+
+static bool register_tier(CXLTierManager* tier) {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (auto& entry : tier_registry) {
+        if (entry.load() == nullptr) {
+            if (registry_users == 0) {
+                struct sigaction action;
+                memset(&action, 0, sizeof(action));
+                action.sa_sigaction = tier_fault;
+                action.sa_flags = SA_SIGINFO | SA_RESTART;
+                sigemptyset(&action.sa_mask);
+                if (sigaction(SIGSEGV, &action, &previous_segv) != 0) {
+                    return false;
+                }
+            }
+            registry_users++;
+            entry.store(tier, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void unregister_tier(CXLTierManager* tier) {
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (auto& entry : tier_registry) {
+        if (entry.load() == tier) {
+            entry.store(nullptr, std::memory_order_release);
+            if (--registry_users == 0) {
+                sigaction(SIGSEGV, &previous_segv, nullptr);
+            }
+            return;
+        }
+    }
+}
+
+static bool is_power_of_two(size_t v) {
+    return v && !(v & (v - 1));
+}
+
+CXLTierManager::CXLTierManager() : dram_fd(-1), cxl_fd(-1), cxl_offset(0), dram_view(nullptr), cxl_view(nullptr),
+                                   reservation(nullptr), reserved_bytes(0), base(nullptr), granule(0),
+                                   num_chunks(0), slots{ 0, 0 },
+                                   heat_source(CXL_TIER_HEAT_NONE), pagemap_fd(-1), idle_fd(-1), idle_tracked{ true, true },
+                                   migrate_mbps(0.0),
+                                   stats(), hint_faults(0), stopping(false), interval_ms(0), registered(false) {}
+
+CXLTierManager::~CXLTierManager() {
+    shutdown();
+}
+
+bool CXLTierManager::init(int device_fd, size_t device_offset, void* device_view, const cxl_tier_config& config) {
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    granule = config.granule ? config.granule : CXL_TIER_DEFAULT_GRANULE;
+    if (!is_power_of_two(granule) || granule < page || device_offset % page) {
+        std::cerr << "Tier granule must be a power of two of at least " << page << " bytes" << std::endl;
+        return false;
+    }
+    slots[CXL_TIER_DRAM] = static_cast<uint32_t>(config.dram_bytes / granule);
+    slots[CXL_TIER_CXL] = static_cast<uint32_t>(config.cxl_bytes / granule);
+    if (slots[CXL_TIER_DRAM] == 0 || slots[CXL_TIER_CXL] < 2) {
+        std::cerr << "Tiers need at least one DRAM and two CXL granules" << std::endl;
+        return false;
+    }
+
+    // DRAM pool: a memfd, so its pages can be mapped anywhere in the tiered range
+    dram_fd = memfd_create("hermes-cxl-tier", MFD_CLOEXEC);
+    size_t dram_bytes = static_cast<size_t>(slots[CXL_TIER_DRAM]) * granule;
+    if (dram_fd < 0 || ftruncate(dram_fd, static_cast<off_t>(dram_bytes)) != 0) {
+        std::cerr << "Failed to create the DRAM tier: " << strerror(errno) << std::endl;
+        shutdown();
+        return false;
+    }
+    void* view = mmap(nullptr, dram_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, dram_fd, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map the DRAM tier: " << strerror(errno) << std::endl;
+        shutdown();
+        return false;
+    }
+    dram_view = static_cast<char*>(view);
+    // The policy belongs to the memfd, so it also covers the tiered mappings of it
+    if (config.dram_node >= 0 && !cxl_numa_bind(dram_view, dram_bytes, config.dram_node)) {
+        std::cerr << "Failed to bind the DRAM tier to node " << config.dram_node << ": "
+                  << strerror(errno) << std::endl;
+        shutdown();
+        return false;
+    }
+    cxl_fd = device_fd;
+    cxl_offset = device_offset;
+    cxl_view = static_cast<char*>(device_view);
+
+    // Twice the backing in address space, since large objects are rounded to powers of two
+    size_t range = 2 * (static_cast<size_t>(slots[CXL_TIER_DRAM]) + slots[CXL_TIER_CXL]) * granule;
+    reserved_bytes = range + granule;
+    reservation = mmap(nullptr, reserved_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reservation == MAP_FAILED) {
+        std::cerr << "Failed to reserve the tiered address range: " << strerror(errno) << std::endl;
+        reservation = nullptr;
+        shutdown();
+        return false;
+    }
+    base = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(reservation) + granule - 1) & ~(granule - 1));
+    num_chunks = range / granule;
+    chunks.reset(new Chunk[num_chunks]);
+    for (size_t i = 0; i < num_chunks; i++) {
+        chunks[i].state.store(CHUNK_UNBACKED, std::memory_order_relaxed);
+        chunks[i].touched.store(0, std::memory_order_relaxed);
+        chunks[i].refs = 0;
+        chunks[i].tier = -1;
+        chunks[i].slot = 0;
+        chunks[i].heat = 0;
+    }
+    allocator.init(0, range);
+    for (int tier = 0; tier < 2; tier++) {
+        // Popped from the back, so slots are handed out in ascending order
+        for (uint32_t slot = slots[tier]; slot > 0; slot--) {
+            free_slots[tier].push_back(slot - 1);
+        }
+    }
+
+    heat_source = config.heat_source;
+    idle_tracked[CXL_TIER_DRAM] = idle_tracked[CXL_TIER_CXL] = true;
+    if (heat_source == CXL_TIER_HEAT_AUTO) {
+        heat_source = idle_available() ? CXL_TIER_HEAT_IDLE : CXL_TIER_HEAT_FAULT;
+    } else if (heat_source == CXL_TIER_HEAT_IDLE && !idle_available()) {
+        std::cerr << "Idle page tracking is unavailable (needs CONFIG_IDLE_PAGE_TRACKING and root)" << std::endl;
+        shutdown();
+        return false;
+    } else if (heat_source < CXL_TIER_HEAT_AUTO || heat_source > CXL_TIER_HEAT_NONE) {
+        std::cerr << "Invalid tier heat source" << std::endl;
+        shutdown();
+        return false;
+    }
+
+    // Migration relies on the fault handler even when nothing is sampled through it
+    if (!register_tier(this)) {
+        std::cerr << "Failed to install the tier fault handler" << std::endl;
+        shutdown();
+        return false;
+    }
+    registered = true;
+
+    memset(&stats, 0, sizeof(stats));
+    migrate_mbps = config.migrate_mbps;
+    interval_ms = config.interval_ms;
+    last_scan = std::chrono::steady_clock::now();
+    stopping = false;
+    if (interval_ms && heat_source != CXL_TIER_HEAT_NONE) {
+        worker = std::thread(&CXLTierManager::scanner, this);
+    }
+    return true;
+}
+
+void CXLTierManager::shutdown() {
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(worker_lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+    if (registered) {
+        unregister_tier(this);
+        registered = false;
+    }
+    if (reservation) {
+        munmap(reservation, reserved_bytes);
+        reservation = nullptr;
+        base = nullptr;
+    }
+    if (dram_view) {
+        munmap(dram_view, static_cast<size_t>(slots[CXL_TIER_DRAM]) * granule);
+        dram_view = nullptr;
+    }
+    for (int* fd : { &dram_fd, &pagemap_fd, &idle_fd }) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    cxl_fd = -1;
+    cxl_view = nullptr;
+    chunks.reset();
+    num_chunks = 0;
+    free_slots[0].clear();
+    free_slots[1].clear();
+    objects.clear();
+    allocator.reset();
+}
+
+bool CXLTierManager::idle_available() {
+    pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    idle_fd = open("/sys/kernel/mm/page_idle/bitmap", O_RDWR | O_CLOEXEC);
+    if (pagemap_fd >= 0 && idle_fd >= 0) {
+        // Without CAP_SYS_ADMIN pagemap reads back zero frame numbers
+        volatile uint64_t probe = 1;
+        uint64_t entry = 0;
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        off_t at = static_cast<off_t>(reinterpret_cast<uintptr_t>(&probe) / page * sizeof(entry));
+        if (pread(pagemap_fd, &entry, sizeof(entry), at) == sizeof(entry) && (entry & PAGEMAP_PFN_MASK)) {
+            return true;
+        }
+    }
+    for (int* fd : { &pagemap_fd, &idle_fd }) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    return false;
+}
+
+// CXL_TIER_CXL keeps one slot back for swaps unless spare is set
+bool CXLTierManager::take_slot(int tier, bool spare, uint32_t* slot) {
+    std::vector<uint32_t>& pool = free_slots[tier];
+    if (pool.empty() || (tier == CXL_TIER_CXL && !spare && pool.size() < 2)) {
+        return false;
+    }
+    *slot = pool.back();
+    pool.pop_back();
+    return true;
+}
+
+bool CXLTierManager::map_slot(size_t index, int tier, uint32_t slot) {
+    int fd = tier == CXL_TIER_DRAM ? dram_fd : cxl_fd;
+    size_t offset = (tier == CXL_TIER_DRAM ? 0 : cxl_offset) + static_cast<size_t>(slot) * granule;
+    void* addr = mmap(chunk_addr(index), granule, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+                      static_cast<off_t>(offset));
+    return addr != MAP_FAILED;
+}
+
+// Give a chunk's slot back and leave a PROT_NONE placeholder, so stray accesses still fault
+void CXLTierManager::unback(size_t index) {
+    Chunk& chunk = chunks[index];
+    uint32_t state;
+    while ((state = chunk.state.load(std::memory_order_acquire)) == CHUNK_UNPROTECTING ||
+           !chunk.state.compare_exchange_weak(state, CHUNK_UNBACKED)) {
+        sched_yield();
+    }
+    mmap(chunk_addr(index), granule, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    if (chunk.tier == CXL_TIER_DRAM) {
+        fallocate(dram_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(chunk.slot) * static_cast<off_t>(granule), static_cast<off_t>(granule));
+    }
+    free_slots[chunk.tier].push_back(chunk.slot);
+    chunk.tier = -1;
+    chunk.heat = 0;
+}
+
+// Copy a chunk into a slot of the target tier and remap it there; lock held
+bool CXLTierManager::move_chunk(size_t index, int target) {
+    Chunk& chunk = chunks[index];
+    if (chunk.tier == target) {
+        return true;
+    }
+    uint32_t slot;
+    if (!take_slot(target, true, &slot)) {
+        return false;
+    }
+
+    // Writers wait in the fault handler from here until the new mapping is in place
+    uint32_t state;
+    while (((state = chunk.state.load(std::memory_order_acquire)) != CHUNK_RESIDENT && state != CHUNK_SAMPLING) ||
+           !chunk.state.compare_exchange_weak(state, CHUNK_MIGRATING)) {
+        sched_yield();
+    }
+    char* addr = chunk_addr(index);
+    mprotect(addr, granule, PROT_READ);
+
+    static const CXLKernelOps* ops = cxl_kernel_ops(cxl_kernel_best(true));
+    if (ops) {
+        ops->copy(slot_addr(target, slot), addr, granule);
+    } else {
+        memcpy(slot_addr(target, slot), addr, granule);
+    }
+    if (!map_slot(index, target, slot)) {
+        std::cerr << "Failed to remap a tiered chunk: " << strerror(errno) << std::endl;
+        mprotect(addr, granule, PROT_READ | PROT_WRITE);
+        chunk.state.store(CHUNK_RESIDENT, std::memory_order_release);
+        free_slots[target].push_back(slot);
+        return false;
+    }
+
+    // The old pages are unmapped now; DRAM ones are handed back to the kernel
+    if (chunk.tier == CXL_TIER_DRAM) {
+        fallocate(dram_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(chunk.slot) * static_cast<off_t>(granule), static_cast<off_t>(granule));
+    }
+    free_slots[chunk.tier].push_back(chunk.slot);
+    chunk.tier = target;
+    chunk.slot = slot;
+    chunk.touched.store(0, std::memory_order_relaxed);
+    chunk.state.store(CHUNK_RESIDENT, std::memory_order_release);
+
+    if (target == CXL_TIER_DRAM) {
+        stats.promotions++;
+    } else {
+        stats.demotions++;
+    }
+    stats.bytes_migrated += granule;
+    return true;
+}
+
+bool CXLTierManager::handle_fault(void* addr) {
+    char* p = static_cast<char*>(addr);
+    if (!base || p < base || p >= base + num_chunks * granule) {
+        return false;
+    }
+    size_t index = static_cast<size_t>(p - base) / granule;
+    Chunk& chunk = chunks[index];
+    for (;;) {
+        uint32_t state = chunk.state.load(std::memory_order_acquire);
+        switch (state) {
+        case CHUNK_UNBACKED:
+            return false;
+        case CHUNK_RESIDENT:
+            // Reopened by another thread since this one faulted
+            return true;
+        case CHUNK_SAMPLING:
+            if (chunk.state.compare_exchange_weak(state, CHUNK_UNPROTECTING)) {
+                mprotect(chunk_addr(index), granule, PROT_READ | PROT_WRITE);
+                chunk.touched.fetch_add(1, std::memory_order_relaxed);
+                hint_faults.fetch_add(1, std::memory_order_relaxed);
+                chunk.state.store(CHUNK_RESIDENT, std::memory_order_release);
+                return true;
+            }
+            break;
+        default:
+            // Being reopened or migrated
+            sched_yield();
+            break;
+        }
+    }
+}
+
+void* CXLTierManager::allocate(size_t size, int placement) {
+    if (size == 0 || placement < CXL_TIER_DRAM || placement > CXL_TIER_AUTO) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    size_t offset;
+    if (!base || !allocator.allocate(size, 0, &offset)) {
+        return nullptr;
+    }
+
+    size_t first = offset / granule;
+    size_t last = (offset + size - 1) / granule;
+    for (size_t i = first; i <= last; i++) {
+        Chunk& chunk = chunks[i];
+        if (chunk.refs == 0) {
+            int preferred = placement == CXL_TIER_CXL ? CXL_TIER_CXL : CXL_TIER_DRAM;
+            int tier = preferred;
+            uint32_t slot;
+            bool found = take_slot(tier, false, &slot);
+            if (!found) {
+                tier = preferred == CXL_TIER_DRAM ? CXL_TIER_CXL : CXL_TIER_DRAM;
+                found = take_slot(tier, false, &slot);
+            }
+            if (!found || !map_slot(i, tier, slot)) {
+                if (found) {
+                    free_slots[tier].push_back(slot);
+                }
+                // Undo the chunks this allocation backed or pinned so far
+                for (size_t j = first; j < i; j++) {
+                    if (--chunks[j].refs == 0) {
+                        unback(j);
+                    }
+                }
+                allocator.release(offset);
+                std::cerr << "Tiered memory is full" << std::endl;
+                return nullptr;
+            }
+            chunk.tier = tier;
+            chunk.slot = slot;
+            chunk.heat = 0;
+            chunk.touched.store(0, std::memory_order_relaxed);
+            chunk.state.store(CHUNK_RESIDENT, std::memory_order_release);
+        }
+        chunk.refs++;
+    }
+    objects[offset] = size;
+    return base + offset;
+}
+
+bool CXLTierManager::release(void* ptr) {
+    std::lock_guard<std::mutex> guard(lock);
+    char* p = static_cast<char*>(ptr);
+    if (!base || p < base || p >= base + num_chunks * granule) {
+        return false;
+    }
+    size_t offset = static_cast<size_t>(p - base);
+    auto it = objects.find(offset);
+    if (it == objects.end()) {
+        return false;
+    }
+    size_t last = (offset + it->second - 1) / granule;
+    for (size_t i = offset / granule; i <= last; i++) {
+        if (--chunks[i].refs == 0) {
+            unback(i);
+        }
+    }
+    objects.erase(it);
+    allocator.release(offset);
+    return true;
+}
+
+int CXLTierManager::where(const void* ptr) {
+    std::lock_guard<std::mutex> guard(lock);
+    const char* p = static_cast<const char*>(ptr);
+    if (!base || p < base || p >= base + num_chunks * granule) {
+        return -1;
+    }
+    const Chunk& chunk = chunks[static_cast<size_t>(p - base) / granule];
+    return chunk.refs ? chunk.tier : -1;
+}
+
+int CXLTierManager::migrate_range(const void* ptr, size_t length, int target) {
+    if (target != CXL_TIER_DRAM && target != CXL_TIER_CXL) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    const char* p = static_cast<const char*>(ptr);
+    if (!base || length == 0 || p < base || length > static_cast<size_t>(base + num_chunks * granule - p)) {
+        return -1;
+    }
+
+    size_t first = static_cast<size_t>(p - base) / granule;
+    size_t last = (static_cast<size_t>(p - base) + length - 1) / granule;
+    int moved = 0;
+    for (size_t i = first; i <= last; i++) {
+        Chunk& chunk = chunks[i];
+        if (chunk.refs == 0) {
+            return -1;
+        }
+        if (chunk.tier == target) {
+            continue;
+        }
+        // Explicit moves into CXL leave the swap slot alone
+        if (target == CXL_TIER_CXL && free_slots[CXL_TIER_CXL].size() < 2) {
+            return -1;
+        }
+        if (!move_chunk(i, target)) {
+            return -1;
+        }
+        moved++;
+    }
+    return moved;
+}
+
+// Heat seen in one chunk since the last scan, 0..CXL_TIER_HEAT_SCALE
+uint32_t CXLTierManager::sample_chunk(size_t index) {
+    Chunk& chunk = chunks[index];
+    if (heat_source == CXL_TIER_HEAT_FAULT || !idle_tracked[chunk.tier]) {
+        return sample_faults(index);
+    }
+
+    // Idle bits: a page the kernel still reports idle was not accessed since we marked it
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t samples = std::min<size_t>(CXL_TIER_IDLE_SAMPLES, granule / page);
+    size_t spacing = granule / samples;
+    uint32_t accessed = 0;
+    size_t marked = 0, kept = 0;
+    for (size_t k = 0; k < samples; k++) {
+        uintptr_t va = reinterpret_cast<uintptr_t>(chunk_addr(index) + k * spacing);
+        uint64_t entry = 0;
+        if (pread(pagemap_fd, &entry, sizeof(entry), static_cast<off_t>(va / page * sizeof(entry))) !=
+                sizeof(entry) || !(entry & PAGEMAP_PRESENT) || !(entry & PAGEMAP_PFN_MASK)) {
+            continue;
+        }
+        uint64_t pfn = entry & PAGEMAP_PFN_MASK;
+        off_t word_at = static_cast<off_t>(pfn / 64 * sizeof(uint64_t));
+        uint64_t word = 0;
+        if (pread(idle_fd, &word, sizeof(word), word_at) != sizeof(word)) {
+            continue;
+        }
+        uint64_t bit = 1ULL << (pfn % 64);
+        if (!(word & bit)) {
+            accessed++;
+        }
+        if (pwrite(idle_fd, &bit, sizeof(bit), word_at) != sizeof(bit)) {
+            continue;
+        }
+        marked++;
+        if (pread(idle_fd, &word, sizeof(word), word_at) == sizeof(word) && (word & bit)) {
+            kept++;
+        }
+    }
+
+    // Pages off the LRU (BAR PFNs, ZONE_DEVICE) never keep the bit and would
+    // look touched on every scan; the DRAM pool is shmem and always tracked
+    if (chunk.tier == CXL_TIER_CXL && marked && !kept) {
+        std::cerr << "CXL tier pages are not tracked by page_idle; sampling them with hinting faults" << std::endl;
+        idle_tracked[CXL_TIER_CXL] = false;
+        return sample_faults(index);
+    }
+    return static_cast<uint32_t>(accessed * CXL_TIER_HEAT_SCALE / samples);
+}
+
+// Heat from hinting faults: whether the chunk was touched since it was last protected
+uint32_t CXLTierManager::sample_faults(size_t index) {
+    Chunk& chunk = chunks[index];
+    uint32_t touched = chunk.touched.exchange(0, std::memory_order_relaxed);
+    // Protect it again; the first touch before the next scan is counted
+    uint32_t state = CHUNK_RESIDENT;
+    if (chunk.state.compare_exchange_strong(state, CHUNK_SAMPLING)) {
+        mprotect(chunk_addr(index), granule, PROT_NONE);
+    }
+    return touched ? CXL_TIER_HEAT_SCALE : 0;
+}
+
+int CXLTierManager::scan() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!base || heat_source == CXL_TIER_HEAT_NONE) {
+        return base ? 0 : -1;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::min(std::chrono::duration<double>(now - last_scan).count(), 1.0);
+    last_scan = now;
+    double budget = migrate_mbps > 0.0 ? migrate_mbps * 1e6 * elapsed : 1e300;
+    auto spend = [&budget](double bytes) {
+        if (budget < bytes) {
+            return false;
+        }
+        budget -= bytes;
+        return true;
+    };
+
+    std::vector<size_t> hot, cold;
+    for (size_t i = 0; i < num_chunks; i++) {
+        Chunk& chunk = chunks[i];
+        if (!chunk.refs) {
+            continue;
+        }
+        chunk.heat = chunk.heat / 2 + sample_chunk(i);
+        if (chunk.tier == CXL_TIER_CXL && chunk.heat) {
+            hot.push_back(i);
+        } else if (chunk.tier == CXL_TIER_DRAM) {
+            cold.push_back(i);
+        }
+    }
+    stats.scans++;
+    std::sort(hot.begin(), hot.end(), [this](size_t a, size_t b) { return chunks[a].heat > chunks[b].heat; });
+    std::sort(cold.begin(), cold.end(), [this](size_t a, size_t b) { return chunks[a].heat < chunks[b].heat; });
+
+    // Hottest CXL chunks first: into free DRAM, else in exchange for a clearly colder DRAM chunk
+    int moved = 0;
+    size_t next_cold = 0;
+    for (size_t h : hot) {
+        if (!free_slots[CXL_TIER_DRAM].empty()) {
+            if (!spend(granule) || !move_chunk(h, CXL_TIER_DRAM)) {
+                break;
+            }
+            moved++;
+            continue;
+        }
+        if (next_cold == cold.size() ||
+            chunks[h].heat <= chunks[cold[next_cold]].heat + CXL_TIER_PROMOTE_MARGIN || !spend(2.0 * granule)) {
+            break;
+        }
+        if (!move_chunk(cold[next_cold++], CXL_TIER_CXL)) {
+            break;
+        }
+        moved++;
+        if (!move_chunk(h, CXL_TIER_DRAM)) {
+            break;
+        }
+        moved++;
+    }
+
+    // Keep some DRAM free for new allocations by pushing idle chunks out
+    size_t reserve = std::max<size_t>(1, slots[CXL_TIER_DRAM] / CXL_TIER_DRAM_RESERVE_DIV);
+    while (free_slots[CXL_TIER_DRAM].size() < reserve && next_cold < cold.size() &&
+           chunks[cold[next_cold]].heat == 0 && free_slots[CXL_TIER_CXL].size() > 1 && spend(granule)) {
+        if (!move_chunk(cold[next_cold++], CXL_TIER_CXL)) {
+            break;
+        }
+        moved++;
+    }
+    return moved;
+}
+
+void CXLTierManager::scanner() {
+    std::unique_lock<std::mutex> guard(worker_lock);
+    while (!stopping) {
+        if (wake.wait_for(guard, std::chrono::milliseconds(interval_ms), [this] { return stopping; })) {
+            break;
+        }
+        guard.unlock();
+        scan();
+        guard.lock();
+    }
+}
+
+void CXLTierManager::get_stats(cxl_tier_stats* out) {
+    std::lock_guard<std::mutex> guard(lock);
+    *out = stats;
+    out->granule = granule;
+    out->dram_capacity = static_cast<size_t>(slots[CXL_TIER_DRAM]) * granule;
+    out->cxl_capacity = static_cast<size_t>(slots[CXL_TIER_CXL]) * granule;
+    out->dram_used = (slots[CXL_TIER_DRAM] - free_slots[CXL_TIER_DRAM].size()) * granule;
+    out->cxl_used = (slots[CXL_TIER_CXL] - free_slots[CXL_TIER_CXL].size()) * granule;
+    out->heat_source = heat_source;
+    out->hint_faults = hint_faults.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,217 @@
+// CXL Compressed Object Store
+// LZ4-compressed objects in the region with a DRAM index
+
+#include "cxl_zstore.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "cxl_lz4.h"
+
+#define ZSTORE_DEFAULT_RATIO  1.1
+#define ZSTORE_STAGING_KEEP   (64UL << 20)  // Larger staging buffers are freed after use
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+// Per-thread scratch for compressed bytes on their way in or out
+static char* staging_buffer(std::vector<char>& staging, size_t size) {
+    if (staging.size() < size) {
+        staging.resize(size);
+    }
+    return staging.data();
+}
+
+static void trim_staging(std::vector<char>& staging) {
+    if (staging.size() > ZSTORE_STAGING_KEEP) {
+        std::vector<char>().swap(staging);
+    }
+}
+
+CXLCompressedStore::CXLCompressedStore()
+    : handle(nullptr), region(nullptr), codec(CXL_CODEC_NONE), min_ratio(ZSTORE_DEFAULT_RATIO), in_place(false),
+      next_key(1), compressed_objects(0), logical_bytes(0), stored_bytes(0), puts(0), compress_bytes(0),
+      compress_ns(0), gets(0), get_ns(0), get_max_ns(0), decompressions(0), decompress_bytes(0),
+      decompress_ns(0) {}
+
+CXLCompressedStore::~CXLCompressedStore() {
+    shutdown();
+}
+
+bool CXLCompressedStore::init(void* cxl, const cxl_zstore_config& config) {
+    if (config.codec != CXL_CODEC_NONE && config.codec != CXL_CODEC_LZ4) {
+        std::cerr << "Unknown compressed store codec " << config.codec << std::endl;
+        return false;
+    }
+    if (config.min_ratio < 0.0) {
+        std::cerr << "Compressed store min_ratio must not be negative" << std::endl;
+        return false;
+    }
+    region = static_cast<char*>(cxl_get_region(cxl, nullptr));
+    if (!region) {
+        return false;
+    }
+    handle = cxl;
+    codec = config.codec;
+    min_ratio = config.min_ratio > 0.0 ? config.min_ratio : ZSTORE_DEFAULT_RATIO;
+    in_place = cxl_get_cache_mode(cxl) == CXL_CACHE_WRITE_BACK;
+    return true;
+}
+
+void CXLCompressedStore::shutdown() {
+    std::unique_lock<std::shared_mutex> guard(lock);
+    for (const auto& entry : objects) {
+        cxl_free(handle, entry.second.block);
+    }
+    objects.clear();
+    compressed_objects = logical_bytes = stored_bytes = 0;
+}
+
+uint64_t CXLCompressedStore::put(const void* data, size_t size) {
+    if (!handle || (size && !data)) {
+        return 0;
+    }
+
+    thread_local std::vector<char> staging;
+    const char* payload = static_cast<const char*>(data);
+    size_t stored = size;
+    int used = CXL_CODEC_NONE;
+    if (codec == CXL_CODEC_LZ4 && size && cxl_lz4_bound(size)) {
+        auto start = std::chrono::steady_clock::now();
+        char* out = staging_buffer(staging, cxl_lz4_bound(size));
+        size_t compressed = cxl_lz4_compress(data, size, out, cxl_lz4_bound(size));
+        compress_ns.fetch_add(elapsed_ns(start), std::memory_order_relaxed);
+        compress_bytes.fetch_add(size, std::memory_order_relaxed);
+        if (compressed && compressed * min_ratio <= size) {
+            payload = out;
+            stored = compressed;
+            used = CXL_CODEC_LZ4;
+        }
+    }
+    puts.fetch_add(1, std::memory_order_relaxed);
+
+    char* block = static_cast<char*>(cxl_alloc(handle, stored ? stored : 1, 64));
+    if (!block) {
+        trim_staging(staging);
+        return 0;
+    }
+    cxl_iovec iov = { static_cast<size_t>(block - region), const_cast<char*>(payload), stored };
+    bool written = !stored || cxl_writev(handle, &iov, 1) == static_cast<int64_t>(stored);
+    trim_staging(staging);
+    if (!written) {
+        cxl_free(handle, block);
+        return 0;
+    }
+
+    std::unique_lock<std::shared_mutex> guard(lock);
+    uint64_t key = next_key++;
+    objects[key] = { block, stored, size, used };
+    compressed_objects += used != CXL_CODEC_NONE;
+    logical_bytes += size;
+    stored_bytes += stored;
+    return key;
+}
+
+const char* CXLCompressedStore::fetch(const Object& object, char* staging) {
+    if (in_place) {
+        return object.block;
+    }
+    cxl_iovec iov = { static_cast<size_t>(object.block - region), staging, object.stored };
+    return cxl_readv(handle, &iov, 1) == static_cast<int64_t>(object.stored) ? staging : nullptr;
+}
+
+int64_t CXLCompressedStore::get(uint64_t key, void* out, size_t capacity) {
+    auto start = std::chrono::steady_clock::now();
+    std::shared_lock<std::shared_mutex> guard(lock);
+    auto it = objects.find(key);
+    if (it == objects.end() || it->second.size > capacity || (it->second.size && !out)) {
+        return -1;
+    }
+    const Object& object = it->second;
+
+    if (object.codec == CXL_CODEC_NONE) {
+        // Stored as is: read straight into out
+        if (object.size && !fetch(object, static_cast<char*>(out))) {
+            return -1;
+        }
+        if (object.size && in_place) {
+            memcpy(out, object.block, object.size);
+        }
+    } else {
+        thread_local std::vector<char> staging;
+        const char* src = fetch(object, in_place ? nullptr : staging_buffer(staging, object.stored));
+        if (!src) {
+            trim_staging(staging);
+            return -1;
+        }
+        auto decode_start = std::chrono::steady_clock::now();
+        int64_t size = cxl_lz4_decompress(src, object.stored, out, capacity);
+        decompress_ns.fetch_add(elapsed_ns(decode_start), std::memory_order_relaxed);
+        trim_staging(staging);
+        if (size != static_cast<int64_t>(object.size)) {
+            std::cerr << "Compressed object " << key << " failed to decompress" << std::endl;
+            return -1;
+        }
+        decompressions.fetch_add(1, std::memory_order_relaxed);
+        decompress_bytes.fetch_add(object.size, std::memory_order_relaxed);
+    }
+
+    uint64_t ns = elapsed_ns(start);
+    gets.fetch_add(1, std::memory_order_relaxed);
+    get_ns.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = get_max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !get_max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+    return static_cast<int64_t>(object.size);
+}
+
+int64_t CXLCompressedStore::size(uint64_t key) {
+    std::shared_lock<std::shared_mutex> guard(lock);
+    auto it = objects.find(key);
+    return it == objects.end() ? -1 : static_cast<int64_t>(it->second.size);
+}
+
+bool CXLCompressedStore::remove(uint64_t key) {
+    std::unique_lock<std::shared_mutex> guard(lock);
+    auto it = objects.find(key);
+    if (it == objects.end()) {
+        return false;
+    }
+    const Object& object = it->second;
+    cxl_free(handle, object.block);
+    compressed_objects -= object.codec != CXL_CODEC_NONE;
+    logical_bytes -= object.size;
+    stored_bytes -= object.stored;
+    objects.erase(it);
+    return true;
+}
+
+void CXLCompressedStore::get_stats(cxl_zstore_stats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        stats->objects = objects.size();
+        stats->compressed_objects = compressed_objects;
+        stats->logical_bytes = logical_bytes;
+        stats->stored_bytes = stored_bytes;
+    }
+    stats->capacity_multiplier = stats->stored_bytes ?
+        static_cast<double>(stats->logical_bytes) / stats->stored_bytes : 1.0;
+
+    const double gib = 1024.0 * 1024.0 * 1024.0;
+    stats->puts = puts.load(std::memory_order_relaxed);
+    stats->gets = gets.load(std::memory_order_relaxed);
+    uint64_t ns = compress_ns.load(std::memory_order_relaxed);
+    stats->compress_gbps = ns ? compress_bytes.load(std::memory_order_relaxed) / (ns * 1e-9) / gib : 0.0;
+    ns = decompress_ns.load(std::memory_order_relaxed);
+    stats->decompress_gbps = ns ? decompress_bytes.load(std::memory_order_relaxed) / (ns * 1e-9) / gib : 0.0;
+    uint64_t count = decompressions.load(std::memory_order_relaxed);
+    stats->decompress_avg_ns = count ? static_cast<double>(ns) / count : 0.0;
+    stats->get_avg_ns = stats->gets ? static_cast<double>(get_ns.load(std::memory_order_relaxed)) / stats->gets : 0.0;
+    stats->get_max_ns = static_cast<double>(get_max_ns.load(std::memory_order_relaxed));
+}
@@ -5,46 +5,257 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include <chrono>
+#include <cstring>
 #include <random>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+#include "cxl_api.h"
+#include "cxl_allocator.h"
+#include "cxl_kernels.h"
+#include "cxl_compute.h"
+#include "cxl_ring.h"
+#include "cxl_histogram.h"
+#include "cxl_numa.h"
+#include "cxl_sim_model.h"
+#include "cxl_region.h"
+#include "cxl_queue.h"
+#include "cxl_pattern.h"
+#include "cxl_perf.h"
+#include "cxl_tier.h"
+#include "cxl_interleave.h"
+#include "cxl_dax.h"
+#include "cxl_zstore.h"
 
 #define CXL_MEM_REGION_SIZE (1UL << 30)  // 1GB default
 
 class CXLMemoryManager {
 private:
+    // Counters for one cxl_stat_op; calls on any thread
+    struct OpCounter {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> total_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+        
+        void record(uint64_t ns, int64_t moved) {
+            calls.fetch_add(1, std::memory_order_relaxed);
+            if (moved < 0) {
+                errors.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                bytes.fetch_add(static_cast<uint64_t>(moved), std::memory_order_relaxed);
+            }
+            total_ns.fetch_add(ns, std::memory_order_relaxed);
+            uint64_t max = max_ns.load(std::memory_order_relaxed);
+            while (ns > max && !max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+            }
+        }
+    };
+    
+    // Times an operation until it goes out of scope; it counts as failed unless done() is called
+    class OpTimer {
+    public:
+        explicit OpTimer(OpCounter& target) : counter(target), start(std::chrono::steady_clock::now()), moved(-1) {}
+        ~OpTimer() {
+            counter.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()), moved);
+        }
+        void done(size_t bytes) { moved = static_cast<int64_t>(bytes); }
+        
+    private:
+        OpCounter& counter;
+        std::chrono::steady_clock::time_point start;
+        int64_t moved;
+    };
+    
     int fd;                     // File descriptor for the CXL device
     void* mapped_region;        // Pointer to the mapped memory region
     size_t region_size;         // Size of the mapped region
+    size_t data_offset;         // Start of the region past the shared header
+    size_t scratch_offset;      // Extent the benchmarks may overwrite
+    size_t scratch_bytes;
+    int memory_node;            // NUMA node backing the region (-1 = unknown)
+    int cache_mode;             // cxl_cache_mode of the CPU mapping
+    int backend;                // cxl_backend the region is mapped from
     bool initialized;           // Status flag
+    CXLAllocator allocator;     // Sub-allocator for the mapped region
+    const CXLKernelOps* kernel; // Copy/fill kernel for the write paths
+    CXLCommandRing ring;        // FPGA command ring (real devices only)
+    CXLInterleave layout;       // Stripe layout across fd and stripe_fds
+    std::vector<int> stripe_fds;                                // Devices after the first, in stripe order
+    std::vector<std::unique_ptr<CXLCommandRing>> stripe_rings;  // Their command rings
+    std::unordered_map<uint32_t, int> command_devices;          // Striped submissions awaiting reap/wait
+    std::mutex commands_lock;                                   // Guards command_devices
+    std::atomic<uint32_t> reap_cursor;                          // First ring polled by the next reap
+    CXLHistogram latency_hist;  // Samples from the last histogram latency test
+    void* volatile chase_sink;  // Keeps the timed pointer chase from being optimized out
+    CXLSimModel sim_model;      // Simulator latency/bandwidth model (simulation builds only)
+    int iov_engine;             // cxl_iov_engine for readv/writev
+    bool accelerate_ready;      // Accelerate test buffer holds floats
+    std::atomic<uint32_t> next_cmd_id;  // Ids for library-issued ring commands
+    CXLObjectDirectory directory;       // Named objects in the region header (devices only)
+    std::unordered_map<uint64_t, uint64_t> objects;  // Directory objects kept out of allocator
+    uint32_t objects_generation;        // Directory generation objects reflects
+    std::mutex objects_lock;            // Guards objects and objects_generation
+    CXLPerfCounters perf;               // Counters around timed loops (cxl_perf_enable)
+    cxl_perf_counters perf_last;        // Counters from the last timed loop
+    bool perf_measured;                 // perf_last holds a measurement
+    OpCounter op_stats[CXL_STAT_OP_COUNT];      // cxl_get_stats counters
+    std::atomic<uint64_t> fallback_bytes;       // FPGA-engine bytes copied on the CPU
+    std::mutex scratch_lock;            // Guards scratch_claims
+    int scratch_claims;                 // Benchmarks running over an unreserved scratch extent
 
 public:
-    CXLMemoryManager() : fd(-1), mapped_region(nullptr), region_size(0), initialized(false) {}
+    CXLMemoryManager() : fd(-1), mapped_region(nullptr), region_size(0), data_offset(0),
+                         scratch_offset(0), scratch_bytes(0),
+                         memory_node(-1), cache_mode(CXL_CACHE_WRITE_BACK), backend(CXL_BACKEND_HOST),
+                         initialized(false),
+                         kernel(cxl_kernel_ops(CXL_KERNEL_AUTO)), reap_cursor(0), chase_sink(nullptr),
+                         iov_engine(CXL_IOV_ENGINE_CPU), accelerate_ready(false), next_cmd_id(0),
+                         objects_generation(0), perf_last(), perf_measured(false), fallback_bytes(0),
+                         scratch_claims(0) {}
     
     ~CXLMemoryManager() {
         cleanup();
     }
     
-    bool initialize(const char* device_path, size_t size) {
-        // Open the CXL device
-        fd = open(device_path, O_RDWR);
-        if (fd < 0) {
-            std::cerr << "Failed to open CXL device at " << device_path << std::endl;
-            return false;
+    bool initialize(const char* device_path, size_t size, int numa_node = -1, int flags = 0,
+                    size_t interleave_granularity = 0, size_t scratch_size = 0) {
+        std::vector<std::string> devices = cxl_interleave_devices(device_path);
+        CXLDaxInfo dax = {};
+        if (devices.size() > 1) {
+            // A device set: one logical region striped over all of them
+            if (!open_stripes(devices, size, interleave_granularity, &dax)) {
+                return false;
+            }
+        } else if (device_path) {
+            // Open the CXL device
+            fd = open(device_path, O_RDWR);
+            if (fd < 0) {
+                std::cerr << "Failed to open CXL device at " << device_path << std::endl;
+                return false;
+            }
+            
+            // Map the memory region; DAX memory has its own alignment rules
+            if (cxl_dax_probe(fd, &dax)) {
+                size = cxl_dax_map_size(dax, size);
+                if (size > dax.capacity) {
+                    std::cerr << "DAX " << (dax.kind == CXL_DAX_DEVICE ? "device " : "file ") << device_path
+                              << " holds " << dax.capacity << " bytes, " << size << " requested" << std::endl;
+                    close_devices();
+                    return false;
+                }
+                mapped_region = cxl_dax_map(fd, dax, size);
+            } else {
+                mapped_region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+        } else {
+            // No device: host memory, typically bound to a NUMA node below
+            mapped_region = map_anonymous(size, flags);
         }
-        
-        // Map the memory region
-        mapped_region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
         if (mapped_region == MAP_FAILED) {
             std::cerr << "Failed to map memory region" << std::endl;
-            close(fd);
-            fd = -1;
+            close_devices();
             return false;
         }
         
         region_size = size;
+        if (dax.kind != CXL_DAX_NONE) {
+            backend = dax.kind == CXL_DAX_DEVICE ? CXL_BACKEND_DEVDAX : CXL_BACKEND_FSDAX;
+        } else {
+            backend = device_path ? CXL_BACKEND_FILE : CXL_BACKEND_HOST;
+        }
+        
+        // DAX memory already lives on the device's node and comes in the page size the
+        // device was set up with (PMD or PUD), so neither binding nor THP applies to it
+        if (dax.kind != CXL_DAX_NONE) {
+            if (numa_node >= 0 && dax.numa_node >= 0 && numa_node != dax.numa_node) {
+                std::cerr << "DAX memory belongs to node " << dax.numa_node << ", not binding it to node "
+                          << numa_node << std::endl;
+            }
+            numa_node = dax.numa_node >= 0 ? dax.numa_node : numa_node;
+        } else if (device_path && (flags & (CXL_INIT_HUGE_2M | CXL_INIT_HUGE_1G))) {
+            // Hugetlbfs files and the FPGA driver pick their own page size; this covers shmem
+            madvise(mapped_region, size, MADV_HUGEPAGE);
+        }
+        
+        // Bind before the first touch so every page is allocated on the node
+        if (numa_node >= 0 && dax.kind == CXL_DAX_NONE && !cxl_numa_bind(mapped_region, size, numa_node)) {
+            std::cerr << "Failed to bind memory region to NUMA node " << numa_node
+                      << ": " << strerror(errno) << std::endl;
+            munmap(mapped_region, size);
+            mapped_region = nullptr;
+            close_devices();
+            return false;
+        }
+        if (flags & CXL_INIT_POPULATE) {
+            populate();
+        }
+        memory_node = numa_node;
+        
+        // Device regions start with the header other processes find objects through;
+        // the allocator stays clear of it and of the scratch extent the benchmarks use
+        scratch_offset = 0;
+        scratch_bytes = size;
+        if (device_path && CXLObjectDirectory::fits(size)) {
+            if (!directory.attach(mapped_region, size, scratch_size, flags & CXL_INIT_FORMAT)) {
+                munmap(mapped_region, size);
+                mapped_region = nullptr;
+                close_devices();
+                return false;
+            }
+            data_offset = CXL_REGION_HEADER_SIZE;
+            scratch_offset = directory.scratch_offset();
+            scratch_bytes = directory.scratch_size();
+        }
+        allocator.init(data_offset, size - data_offset);
+        if (directory.attached()) {
+            if (scratch_bytes && !allocator.reserve(scratch_offset, scratch_bytes)) {
+                std::cerr << "Scratch extent at offset " << scratch_offset << " does not fit the region" << std::endl;
+            }
+            std::lock_guard<std::mutex> guard(objects_lock);
+            directory.lock();
+            directory.scrub();
+            sync_objects(true);
+            directory.unlock();
+        }
+        
+        // Only the FPGA driver provides a command ring; plain files and DAX simply don't
+        if (fd >= 0 && dax.kind == CXL_DAX_NONE) {
+            ring.open(fd);
+            for (int stripe_fd : stripe_fds) {
+                stripe_rings.emplace_back(new CXLCommandRing());
+                stripe_rings.back()->open(stripe_fd);
+            }
+            if (ring.is_open()) {
+                backend = CXL_BACKEND_FPGA;
+            }
+            cache_mode = query_cache_mode();
+        }
+#ifdef SIMULATION_MODE
+        if (device_path) {
+            // Striped devices each bring their own link
+            sim_model.load(devices[0].c_str());
+            for (size_t i = 1; i < devices.size(); i++) {
+                CXLSimModel link;
+                link.load(devices[i].c_str());
+                sim_model.add_link(link);
+            }
+        }
+#endif
         initialized = true;
         return true;
     }
@@ -56,11 +267,23 @@ public:
                 mapped_region = nullptr;
             }
             
-            if (fd >= 0) {
-                close(fd);
-                fd = -1;
-            }
+            ring.close();
+            stripe_rings.clear();
+            command_devices.clear();
+            close_devices();
             
+            allocator.reset();
+            directory.detach();
+            objects.clear();
+            data_offset = 0;
+            scratch_offset = 0;
+            scratch_bytes = 0;
+            sim_model.reset();
+            iov_engine = CXL_IOV_ENGINE_CPU;
+            accelerate_ready = false;
+            memory_node = -1;
+            cache_mode = CXL_CACHE_WRITE_BACK;
+            backend = CXL_BACKEND_HOST;
             initialized = false;
         }
     }
@@ -77,25 +300,553 @@ public:
     size_t get_size() const {
         return region_size;
     }
+
+    // Bytes the benchmarks may use, past the shared header
+    size_t get_data_size() const {
+        return data_size();
+    }
+
+    // Descriptor the region is mapped from (-1 for host memory and device sets)
+    int get_fd() const {
+        return layout.striped() ? -1 : fd;
+    }
+
+    // Devices the region is striped over, and the stripe unit (0 when there is one device)
+    int get_interleave(size_t* granularity) const {
+        if (granularity) {
+            *granularity = layout.striped() ? layout.granule : 0;
+        }
+        return layout.ways;
+    }
+
+    int get_cache_mode() const {
+        return cache_mode;
+    }
+    
+    int get_backend() const {
+        return backend;
+    }
+
+    // Write back CPU stores to [addr, addr + length) for the device; only
+    // write-back mappings hold dirty lines, the others are done by the barrier
+    void flush_range(const void* addr, size_t length) const {
+        if (cache_mode == CXL_CACHE_WRITE_BACK) {
+            cxl_cache_writeback(addr, length);
+        }
+    }
+
+    // Drop cached copies of [addr, addr + length) so later loads see device writes
+    void invalidate_range(const void* addr, size_t length) const {
+        if (cache_mode == CXL_CACHE_WRITE_BACK) {
+            cxl_cache_invalidate(addr, length);
+            cxl_cache_fence(true);
+        }
+    }
+
+    // Complete earlier flushes and drain write-combining buffers
+    void persist_barrier() const {
+        cxl_cache_fence(false);
+    }
+
+    // Page size actually backing the region, from /proc/self/smaps
+    size_t get_page_size() const {
+        if (!initialized) {
+            return 0;
+        }
+        
+        FILE* smaps = fopen("/proc/self/smaps", "r");
+        if (!smaps) {
+            return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        }
+        
+        // Find the VMA holding the region, then total its page size fields
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(mapped_region);
+        bool in_vma = false;
+        size_t kernel_page_kb = 0, rss_kb = 0, pmd_kb = 0;
+        char line[512];
+        while (fgets(line, sizeof(line), smaps)) {
+            unsigned long start, end, value;
+            char field[64];
+            if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+                if (in_vma) {
+                    break;
+                }
+                in_vma = addr >= start && addr < end;
+            } else if (in_vma && sscanf(line, "%63[^:]: %lu kB", field, &value) == 2) {
+                if (strcmp(field, "KernelPageSize") == 0) {
+                    kernel_page_kb = value;
+                } else if (strcmp(field, "Rss") == 0) {
+                    rss_kb = value;
+                } else if (strcmp(field, "AnonHugePages") == 0 || strcmp(field, "ShmemPmdMapped") == 0 ||
+                           strcmp(field, "FilePmdMapped") == 0) {
+                    pmd_kb += value;
+                }
+            }
+        }
+        fclose(smaps);
+        
+        // Hugetlb mappings report their page size directly; THP shows up as PMD-mapped bytes
+        if (kernel_page_kb > 4) {
+            return kernel_page_kb << 10;
+        }
+        if (pmd_kb && pmd_kb * 2 >= rss_kb) {
+            return 2UL << 20;
+        }
+        return kernel_page_kb ? kernel_page_kb << 10 : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+
+    // Report the simulation model applied to the tests
+    bool get_sim_model(double* latency_ns, double* bandwidth_gbps) const {
+        if (latency_ns) {
+            *latency_ns = sim_model.latency_ns();
+        }
+        if (bandwidth_gbps) {
+            *bandwidth_gbps = sim_model.bandwidth_gbps();
+        }
+        return sim_model.active();
+    }
+
+    // Get the NUMA node backing the region
+    int get_numa_node() {
+        if (initialized && memory_node < 0) {
+            memory_node = cxl_numa_addr_node(mapped_region);
+        }
+        return memory_node;
+    }
+
+    // Allocate memory inside the mapped region
+    void* alloc(size_t size, size_t align) {
+        OpTimer timer(op_stats[CXL_STAT_ALLOC]);
+        if (!initialized) {
+            return nullptr;
+        }
+        
+        // Stay clear of objects other processes published since the last look
+        if (directory.attached() && directory.generation() != objects_generation) {
+            std::lock_guard<std::mutex> guard(objects_lock);
+            directory.lock();
+            sync_objects(false);
+            directory.unlock();
+        }
+        
+        size_t offset;
+        if (!allocator.allocate(size, align ? align : 64, &offset)) {
+            return nullptr;
+        }
+        timer.done(size);
+        return static_cast<char*>(mapped_region) + offset;
+    }
+
+    // Return memory obtained from alloc
+    bool free_block(void* ptr) {
+        OpTimer timer(op_stats[CXL_STAT_FREE]);
+        char* p = static_cast<char*>(ptr);
+        char* start = static_cast<char*>(mapped_region);
+        if (!initialized || p < start || p >= start + region_size) {
+            return false;
+        }
+        
+        // Objects go through remove_object so the directory stays in step
+        size_t offset = static_cast<size_t>(p - start);
+        {
+            std::lock_guard<std::mutex> guard(objects_lock);
+            if (objects.count(offset)) {
+                return false;
+            }
+        }
+        if (!allocator.release(offset)) {
+            return false;
+        }
+        timer.done(0);
+        return true;
+    }
+
+    // Id of the region from its header
+    uint16_t get_region_id() const {
+        return directory.region_id();
+    }
+
+    void get_region_info(cxl_region_info* info) const {
+        directory.get_info(info);
+        info->scratch_offset = scratch_offset;
+        info->scratch_size = scratch_bytes;
+    }
+
+    void* get_scratch(size_t* size) const {
+        if (size) {
+            *size = initialized ? scratch_bytes : 0;
+        }
+        return initialized ? data_start() : nullptr;
+    }
+
+    // Relocatable handle for an address in the region
+    cxl_handle_t to_handle(const void* ptr) const {
+        const char* p = static_cast<const char*>(ptr);
+        const char* start = static_cast<const char*>(mapped_region);
+        if (!initialized || !directory.attached() || p < start + data_offset || p >= start + region_size) {
+            return CXL_HANDLE_NULL;
+        }
+        return make_handle(static_cast<uint64_t>(p - start));
+    }
+
+    // Address of a handle in this process's mapping
+    void* from_handle(cxl_handle_t object) const {
+        uint64_t offset = object & ((1ULL << CXL_HANDLE_OFFSET_BITS) - 1);
+        if (!initialized || !directory.attached() ||
+            (object >> CXL_HANDLE_OFFSET_BITS) != directory.region_id() ||
+            offset < data_offset || offset >= region_size) {
+            return nullptr;
+        }
+        return static_cast<char*>(mapped_region) + offset;
+    }
+
+    // Allocate an object and publish it in the directory
+    cxl_handle_t create_object(const char* name, size_t size) {
+        if (!initialized || !directory.attached() || !valid_object_name(name) || size == 0) {
+            return CXL_HANDLE_NULL;
+        }
+        
+        // Whole pages, so other processes can reserve exactly what the object covers
+        const size_t page = static_cast<size_t>(1) << CXLAllocator::MIN_ORDER;
+        cxl_handle_t result = CXL_HANDLE_NULL;
+        uint64_t existing_offset, existing_length;
+        size_t offset;
+        
+        std::lock_guard<std::mutex> guard(objects_lock);
+        directory.lock();
+        sync_objects(false);
+        if (!directory.find(name, &existing_offset, &existing_length) &&
+            allocator.allocate(std::max(size, page), page, &offset)) {
+            if (directory.insert(name, offset, size)) {
+                objects[offset] = size;
+                objects_generation = directory.generation();
+                result = make_handle(offset);
+            } else {
+                std::cerr << "Object directory is full" << std::endl;
+                allocator.release(offset);
+            }
+        }
+        directory.unlock();
+        return result;
+    }
+
+    // Find an object published by any process mapping the device
+    cxl_handle_t open_object(const char* name, size_t* size) {
+        if (!initialized || !directory.attached() || !valid_object_name(name)) {
+            return CXL_HANDLE_NULL;
+        }
+        
+        uint64_t offset, length;
+        std::lock_guard<std::mutex> guard(objects_lock);
+        directory.lock();
+        sync_objects(false);
+        bool found = directory.find(name, &offset, &length) && offset >= data_offset &&
+                     offset < region_size && length <= region_size - offset;
+        directory.unlock();
+        
+        if (!found) {
+            return CXL_HANDLE_NULL;
+        }
+        if (size) {
+            *size = length;
+        }
+        return make_handle(offset);
+    }
+
+    // Unpublish an object and give its memory back
+    bool remove_object(const char* name) {
+        if (!initialized || !directory.attached() || !valid_object_name(name)) {
+            return false;
+        }
+        
+        uint64_t offset;
+        std::lock_guard<std::mutex> guard(objects_lock);
+        directory.lock();
+        sync_objects(false);
+        bool removed = directory.remove(name, &offset);
+        if (removed && objects.erase(offset)) {
+            allocator.release(offset);
+        }
+        objects_generation = directory.generation();
+        directory.unlock();
+        return removed;
+    }
+
+    // Get region allocator statistics
+    void get_alloc_stats(cxl_alloc_stats* stats) {
+        allocator.get_stats(stats);
+    }
+
+    // Operation counters, plus the command counters of every ring
+    void get_stats(cxl_stats* stats) const {
+        memset(stats, 0, sizeof(*stats));
+        for (int op = 0; op < CXL_STAT_OP_COUNT; op++) {
+            stats->ops[op].calls = op_stats[op].calls.load(std::memory_order_relaxed);
+            stats->ops[op].errors = op_stats[op].errors.load(std::memory_order_relaxed);
+            stats->ops[op].bytes = op_stats[op].bytes.load(std::memory_order_relaxed);
+            stats->ops[op].total_ns = op_stats[op].total_ns.load(std::memory_order_relaxed);
+            stats->ops[op].max_ns = op_stats[op].max_ns.load(std::memory_order_relaxed);
+        }
+        stats->fallback_bytes = fallback_bytes.load(std::memory_order_relaxed);
+        
+        CXLRingStats rings = {};
+        ring.add_stats(&rings);
+        for (const auto& stripe_ring : stripe_rings) {
+            stripe_ring->add_stats(&rings);
+        }
+        stats->commands_submitted = rings.submitted;
+        stats->commands_completed = rings.completed;
+        stats->commands_failed = rings.failed;
+        // A reset between posting and reaping can leave more reaped than submitted
+        uint64_t reaped = rings.completed + rings.failed;
+        stats->commands_in_flight = rings.submitted > reaped ? rings.submitted - reaped : 0;
+        stats->command_avg_ns = rings.latency_count ? rings.latency_total_ns / rings.latency_count : 0;
+        stats->command_max_ns = rings.latency_max_ns;
+        for (int op = 0; op <= CMD_ACCELERATE; op++) {
+            stats->command_bytes[op] = rings.bytes[op];
+        }
+    }
+    
+    void reset_stats() {
+        for (OpCounter& counter : op_stats) {
+            counter.calls.store(0, std::memory_order_relaxed);
+            counter.errors.store(0, std::memory_order_relaxed);
+            counter.bytes.store(0, std::memory_order_relaxed);
+            counter.total_ns.store(0, std::memory_order_relaxed);
+            counter.max_ns.store(0, std::memory_order_relaxed);
+        }
+        fallback_bytes.store(0, std::memory_order_relaxed);
+        ring.reset_stats();
+        for (const auto& stripe_ring : stripe_rings) {
+            stripe_ring->reset_stats();
+        }
+    }
+    
+    bool has_command_ring() const {
+        return initialized && rings_open();
+    }
+
+    // Post FPGA commands through the driver ring. On a device set, region offsets
+    // are translated and each command goes to the device holding its stripe unit.
+    int submit_commands(const cxl_command* cmds, int count) {
+        if (!initialized || !rings_open()) {
+            return -1;
+        }
+        if (!layout.striped()) {
+            return ring.submit(cmds, count);
+        }
+        
+        // Consecutive commands for the same device share a doorbell
+        thread_local std::vector<cxl_command> batch;
+        for (int i = 0; i < count;) {
+            batch.clear();
+            int device = -1;
+            for (int j = i; j < count; j++) {
+                cxl_command cmd = cmds[j];
+                int target;
+                if (!route_command(&cmd, &target) || (device >= 0 && target != device)) {
+                    break;
+                }
+                device = target;
+                batch.push_back(cmd);
+            }
+            if (batch.empty()) {
+                errno = EINVAL;
+                return i;
+            }
+            int posted = device_ring(device).submit(batch.data(), static_cast<int>(batch.size()));
+            if (posted > 0) {
+                std::lock_guard<std::mutex> guard(commands_lock);
+                for (int k = 0; k < posted; k++) {
+                    command_devices[batch[k].id] = device;
+                }
+                i += posted;
+            }
+            if (posted < static_cast<int>(batch.size())) {
+                return i;
+            }
+        }
+        return count;
+    }
+
+    // Collect finished FPGA commands from the driver rings
+    int reap_completions(cxl_completion* out, int max) {
+        if (!initialized || !rings_open()) {
+            return -1;
+        }
+        if (!layout.striped()) {
+            return ring.reap(out, max);
+        }
+        
+        // Start at a different ring each time so a busy device can't starve the rest
+        int total = 0;
+        uint32_t first = reap_cursor.fetch_add(1, std::memory_order_relaxed);
+        for (int k = 0; k < layout.ways && total < max; k++) {
+            int reaped = device_ring(static_cast<int>((first + k) % layout.ways)).reap(out + total, max - total);
+            total += std::max(reaped, 0);
+        }
+        std::lock_guard<std::mutex> guard(commands_lock);
+        for (int i = 0; i < total; i++) {
+            command_devices.erase(out[i].id);
+        }
+        return total;
+    }
+
+    // Block in the driver until a command finishes
+    int wait_command(uint32_t id, uint32_t timeout_ms, cxl_completion* out) {
+        if (!initialized || !rings_open()) {
+            return -ENXIO;
+        }
+        if (!layout.striped()) {
+            return ring.wait(id, timeout_ms, out);
+        }
+        
+        int device;
+        {
+            std::lock_guard<std::mutex> guard(commands_lock);
+            auto it = command_devices.find(id);
+            if (it == command_devices.end()) {
+                return -ENOENT;
+            }
+            device = it->second;
+        }
+        cxl_completion cqe;
+        int status = device_ring(device).wait(id, timeout_ms, &cqe);
+        // INVALID means the driver hasn't taken it from the SQ yet, and ACTIVE that a
+        // zero-timeout poll found it running: keep its route either way
+        if (status == 0 && cqe.status != CXL_CMD_STATUS_INVALID && cqe.status != CXL_CMD_STATUS_ACTIVE) {
+            std::lock_guard<std::mutex> guard(commands_lock);
+            command_devices.erase(id);
+        }
+        if (status == 0 && out) {
+            *out = cqe;
+        }
+        return status;
+    }
+
+    // Select the engine for vectored transfers
+    bool set_iov_engine(int engine) {
+        if (engine == CXL_IOV_ENGINE_CPU || (engine == CXL_IOV_ENGINE_FPGA && rings_open())) {
+            iov_engine = engine;
+            return true;
+        }
+        return false;
+    }
+
+    // Vectored transfer between host buffers and the region
+    int64_t transfer_vector(bool is_write, const cxl_iovec* iov, int count) {
+        OpTimer timer(op_stats[is_write ? CXL_STAT_WRITEV : CXL_STAT_READV]);
+        if (!initialized || count < 0 || (count > 0 && !iov)) {
+            errno = EINVAL;
+            return -1;
+        }
+        
+        // Check every range first so a bad one never leaves a partial transfer; the
+        // region header below data_offset is only changed through the directory
+        for (int i = 0; i < count; i++) {
+            if (iov[i].offset < data_offset || iov[i].offset > region_size ||
+                iov[i].length > region_size - iov[i].offset ||
+                (iov[i].length && !iov[i].buffer)) {
+                errno = EINVAL;
+                return -1;
+            }
+        }
+        
+        // Reused across calls so the small-transfer path doesn't allocate
+        thread_local std::vector<IoSegment> segments;
+        load_segments(iov, count, segments);
+        
+        // Sort by region offset and merge ranges that are contiguous on both sides;
+        // overlapping writes keep submission order so the last one still wins
+        std::stable_sort(segments.begin(), segments.end(),
+                         [](const IoSegment& a, const IoSegment& b) { return a.offset < b.offset; });
+        bool overlap = false;
+        for (size_t i = 1; i < segments.size() && !overlap; i++) {
+            overlap = segments[i].offset < segments[i - 1].offset + segments[i - 1].length;
+        }
+        if (overlap && is_write) {
+            load_segments(iov, count, segments);
+        } else {
+            merge_segments(segments);
+        }
+        
+        int64_t total = 0;
+        for (const IoSegment& seg : segments) {
+            total += static_cast<int64_t>(seg.length);
+        }
+        
+        if (iov_engine == CXL_IOV_ENGINE_FPGA && rings_open()) {
+            if (!fpga_transfer(is_write, segments)) {
+                return -1;
+            }
+        } else {
+            for (const IoSegment& seg : segments) {
+                cpu_transfer(is_write, seg);
+            }
+        }
+        timer.done(static_cast<size_t>(total));
+        return total;
+    }
+
+    // Select the copy/fill kernel for the write paths
+    bool set_kernel(int id) {
+        const CXLKernelOps* ops = cxl_kernel_ops(id);
+        if (!ops) {
+            return false;
+        }
+        kernel = ops;
+        return true;
+    }
+
+    int get_kernel() const {
+        return kernel->id;
+    }
+
+    // Time every supported kernel and keep the one with the best write bandwidth
+    int select_fastest_kernel(void* buffer, size_t block_size, int iterations) {
+        const CXLKernelOps* best = kernel;
+        double best_bandwidth = 0.0;
+
+        for (int id = CXL_KERNEL_SCALAR; id < CXL_KERNEL_COUNT; id++) {
+            const CXLKernelOps* ops = cxl_kernel_ops(id);
+            if (!ops) {
+                continue;
+            }
+            kernel = ops;
+            double bandwidth = test_write(buffer, block_size, iterations);
+            if (bandwidth > best_bandwidth) {
+                best_bandwidth = bandwidth;
+                best = ops;
+            }
+        }
+
+        kernel = best;
+        return kernel->id;
+    }
     
     // Test write bandwidth
     double test_write(void* buffer, size_t block_size, int iterations) {
-        if (!initialized || block_size > region_size) {
+        if (!initialized || block_size == 0 || block_size > data_size()) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
             return 0.0;
         }
         
+        perf_begin();
         auto start = std::chrono::high_resolution_clock::now();
         
         for (int i = 0; i < iterations; i++) {
             // Calculate a different offset for each iteration to reduce caching effects
-            size_t offset = (i * block_size) % (region_size - block_size);
-            void* dest = static_cast<char*>(mapped_region) + offset;
+            void* dest = data_start() + block_offset(i, block_size);
             
             // Copy data to CXL memory
-            memcpy(dest, buffer, block_size);
+            modelled(block_size, [&] { kernel->copy(dest, buffer, block_size); });
         }
         
         auto end = std::chrono::high_resolution_clock::now();
+        perf_end();
         std::chrono::duration<double> elapsed = end - start;
         
         // Calculate bandwidth in GB/s
@@ -107,22 +858,27 @@ public:
     
     // Test read bandwidth
     double test_read(void* buffer, size_t block_size, int iterations) {
-        if (!initialized || block_size > region_size) {
+        if (!initialized || block_size == 0 || block_size > data_size()) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
             return 0.0;
         }
         
+        perf_begin();
         auto start = std::chrono::high_resolution_clock::now();
         
         for (int i = 0; i < iterations; i++) {
             // Calculate a different offset for each iteration to reduce caching effects
-            size_t offset = (i * block_size) % (region_size - block_size);
-            void* src = static_cast<char*>(mapped_region) + offset;
+            void* src = data_start() + block_offset(i, block_size);
             
             // Copy data from CXL memory
-            memcpy(buffer, src, block_size);
+            modelled(block_size, [&] { memcpy(buffer, src, block_size); });
         }
         
         auto end = std::chrono::high_resolution_clock::now();
+        perf_end();
         std::chrono::duration<double> elapsed = end - start;
         
         // Calculate bandwidth in GB/s
@@ -131,104 +887,909 @@ public:
         
         return bandwidth;
     }
-    
+
+    // Test write bandwidth with several threads, each working in its own slice
+    double test_write_parallel(void* buffer, size_t block_size, int iterations,
+                               const cxl_bw_config* config, cxl_bw_result* result) {
+        return run_parallel(true, buffer, block_size, iterations, config, result);
+    }
+
+    // Test read bandwidth with several threads, each working in its own slice
+    double test_read_parallel(void* buffer, size_t block_size, int iterations,
+                              const cxl_bw_config* config, cxl_bw_result* result) {
+        return run_parallel(false, buffer, block_size, iterations, config, result);
+    }
+
     // Test memory latency
     double test_latency(int iterations) {
         if (!initialized) {
             return 0.0;
         }
-        
-        // Create a linked list in memory for pointer chasing
-        const int list_size = 1024 * 1024;  // 1M nodes
-        const size_t node_size = sizeof(size_t);
-        
-        // Check if we have enough memory
-        if (list_size * node_size > region_size) {
-            std::cerr << "Region too small for latency test" << std::endl;
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
             return 0.0;
         }
         
-        // Initialize the linked list with pointer indices
-        size_t* list = static_cast<size_t*>(mapped_region);
-        
-        // Create random permutation for the linked list to avoid prefetching
-        std::vector<size_t> indices(list_size);
-        for (int i = 0; i < list_size; i++) {
-            indices[i] = i;
-        }
-        
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(indices.begin(), indices.end(), g);
-        
-        // Build the linked list
-        for (int i = 0; i < list_size - 1; i++) {
-            list[indices[i]] = indices[i + 1];
-        }
-        list[indices[list_size - 1]] = indices[0]; // Complete the cycle
-        
-        // Warm up the list to ensure it's in memory
-        volatile size_t dummy = 0;
-        for (int i = 0; i < list_size; i++) {
-            dummy = list[dummy];
+        void** node = build_chase(CHASE_DEFAULT_WORKING_SET, sizeof(void*), CXL_PAGES_DEFAULT);
+        if (!node) {
+            return 0.0;
         }
         
         // Measure latency by traversing the list
+        perf_begin();
         auto start = std::chrono::high_resolution_clock::now();
         
-        volatile size_t index = 0;
         for (int i = 0; i < iterations; i++) {
             // Time how long it takes to walk through a segment of the list
             for (int j = 0; j < 1000; j++) {
-                index = list[index];
+                node = static_cast<void**>(*node);
+                sim_model.access();
             }
         }
         
         auto end = std::chrono::high_resolution_clock::now();
+        perf_end();
         std::chrono::duration<double, std::nano> elapsed = end - start;
+        chase_sink = node;
         
         // Calculate average latency in nanoseconds
         double latency = elapsed.count() / (iterations * 1000);
         
         return latency;
     }
-    
-    // Simulate FPGA operations
-    double test_fpga(int operation, int iterations) {
-        if (!initialized) {
+
+    // Test memory latency over the default chase, recording a histogram
+    double test_latency_histogram(int iterations, cxl_latency_stats* stats) {
+        cxl_chase_config config = { CHASE_DEFAULT_WORKING_SET, sizeof(void*), CXL_PAGES_DEFAULT };
+        return test_latency_chase(&config, iterations, stats);
+    }
+
+    // Test memory latency over a configured chase, timing each chunk of hops with the TSC
+    double test_latency_chase(const cxl_chase_config* config, int iterations, cxl_latency_stats* stats) {
+        latency_hist.reset();
+        if (stats) {
+            memset(stats, 0, sizeof(*stats));
+        }
+        if (!initialized || iterations <= 0) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
             return 0.0;
         }
         
-        // For this simulation, we'll just create different memory access patterns
-        // based on the operation type
-        
-        const size_t buffer_size = 1024 * 1024; // 1MB
+        size_t working_set = config && config->working_set ? config->working_set : CHASE_DEFAULT_WORKING_SET;
+        size_t stride = config && config->stride ? config->stride : 64;
+        int page_mode = config ? config->page_mode : CXL_PAGES_DEFAULT;
         
-        // Check if we have enough memory
-        if (buffer_size > region_size) {
-            std::cerr << "Region too small for FPGA test" << std::endl;
+        void** node = build_chase(working_set, stride, page_mode);
+        if (!node) {
             return 0.0;
         }
         
-        switch (operation) {
-            case 1: { // memcpy
-                // Allocate source and destination buffers
-                void* src = malloc(buffer_size);
-                if (!src) return 0.0;
-                
-                // Fill source with random data
-                std::memset(src, 0xAA, buffer_size);
-                
-                auto start = std::chrono::high_resolution_clock::now();
+        // Same number of hops as test_latency, sampled CHASE_HOPS_PER_SAMPLE at a time
+        perf_begin();
+        node = sample_chase(node, static_cast<long>(iterations) * 1000 / CHASE_HOPS_PER_SAMPLE);
+        perf_end();
+        chase_sink = node;
+        
+        fill_stats(latency_hist, stats);
+        return latency_hist.mean();
+    }
+
+    // Measure latency at working sets from min to max, two points per doubling
+    int latency_sweep(const cxl_chase_config* config, size_t min_working_set, size_t max_working_set,
+                      int iterations, cxl_latency_point* points, int max_points) {
+        if (!initialized || !points || max_points <= 0 || iterations <= 0) {
+            return -1;
+        }
+        
+        cxl_chase_config point_config = {};
+        if (config) {
+            point_config = *config;
+        }
+        if (!point_config.stride) {
+            point_config.stride = 64;
+        }
+        
+        min_working_set = std::max(min_working_set, 2 * point_config.stride);
+        max_working_set = std::min(max_working_set, data_size());
+        
+        int count = 0;
+        for (size_t octave = min_working_set; octave <= max_working_set && count < max_points; octave *= 2) {
+            for (size_t working_set : { octave, octave + octave / 2 }) {
+                if (working_set > max_working_set || count >= max_points) {
+                    break;
+                }
+                
+                cxl_latency_stats stats;
+                point_config.working_set = working_set;
+                test_latency_chase(&point_config, iterations, &stats);
+                if (!stats.samples) {
+                    return count ? count : -1;
+                }
+                
+                cxl_latency_point& point = points[count++];
+                point.working_set = working_set / point_config.stride * point_config.stride;
+                point.stride = point_config.stride;
+                point.mean_ns = stats.mean_ns;
+                point.p50_ns = stats.p50_ns;
+                point.p99_ns = stats.p99_ns;
+            }
+        }
+        return count;
+    }
+
+    // Chase latency on the calling thread's first CPU while traffic threads on the
+    // others read and write the rest of the scratch extent, pausing delay times
+    // after each block; one point per delay
+    int loaded_latency(const cxl_loaded_latency_config* config, int iterations,
+                       cxl_loaded_latency_point* points, int max_points) {
+        if (!initialized || !points || max_points <= 0 || iterations <= 0) {
+            return -1;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return -1;
+        }
+        
+        static const uint32_t default_delays[] = { 0, 2, 8, 15, 50, 100, 200, 300, 400, 500, 700, 1000,
+                                                   1300, 1700, 2500, 3500, 5000, 9000, 20000 };
+        cxl_loaded_latency_config cfg = {};
+        if (config) {
+            cfg = *config;
+        }
+        const size_t working_set = cfg.chase.working_set ? cfg.chase.working_set : CHASE_DEFAULT_WORKING_SET;
+        const size_t stride = cfg.chase.stride ? cfg.chase.stride : 64;
+        const size_t block_size = cfg.block_size ? cfg.block_size : LOADED_DEFAULT_BLOCK;
+        const int write_percent = std::clamp(cfg.write_percent, 0, 100);
+        std::vector<uint32_t> delays(std::begin(default_delays), std::end(default_delays));
+        if (cfg.delays && cfg.num_delays > 0) {
+            delays.assign(cfg.delays, cfg.delays + cfg.num_delays);
+        }
+        std::vector<int> allowed = allowed_cpus();
+        std::vector<int> cpus = allowed;
+        if (cfg.cpus && cfg.num_cpus > 0) {
+            cpus.assign(cfg.cpus, cfg.cpus + cfg.num_cpus);
+        }
+        if (cpus.empty()) {
+            return -1;
+        }
+        int threads = cfg.traffic_threads > 0 ? cfg.traffic_threads : static_cast<int>(cpus.size()) - 1;
+        threads = std::clamp(threads, 1, CXL_MAX_BW_THREADS);
+        if (threads >= static_cast<int>(cpus.size())) {
+            std::cerr << "Only " << cpus.size() << " CPUs for the chase and " << threads
+                      << " traffic threads; the extra threads float over the other allowed CPUs" << std::endl;
+        }
+        
+        // The chase takes the front of the scratch extent, traffic one slice each of the rest
+        const size_t traffic_offset = (working_set + 4095) & ~static_cast<size_t>(4095);
+        const size_t slice_size = traffic_offset < data_size() ?
+            ((data_size() - traffic_offset) / threads) & ~static_cast<size_t>(63) : 0;
+        if (slice_size < block_size) {
+            std::cerr << "Region too small for a " << working_set << "-byte chase and " << threads
+                      << " traffic threads with block size " << block_size << std::endl;
+            return -1;
+        }
+        void** node = build_chase(working_set, stride, cfg.chase.page_mode);
+        if (!node) {
+            return -1;
+        }
+        
+        // Traffic threads without a CPU of their own would inherit the chase's
+        // pinning, so they get every allowed CPU but the chase's instead
+        cpu_set_t spread;
+        CPU_ZERO(&spread);
+        for (int cpu : allowed) {
+            if (cpu != cpus[0]) {
+                CPU_SET(cpu, &spread);
+            }
+        }
+        if (!CPU_COUNT(&spread)) {
+            std::cerr << "No CPU left for traffic besides the chase's; the load shares its core" << std::endl;
+            CPU_SET(cpus[0], &spread);
+        }
+        
+        cpu_set_t saved;
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(cpus[0], &one);
+        bool restore = sched_getaffinity(0, sizeof(saved), &saved) == 0;
+        sched_setaffinity(0, sizeof(one), &one);
+        
+        std::unique_ptr<TrafficWorker[]> workers(new TrafficWorker[threads]);
+        const long samples = std::max<long>(static_cast<long>(iterations) * 1000 / CHASE_HOPS_PER_SAMPLE, 1);
+        std::atomic<bool> stop(false);
+        int count = 0;
+        
+        for (uint32_t delay : delays) {
+            if (count >= max_points) {
+                break;
+            }
+            stop.store(false);
+            std::vector<std::thread> traffic;
+            traffic.reserve(threads);
+            for (int t = 0; t < threads; t++) {
+                TrafficWorker& w = workers[t];
+                w.blocks.store(0, std::memory_order_relaxed);
+                w.cpu = t + 1 < static_cast<int>(cpus.size()) ? cpus[t + 1] : -1;
+                w.spread = &spread;
+                traffic.emplace_back([&, delay, t] {
+                    run_traffic(workers[t], data_start() + traffic_offset + t * slice_size,
+                                slice_size / block_size, block_size, write_percent, delay, stop);
+                });
+            }
+            
+            // Let the load settle before measuring under it
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOADED_WARMUP_MS));
+            uint64_t blocks_before = 0;
+            for (int t = 0; t < threads; t++) {
+                blocks_before += workers[t].blocks.load(std::memory_order_relaxed);
+            }
+            auto start = std::chrono::steady_clock::now();
+            latency_hist.reset();
+            node = sample_chase(node, samples);
+            auto end = std::chrono::steady_clock::now();
+            uint64_t blocks_after = 0;
+            for (int t = 0; t < threads; t++) {
+                blocks_after += workers[t].blocks.load(std::memory_order_relaxed);
+            }
+            
+            stop.store(true);
+            for (auto& thread : traffic) {
+                thread.join();
+            }
+            
+            std::chrono::duration<double> elapsed = end - start;
+            cxl_loaded_latency_point& point = points[count++];
+            point.delay = delay;
+            point.traffic_threads = threads;
+            point.traffic_gbps = elapsed.count() > 0 ?
+                static_cast<double>(blocks_after - blocks_before) * block_size /
+                (elapsed.count() * 1024 * 1024 * 1024) : 0.0;
+            fill_stats(latency_hist, &point.latency);
+        }
+        chase_sink = node;
+        
+        if (restore) {
+            sched_setaffinity(0, sizeof(saved), &saved);
+        }
+        return count;
+    }
+
+    // Open the counters collected around every timed loop; -1 if none could be opened
+    int enable_perf(const char* uncore_events) {
+        perf_measured = false;
+        uint32_t valid = perf.open(uncore_events);
+        return perf.active() ? static_cast<int>(valid) : -1;
+    }
+
+    void disable_perf() {
+        perf.close();
+        perf_measured = false;
+    }
+
+    int get_perf(cxl_perf_counters* counters) const {
+        if (!counters || !perf_measured) {
+            return -1;
+        }
+        *counters = perf_last;
+        return 0;
+    }
+
+    // Move blocks in one of the access patterns, optionally timing each access
+    double test_pattern(const cxl_pattern_config* config, int iterations, cxl_pattern_result* result,
+                        cxl_latency_stats* stats) {
+        if (result) {
+            memset(result, 0, sizeof(*result));
+        }
+        if (stats) {
+            memset(stats, 0, sizeof(*stats));
+            latency_hist.reset();
+        }
+        if (!initialized || !config || config->block_size == 0 || iterations <= 0) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return 0.0;
+        }
+
+        const int pattern = config->pattern;
+        const bool gather = pattern == CXL_PATTERN_GATHER;
+        const bool scatter = pattern == CXL_PATTERN_SCATTER;
+        const bool is_write = scatter || (!gather && config->is_write);
+        const size_t block_size = config->block_size;
+        const size_t span = config->working_set ? std::min(config->working_set, data_size()) : data_size();
+        if (block_size > span) {
+            std::cerr << "Block size " << block_size << " exceeds the " << span
+                      << "-byte working set" << std::endl;
+            return 0.0;
+        }
+
+        // Gather/scatter move each block as element-sized pieces, the last one possibly short
+        size_t unit = block_size;
+        if (gather || scatter) {
+            unit = std::min(config->element_size ? config->element_size : 64, block_size);
+        }
+        size_t stride = config->stride ? config->stride : 4 * block_size;
+        CXLAccessPattern order;
+        if (!order.init(pattern, span, unit, std::max<size_t>(stride / block_size, 1), config->seed)) {
+            std::cerr << "Invalid access pattern " << pattern << std::endl;
+            return 0.0;
+        }
+
+        char* host = static_cast<char*>(aligned_alloc(64, (block_size + 63) & ~static_cast<size_t>(63)));
+        if (!host) {
+            std::cerr << "Failed to allocate a " << block_size << "-byte host buffer" << std::endl;
+            return 0.0;
+        }
+        memset(host, 0x5A, block_size);
+
+        char* base = data_start();
+        auto access = [&] {
+            if (unit == block_size) {
+                char* block = base + order.next();
+                if (is_write) {
+                    modelled(block_size, [&] { kernel->copy(block, host, block_size); });
+                } else {
+                    modelled(block_size, [&] { memcpy(host, block, block_size); });
+                }
+                return;
+            }
+            modelled(block_size, [&] {
+                for (size_t done = 0; done < block_size; done += unit) {
+                    size_t length = std::min(unit, block_size - done);
+                    char* piece = base + order.next();
+                    if (scatter) {
+                        kernel->copy(piece, host + done, length);
+                    } else {
+                        memcpy(host + done, piece, length);
+                    }
+                }
+            });
+        };
+
+        const double ns_per_tick = stats ? cxl_tsc_ns_per_tick() : 0.0;
+        const uint64_t overhead = stats ? cxl_tsc_overhead_ticks() : 0;
+        perf_begin();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            if (!stats) {
+                access();
+                continue;
+            }
+            uint64_t t0 = cxl_rdtscp();
+            access();
+            uint64_t t1 = cxl_rdtscp();
+            uint64_t ticks = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+            latency_hist.record(static_cast<uint64_t>(ticks * ns_per_tick + 0.5));
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        perf_end();
+        free(host);
+
+        double seconds = elapsed.count();
+        double bandwidth = seconds > 0.0 ? static_cast<double>(block_size) * iterations /
+                                           (seconds * 1024 * 1024 * 1024) : 0.0;
+        if (result) {
+            result->pattern = pattern;
+            result->is_write = is_write ? 1 : 0;
+            result->block_size = block_size;
+            result->accesses = static_cast<uint64_t>(iterations);
+            result->seconds = seconds;
+            result->gbps = bandwidth;
+            result->ns_per_access = seconds * 1e9 / iterations;
+        }
+        fill_stats(latency_hist, stats);
+        return bandwidth;
+    }
+
+    // Run a pattern at doubling block sizes, each moving about bytes_per_point
+    int pattern_sweep(const cxl_pattern_config* config, size_t min_block_size, size_t max_block_size,
+                      size_t bytes_per_point, cxl_pattern_result* points, int max_points) {
+        if (!initialized || !config || !points || max_points <= 0 || min_block_size == 0) {
+            return -1;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return -1;
+        }
+
+        size_t span = config->working_set ? std::min(config->working_set, data_size()) : data_size();
+        max_block_size = std::min(max_block_size, span);
+
+        cxl_pattern_config point_config = *config;
+        int count = 0;
+        for (size_t block = min_block_size; block <= max_block_size && count < max_points; block *= 2) {
+            point_config.block_size = block;
+            int iterations = static_cast<int>(std::min<size_t>(std::max<size_t>(bytes_per_point / block, 1),
+                                                               INT32_MAX));
+            if (test_pattern(&point_config, iterations, &points[count], nullptr) <= 0.0) {
+                return count ? count : -1;
+            }
+            count++;
+            if (block > SIZE_MAX / 2) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    // Export the histogram from the last test_latency_histogram run as JSON
+    size_t latency_json(char* buf, size_t len) const {
+        return latency_hist.to_json(buf, len, "ns");
+    }
+
+    // Run a compute kernel over three float arrays at the start of the benchmark area
+    double test_compute(const cxl_compute_config* config, cxl_compute_result* result) {
+        if (result) {
+            memset(result, 0, sizeof(*result));
+        }
+        if (!initialized) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return 0.0;
+        }
+        
+        cxl_compute_config settings = {};
+        if (config) {
+            settings = *config;
+        }
+        settings.elements = settings.elements ? settings.elements : 4UL << 20;
+        settings.iterations = settings.iterations > 0 ? settings.iterations : 10;
+        settings.tile_bytes = settings.tile_bytes ? settings.tile_bytes : 16UL << 10;
+        
+        const CXLComputeOps* ops = cxl_compute_ops(settings.isa);
+        if (!ops || settings.op < 0 || settings.op >= CXL_COMPUTE_OP_COUNT) {
+            return 0.0;
+        }
+        
+        // Arrays start on their own cache lines
+        const size_t array_bytes = (settings.elements * sizeof(float) + 63) & ~static_cast<size_t>(63);
+        if (3 * array_bytes > data_size()) {
+            std::cerr << "Region too small for compute test" << std::endl;
+            return 0.0;
+        }
+        float* a = reinterpret_cast<float*>(data_start());
+        float* b = reinterpret_cast<float*>(data_start() + array_bytes);
+        float* c = reinterpret_cast<float*>(data_start() + 2 * array_bytes);
+        for (size_t i = 0; i < settings.elements; i++) {
+            a[i] = 1.0f;
+            b[i] = 2.0f;
+            c[i] = 0.0f;
+        }
+        
+        const size_t tile = std::max<size_t>(settings.tile_bytes / sizeof(float), 16);
+        double checksum = 0.0;
+        perf_begin();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < settings.iterations; i++) {
+            checksum = modelled_compute(ops, settings.op, c, a, b, 3.0f, settings.elements, tile);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        perf_end();
+        
+        double flops_per_element, bytes_per_element;
+        cxl_compute_cost(settings.op, &flops_per_element, &bytes_per_element);
+        const double elements = static_cast<double>(settings.elements) * settings.iterations;
+        const double gflops = elapsed.count() > 0 ? elements * flops_per_element / (elapsed.count() * 1e9) : 0.0;
+        
+        if (result) {
+            result->isa = ops->isa;
+            result->flops = elements * flops_per_element;
+            result->bytes = elements * bytes_per_element;
+            result->seconds = elapsed.count();
+            result->gflops = gflops;
+            result->gbps = elapsed.count() > 0 ? result->bytes / (elapsed.count() * 1024 * 1024 * 1024) : 0.0;
+            result->bytes_per_flop = bytes_per_element / flops_per_element;
+            result->checksum = settings.op == CXL_COMPUTE_DOT || settings.op == CXL_COMPUTE_SUM ? checksum : c[0];
+        }
+        return gflops;
+    }
+
+    // Pass messages through queues laid out at the start of the benchmark area
+    double test_queue(const cxl_queue_config* config, cxl_queue_result* result) {
+        if (result) {
+            memset(result, 0, sizeof(*result));
+        }
+        if (!initialized) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return 0.0;
+        }
+        
+        cxl_queue_config settings = {};
+        if (config) {
+            settings = *config;
+        }
+        settings.capacity = settings.capacity ? settings.capacity : 1024;
+        settings.messages = settings.messages ? settings.messages : 1000000;
+        settings.round_trips = settings.round_trips > 0 ? settings.round_trips : 100000;
+        
+        if (settings.type == CXL_QUEUE_SPSC) {
+            settings.producers = settings.consumers = 1;
+            return run_queue_test<CXLSpscQueue<QueueMessage>>(settings, result);
+        }
+        if (settings.type == CXL_QUEUE_MPMC) {
+            settings.producers = std::max(settings.producers, 1);
+            settings.consumers = std::max(settings.consumers, 1);
+            return run_queue_test<CXLMpmcQueue<QueueMessage>>(settings, result);
+        }
+        return 0.0;
+    }
+    
+    // Run FPGA operations (the operation is the opcode: CMD_MEM_COPY, CMD_MEM_FILL or
+    // CMD_ACCELERATE) on the device through the command ring. Only simulation builds
+    // fall back to running them on the CPU.
+    double test_fpga(int operation, int iterations, cxl_fpga_result* result) {
+        cxl_fpga_result local;
+        if (!result) {
+            result = &local;
+        }
+        memset(result, 0, sizeof(*result));
+        if (!initialized || iterations <= 0 || operation < CMD_MEM_COPY || operation > CMD_ACCELERATE) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return 0.0;
+        }
+        
+        if (rings_open()) {
+            result->engine = CXL_FPGA_ENGINE_DEVICE;
+            return run_fpga_device(operation, iterations, result);
+        }
+#ifdef SIMULATION_MODE
+        result->engine = CXL_FPGA_ENGINE_CPU;
+        return emulate_fpga(operation, iterations, result);
+#else
+        std::cerr << "No FPGA command ring on this device" << std::endl;
+        return 0.0;
+#endif
+    }
+
+private:
+    static constexpr size_t CHASE_DEFAULT_WORKING_SET = 8UL << 20;  // 1M pointer-sized nodes
+    static constexpr int CHASE_HOPS_PER_SAMPLE = 64;                // Hops per timed histogram sample
+    static constexpr size_t LOADED_DEFAULT_BLOCK = 1024;            // Traffic access size for loaded latency
+    static constexpr int LOADED_WARMUP_MS = 20;                     // Traffic before each loaded measurement
+
+    // Benchmarks work in the scratch extent, clear of the header and of every
+    // allocation and object; without a header that is the whole region
+    char* data_start() const {
+        return static_cast<char*>(mapped_region) + scratch_offset;
+    }
+    
+    size_t data_size() const {
+        return scratch_bytes;
+    }
+
+    // Open every device of a set and map them as one striped region; size is
+    // rounded up so each device holds the same number of stripe units. A set of
+    // DAX devices is described in dax (by the first one, with the largest alignment)
+    bool open_stripes(const std::vector<std::string>& devices, size_t& size, size_t granularity,
+                      CXLDaxInfo* dax) {
+        const int ways = static_cast<int>(devices.size());
+        std::vector<int> fds;
+        std::vector<CXLDaxInfo> infos(devices.size());
+        auto close_all = [&fds]() {
+            for (int opened : fds) {
+                close(opened);
+            }
+        };
+        for (size_t i = 0; i < devices.size(); i++) {
+            int device_fd = open(devices[i].c_str(), O_RDWR);
+            if (device_fd < 0) {
+                std::cerr << "Failed to open CXL device at " << devices[i] << std::endl;
+                close_all();
+                return false;
+            }
+            fds.push_back(device_fd);
+            cxl_dax_probe(device_fd, &infos[i]);
+            if (infos[i].kind != infos[0].kind) {
+                std::cerr << "Can't interleave DAX and non-DAX devices (" << devices[i] << ")" << std::endl;
+                close_all();
+                return false;
+            }
+        }
+        
+        // Every stripe unit is its own mapping, so it takes the devices' alignment
+        *dax = infos[0];
+        for (const CXLDaxInfo& info : infos) {
+            dax->align = std::max(dax->align, info.align);
+        }
+        if (dax->kind != CXL_DAX_NONE) {
+            if (granularity && granularity < dax->align) {
+                std::cerr << "Interleave granularity " << granularity << " is below the DAX alignment of "
+                          << dax->align << std::endl;
+                close_all();
+                return false;
+            }
+            granularity = std::max(granularity, dax->align);
+        }
+        size_t granule = cxl_interleave_granule(granularity, size, ways);
+        if (!granule) {
+            close_all();
+            return false;
+        }
+        
+        layout.ways = ways;
+        layout.granule = granule;
+        size = (size + granule * ways - 1) / (granule * ways) * (granule * ways);
+        for (size_t i = 0; i < infos.size(); i++) {
+            if (infos[i].kind == CXL_DAX_DEVICE && layout.device_size(size) > infos[i].capacity) {
+                std::cerr << "DAX device " << devices[i] << " holds " << infos[i].capacity << " bytes, "
+                          << layout.device_size(size) << " needed" << std::endl;
+                layout = CXLInterleave();
+                close_all();
+                return false;
+            }
+        }
+        fd = fds[0];
+        stripe_fds.assign(fds.begin() + 1, fds.end());
+        mapped_region = cxl_interleave_map(fds, layout, size);
+        return true;
+    }
+    
+    // Mapping attributes the driver chose; plain files and host memory are cached as usual
+    int query_cache_mode() const {
+        uint32_t mode = 0;
+        if (fd >= 0 && ioctl(fd, CXL_MEM_GET_CACHE_MODE, &mode) == 0) {
+            return static_cast<int>(mode);
+        }
+        return CXL_CACHE_WRITE_BACK;
+    }
+    
+    // Library commands on a write-back mapping run between two passes over their
+    // region ranges: before, to push out what the CPU wrote and drop the lines the
+    // device rewrites; after, to drop whatever was speculatively refetched meanwhile.
+    // Callers fence once per chain.
+    bool device_coherence() const {
+        return cache_mode == CXL_CACHE_WRITE_BACK && rings_open();
+    }
+    
+    void close_devices() {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+        for (int stripe_fd : stripe_fds) {
+            close(stripe_fd);
+        }
+        stripe_fds.clear();
+        layout = CXLInterleave();
+    }
+    
+    // Every device has a command ring
+    bool rings_open() const {
+        if (!ring.is_open()) {
+            return false;
+        }
+        for (const auto& stripe_ring : stripe_rings) {
+            if (!stripe_ring->is_open()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    CXLCommandRing& device_ring(int device) {
+        return device == 0 ? ring : *stripe_rings[device - 1];
+    }
+    
+    // Turn a command on region offsets into one for the device holding them; it
+    // has to stay within a stripe unit, and a copy's source on the same device
+    bool route_command(cxl_command* cmd, int* device) const {
+        if (cmd->length > layout.run(cmd->address)) {
+            return false;
+        }
+        *device = layout.device_of(cmd->address);
+        cmd->address = layout.device_offset(cmd->address);
+        if (cmd->opcode == CMD_MEM_COPY && !(cmd->flags & CXL_CMD_FLAG_HOST_VA)) {
+            if (layout.device_of(cmd->data) != *device || cmd->length > layout.run(cmd->data)) {
+                return false;
+            }
+            cmd->data = layout.device_offset(cmd->data);
+        }
+        return true;
+    }
+    
+    // Device offsets [start, end) that lie in the scratch extent on every device
+    void device_scratch(uint64_t* start, uint64_t* end) const {
+        if (!layout.striped()) {
+            *start = scratch_offset;
+            *end = scratch_offset + scratch_bytes;
+            return;
+        }
+        const uint64_t stripe = layout.granule * layout.ways;
+        *start = (scratch_offset + stripe - 1) / stripe * layout.granule;
+        *end = std::max(*start, (scratch_offset + scratch_bytes) / stripe * layout.granule);
+    }
+
+    static constexpr size_t FPGA_TEST_BUFFER = 1UL << 20;              // Bytes per FPGA test command
+    static constexpr size_t ACCELERATE_TILE = 4096;                    // Floats per CPU accelerate tile
+
+    // Give the accelerate test real floats the first time it runs on this mapping,
+    // in the CPU test buffer and on a device set in each device's own test buffer
+    void prepare_accelerate_buffer() {
+        if (accelerate_ready) {
+            return;
+        }
+        float* data = reinterpret_cast<float*>(data_start());
+        for (size_t i = 0; i < FPGA_TEST_BUFFER / sizeof(float); i++) {
+            data[i] = static_cast<float>(i);
+        }
+        uint64_t start, end;
+        device_scratch(&start, &end);
+        for (int device = 0; layout.striped() && device < layout.ways && start + FPGA_TEST_BUFFER <= end; device++) {
+            for (size_t i = 0; i < FPGA_TEST_BUFFER / sizeof(float); i++) {
+                uint64_t offset = layout.logical_offset(device, start + i * sizeof(float));
+                *reinterpret_cast<float*>(static_cast<char*>(mapped_region) + offset) = static_cast<float>(i);
+            }
+        }
+        accelerate_ready = true;
+    }
+
+    // Scale factors alternate around 1 so repeated runs keep the data in range
+    static float accelerate_scalar(int n) {
+        return (n & 1) ? 1.0f / 1.01f : 1.01f;
+    }
+
+    // Time operations on the device itself. Commands go out in chains of up to half
+    // the ring with one doorbell each, and the clock stops once the last completion
+    // of the last chain is reaped. Copies read the first buffer of the benchmark area
+    // and write the ones after it; compute scales the first buffer in place. A device
+    // set runs every nth command on each device, all chains in flight at once, with
+    // buffers in device offsets past the header.
+    double run_fpga_device(int operation, int iterations, cxl_fpga_result* result) {
+        const size_t buffer_size = FPGA_TEST_BUFFER;
+        const int ways = layout.ways;
+        uint64_t source, device_end;
+        device_scratch(&source, &device_end);
+        if (source + 2 * buffer_size > device_end) {
+            std::cerr << "Region too small for FPGA test" << std::endl;
+            return 0.0;
+        }
+        const size_t targets = (device_end - source) / buffer_size - 1;
+        
+        if (operation == CMD_ACCELERATE) {
+            prepare_accelerate_buffer();
+        }
+        // The test buffers span the data area; sync it once around the timed loop
+        const bool coherence = device_coherence();
+        if (coherence) {
+            cxl_cache_invalidate(data_start(), data_size());
+            cxl_cache_fence(false);
+        }
+        
+        const int max_chain = CXL_RING_ENTRIES / 2;
+        std::vector<struct cxl_ring_sqe> sqes(static_cast<size_t>(ways) * max_chain);
+        std::vector<struct cxl_ring_cqe> cqes(sqes.size());
+        std::vector<uint32_t> ids(sqes.size());
+        std::vector<int> chains(ways), posted(ways);
+        
+        perf_begin();
+        auto start = std::chrono::steady_clock::now();
+        for (int issued = 0; issued < iterations;) {
+            int round = std::min(iterations - issued, max_chain * ways);
+            std::fill(chains.begin(), chains.end(), 0);
+            for (int i = 0; i < round; i++) {
+                const int n = issued + i;
+                const int device = n % ways;
+                const int local = n / ways;
+                const size_t slot = static_cast<size_t>(device) * max_chain + chains[device]++;
+                ids[slot] = 0x80000000u | (next_cmd_id.fetch_add(1, std::memory_order_relaxed) & 0x7fffffffu);
+                sqes[slot] = {};
+                sqes[slot].id = ids[slot];
+                sqes[slot].opcode = static_cast<uint32_t>(operation);
+                sqes[slot].length = static_cast<uint32_t>(buffer_size);
+                sqes[slot].address = source + (1 + local % targets) * buffer_size;
+                if (operation == CMD_MEM_COPY) {
+                    sqes[slot].data = source;
+                } else if (operation == CMD_MEM_FILL) {
+                    sqes[slot].data = n & 0xFF;
+                } else {
+                    float scalar = accelerate_scalar(n);
+                    uint32_t bits;
+                    memcpy(&bits, &scalar, sizeof(bits));
+                    sqes[slot].address = source;
+                    sqes[slot].data = bits;
+                }
+            }
+            
+            bool stopped = false;
+            for (int device = 0; device < ways; device++) {
+                const size_t first = static_cast<size_t>(device) * max_chain;
+                posted[device] = chains[device] ? device_ring(device).submit(&sqes[first], chains[device]) : 0;
+                if (chains[device] && posted[device] <= 0) {
+                    std::cerr << "FPGA command ring rejected the test commands" << std::endl;
+                    stopped = true;
+                }
+            }
+            for (int device = 0; device < ways; device++) {
+                const size_t first = static_cast<size_t>(device) * max_chain;
+                if (posted[device] <= 0) {
+                    continue;
+                }
+                if (device_ring(device).collect(&ids[first], posted[device], &cqes[first], 5000) != 0) {
+                    std::cerr << "Timed out waiting for FPGA test commands" << std::endl;
+                    result->failed += posted[device];
+                    stopped = true;
+                    continue;
+                }
+                for (int i = 0; i < posted[device]; i++) {
+                    if (cqes[first + i].status == CXL_CMD_STATUS_COMPLETED) {
+                        result->commands++;
+                        result->bytes += buffer_size;
+                    } else {
+                        result->failed++;
+                    }
+                }
+                issued += posted[device];
+            }
+            if (stopped) {
+                break;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        perf_end();
+        if (coherence) {
+            cxl_cache_invalidate(data_start(), data_size());
+            cxl_cache_fence(true);
+        }
+        
+        result->seconds = elapsed.count();
+        if (result->seconds <= 0) {
+            return 0.0;
+        }
+        if (operation == CMD_ACCELERATE) {
+            // One multiply per float, as in the CPU version
+            result->rate = (static_cast<double>(result->bytes) / sizeof(float)) / (result->seconds * 1e9);
+        } else {
+            result->rate = static_cast<double>(result->bytes) / (result->seconds * 1024 * 1024 * 1024);
+        }
+        return result->rate;
+    }
+
+#ifdef SIMULATION_MODE
+    // Stand-in for the FPGA when simulating: the same operations on the CPU
+    double emulate_fpga(int operation, int iterations, cxl_fpga_result* result) {
+        // For this simulation, we'll just create different memory access patterns
+        // based on the operation type
+        
+        const size_t buffer_size = FPGA_TEST_BUFFER;
+        
+        // Check if we have enough memory
+        if (buffer_size > data_size()) {
+            std::cerr << "Region too small for FPGA test" << std::endl;
+            return 0.0;
+        }
+        
+        switch (operation) {
+            case 1: { // memcpy
+                // Allocate source and destination buffers
+                void* src = malloc(buffer_size);
+                if (!src) return 0.0;
+                
+                // Fill source with random data
+                std::memset(src, 0xAA, buffer_size);
+                
+                perf_begin();
+                auto start = std::chrono::high_resolution_clock::now();
                 
                 for (int i = 0; i < iterations; i++) {
                     // Simulate FPGA memcpy (just do a standard memcpy for now)
-                    size_t offset = (i * buffer_size) % (region_size - buffer_size);
-                    void* dest = static_cast<char*>(mapped_region) + offset;
-                    memcpy(dest, src, buffer_size);
+                    void* dest = data_start() + block_offset(i, buffer_size);
+                    modelled(buffer_size, [&] { kernel->copy(dest, src, buffer_size); });
                 }
                 
                 auto end = std::chrono::high_resolution_clock::now();
+                perf_end();
                 std::chrono::duration<double> elapsed = end - start;
                 
                 free(src);
@@ -237,26 +1798,33 @@ public:
                 double bandwidth = (static_cast<double>(buffer_size) * iterations) / 
                                   (elapsed.count() * 1024 * 1024 * 1024);
                 
+                result->bytes = static_cast<uint64_t>(buffer_size) * iterations;
+                result->seconds = elapsed.count();
+                result->rate = bandwidth;
                 return bandwidth;
             }
             
             case 2: { // memfill
+                perf_begin();
                 auto start = std::chrono::high_resolution_clock::now();
                 
                 for (int i = 0; i < iterations; i++) {
                     // Simulate FPGA memfill
-                    size_t offset = (i * buffer_size) % (region_size - buffer_size);
-                    void* dest = static_cast<char*>(mapped_region) + offset;
-                    memset(dest, i & 0xFF, buffer_size);
+                    void* dest = data_start() + block_offset(i, buffer_size);
+                    modelled(buffer_size, [&] { kernel->fill(dest, i & 0xFF, buffer_size); });
                 }
                 
                 auto end = std::chrono::high_resolution_clock::now();
+                perf_end();
                 std::chrono::duration<double> elapsed = end - start;
                 
                 // Calculate bandwidth in GB/s
                 double bandwidth = (static_cast<double>(buffer_size) * iterations) / 
                                   (elapsed.count() * 1024 * 1024 * 1024);
                 
+                result->bytes = static_cast<uint64_t>(buffer_size) * iterations;
+                result->seconds = elapsed.count();
+                result->rate = bandwidth;
                 return bandwidth;
             }
             
@@ -265,32 +1833,30 @@ public:
                 // and perform vector addition operations
                 
                 const size_t num_elements = buffer_size / sizeof(float);
-                float* data = static_cast<float*>(mapped_region);
-                
-                // Initialize data
-                for (size_t i = 0; i < num_elements; i++) {
-                    data[i] = static_cast<float>(i);
-                }
+                float* data = reinterpret_cast<float*>(data_start());
+                const CXLComputeOps* ops = cxl_compute_ops(CXL_COMPUTE_ISA_AUTO);
+                prepare_accelerate_buffer();
                 
+                perf_begin();
                 auto start = std::chrono::high_resolution_clock::now();
                 
-                // Simulate compute operations
+                // Same in-place scale CMD_ACCELERATE runs, with the vector kernels
                 for (int i = 0; i < iterations; i++) {
-                    // Perform vector scaling operation: data[j] = data[j] * scalar
-                    float scalar = static_cast<float>(i) * 0.01f;
-                    
-                    for (size_t j = 0; j < num_elements; j++) {
-                        data[j] *= scalar;
-                    }
+                    modelled_compute(ops, CXL_COMPUTE_SCALE, data, data, nullptr,
+                                     accelerate_scalar(i), num_elements, ACCELERATE_TILE);
                 }
                 
                 auto end = std::chrono::high_resolution_clock::now();
+                perf_end();
                 std::chrono::duration<double> elapsed = end - start;
                 
                 // Calculate performance in GFLOPS (1 multiply per element)
                 double gflops = (static_cast<double>(num_elements) * iterations) / 
                                (elapsed.count() * 1e9);
                 
+                result->bytes = static_cast<uint64_t>(buffer_size) * iterations;
+                result->seconds = elapsed.count();
+                result->rate = gflops;
                 return gflops;
             }
             
@@ -298,11 +1864,784 @@ public:
                 return 0.0;
         }
     }
-};
+#endif
 
-// C interface for the CXL Memory Manager
+    // Ask for huge or base pages over the start of the benchmark area; effective for
+    // pages faulted after the call, and collapsed in place where the kernel supports it
+    void apply_page_mode(size_t length, int page_mode) {
+        const size_t huge = 2UL << 20;
+        length = (length + huge - 1) & ~(huge - 1);
+        length = std::min(length, data_size());
+        
+        if (page_mode == CXL_PAGES_HUGE) {
+            madvise(data_start(), length, MADV_HUGEPAGE);
+#ifdef MADV_COLLAPSE
+            madvise(data_start(), length, MADV_COLLAPSE);
+#endif
+        } else if (page_mode == CXL_PAGES_4K) {
+            madvise(data_start(), length, MADV_NOHUGEPAGE);
+        }
+    }
 
-extern "C" {
+    // Build a randomly ordered pointer-chasing cycle over the first working_set bytes
+    // of the benchmark area, one node every stride bytes; returns the first node
+    void** build_chase(size_t working_set, size_t stride, int page_mode) {
+        if (working_set > data_size()) {
+            std::cerr << "Region too small for latency test" << std::endl;
+            return nullptr;
+        }
+        if (stride < sizeof(void*) || stride % sizeof(void*) != 0 || working_set / stride < 2) {
+            std::cerr << "Invalid pointer chase stride " << stride << " for working set "
+                      << working_set << std::endl;
+            return nullptr;
+        }
+        
+        apply_page_mode(working_set, page_mode);
+        
+        // Create random permutation of the nodes to avoid prefetching
+        const size_t nodes = working_set / stride;
+        std::vector<size_t> order(nodes);
+        for (size_t i = 0; i < nodes; i++) {
+            order[i] = i;
+        }
+        
+        std::random_device rd;
+        std::mt19937_64 g(rd());
+        std::shuffle(order.begin(), order.end(), g);
+        
+        // Link each node to the next one in the permutation, closing the cycle
+        char* base = data_start();
+        for (size_t i = 0; i < nodes; i++) {
+            void** node = reinterpret_cast<void**>(base + order[i] * stride);
+            *node = base + order[(i + 1) % nodes] * stride;
+        }
+        
+        // Warm up the list to ensure it's in memory
+        void** node = reinterpret_cast<void**>(base + order[0] * stride);
+        for (size_t i = 0; i < nodes; i++) {
+            node = static_cast<void**>(*node);
+        }
+        chase_sink = node;
+        
+        return node;
+    }
+
+    // Walk samples chunks of CHASE_HOPS_PER_SAMPLE hops from node, recording the
+    // per-hop time of each chunk in latency_hist; returns where the walk ended
+    void** sample_chase(void** node, long samples) {
+        const double ns_per_tick = cxl_tsc_ns_per_tick();
+        const uint64_t overhead = cxl_tsc_overhead_ticks();
+        
+        for (long s = 0; s < samples; s++) {
+            uint64_t t0 = cxl_rdtscp();
+            for (int j = 0; j < CHASE_HOPS_PER_SAMPLE; j++) {
+                node = static_cast<void**>(*node);
+                sim_model.access();
+            }
+            uint64_t t1 = cxl_rdtscp();
+            
+            uint64_t ticks = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+            latency_hist.record(static_cast<uint64_t>(
+                ticks * ns_per_tick / CHASE_HOPS_PER_SAMPLE + 0.5));
+        }
+        return node;
+    }
+    
+    // Background load for loaded_latency, counted in blocks so the chase can sample it
+    struct alignas(64) TrafficWorker {
+        std::atomic<uint64_t> blocks;
+        int cpu;                // -1 = any CPU in spread
+        const cpu_set_t* spread;
+    };
+    
+    void run_traffic(TrafficWorker& w, char* base, size_t slice_blocks, size_t block_size, int write_percent,
+                     uint32_t delay, const std::atomic<bool>& stop) {
+        if (w.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(w.cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        } else if (w.spread) {
+            pthread_setaffinity_np(pthread_self(), sizeof(*w.spread), w.spread);
+        }
+        void* host = aligned_alloc(64, (block_size + 63) & ~static_cast<size_t>(63));
+        if (!host) {
+            return;
+        }
+        memset(host, 0xA5, block_size);
+        
+        // Writes spread evenly through the reads: write_percent of every hundred blocks
+        int mix = 0;
+        for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); i++) {
+            char* block = base + (i % slice_blocks) * block_size;
+            mix += write_percent;
+            if (mix >= 100) {
+                mix -= 100;
+                modelled(block_size, [&] { kernel->copy(block, host, block_size); });
+            } else {
+                modelled(block_size, [&] { memcpy(host, block, block_size); });
+            }
+            w.blocks.store(i + 1, std::memory_order_relaxed);
+            for (uint32_t k = 0; k < delay; k++) {
+                cxl_cpu_relax();
+            }
+        }
+        free(host);
+    }
+
+    static void fill_stats(const CXLHistogram& hist, cxl_latency_stats* stats) {
+        if (!stats) {
+            return;
+        }
+        stats->samples = hist.count();
+        stats->min_ns = static_cast<double>(hist.min());
+        stats->mean_ns = hist.mean();
+        stats->p50_ns = static_cast<double>(hist.percentile(0.50));
+        stats->p90_ns = static_cast<double>(hist.percentile(0.90));
+        stats->p99_ns = static_cast<double>(hist.percentile(0.99));
+        stats->p999_ns = static_cast<double>(hist.percentile(0.999));
+        stats->max_ns = static_cast<double>(hist.max());
+    }
+
+    // One compute pass, charged to the simulation model as a transfer of the bytes it moves
+    double modelled_compute(const CXLComputeOps* ops, int op, float* dst, const float* a,
+                            const float* b, float s, size_t n, size_t tile) {
+        double value = 0.0;
+        double bytes_per_element;
+        cxl_compute_cost(op, nullptr, &bytes_per_element);
+        modelled(static_cast<size_t>(n * bytes_per_element),
+                 [&] { value = cxl_compute_run(ops, op, dst, a, b, s, n, tile); });
+        return value;
+    }
+
+    // Spin briefly, then give the CPU away so oversubscribed runs still make progress
+    static void queue_backoff(unsigned& spins) {
+        if (++spins < 1024) {
+            cxl_cpu_relax();
+        } else {
+            sched_yield();
+        }
+    }
+
+    // Message passed through the queue benchmarks
+    struct QueueMessage {
+        uint64_t seq;
+        uint64_t payload;
+    };
+
+    // Throughput with the configured producers and consumers, then ping-pong between
+    // two threads over a pair of queues. Every thread attaches its own queue object,
+    // the same way separate processes would.
+    template <typename Queue>
+    double run_queue_test(const cxl_queue_config& settings, cxl_queue_result* result) {
+        const size_t footprint = (Queue::footprint(settings.capacity) + CXL_QUEUE_LINE - 1) &
+                                 ~static_cast<size_t>(CXL_QUEUE_LINE - 1);
+        if (2 * footprint > data_size()) {
+            std::cerr << "Region too small for queue test" << std::endl;
+            return 0.0;
+        }
+        
+        char* request_mem = data_start();
+        char* reply_mem = request_mem + footprint;
+        Queue setup;
+        if (!setup.create(request_mem, footprint, settings.capacity) ||
+            !setup.create(reply_mem, footprint, settings.capacity)) {
+            std::cerr << "Invalid queue capacity " << settings.capacity << std::endl;
+            return 0.0;
+        }
+        
+        // Throughput: consumers share a host-side count to know when to stop
+        const uint64_t total = settings.messages * settings.producers;
+        std::atomic<uint64_t> consumed(0);
+        const int num_threads = settings.producers + settings.consumers;
+        pthread_barrier_t barrier;
+        pthread_barrier_init(&barrier, nullptr, num_threads + 1);
+        
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (int p = 0; p < settings.producers; p++) {
+            threads.emplace_back([&, p] {
+                Queue queue;
+                queue.attach(request_mem, footprint);
+                pthread_barrier_wait(&barrier);
+                for (uint64_t i = 0; i < settings.messages; i++) {
+                    QueueMessage msg = { i, static_cast<uint64_t>(p) };
+                    for (unsigned spins = 0; !queue.push(msg); ) {
+                        queue_backoff(spins);
+                    }
+                }
+            });
+        }
+        for (int c = 0; c < settings.consumers; c++) {
+            threads.emplace_back([&] {
+                Queue queue;
+                queue.attach(request_mem, footprint);
+                pthread_barrier_wait(&barrier);
+                QueueMessage msg;
+                unsigned spins = 0;
+                while (consumed.load(std::memory_order_relaxed) < total) {
+                    if (queue.pop(msg)) {
+                        consumed.fetch_add(1, std::memory_order_relaxed);
+                        spins = 0;
+                    } else {
+                        queue_backoff(spins);
+                    }
+                }
+            });
+        }
+        
+        pthread_barrier_wait(&barrier);
+        auto start = std::chrono::steady_clock::now();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        pthread_barrier_destroy(&barrier);
+        
+        double msgs_per_sec = elapsed.count() > 0 ? total / elapsed.count() : 0.0;
+        
+        // Ping-pong: this thread sends a request and spins for the echo
+        CXLHistogram rtt;
+        std::thread echo([&] {
+            Queue requests, replies;
+            requests.attach(request_mem, footprint);
+            replies.attach(reply_mem, footprint);
+            QueueMessage msg;
+            for (int i = 0; i < settings.round_trips; i++) {
+                for (unsigned spins = 0; !requests.pop(msg); ) {
+                    queue_backoff(spins);
+                }
+                for (unsigned spins = 0; !replies.push(msg); ) {
+                    queue_backoff(spins);
+                }
+            }
+        });
+        
+        Queue requests, replies;
+        requests.attach(request_mem, footprint);
+        replies.attach(reply_mem, footprint);
+        const double ns_per_tick = cxl_tsc_ns_per_tick();
+        const uint64_t overhead = cxl_tsc_overhead_ticks();
+        QueueMessage msg = { 0, 0 };
+        for (int i = 0; i < settings.round_trips; i++) {
+            msg.seq = i;
+            uint64_t t0 = cxl_rdtscp();
+            for (unsigned spins = 0; !requests.push(msg); ) {
+                queue_backoff(spins);
+            }
+            for (unsigned spins = 0; !replies.pop(msg); ) {
+                queue_backoff(spins);
+            }
+            uint64_t t1 = cxl_rdtscp();
+            uint64_t ticks = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+            rtt.record(static_cast<uint64_t>(ticks * ns_per_tick + 0.5));
+        }
+        echo.join();
+        
+        if (result) {
+            result->msgs_per_sec = msgs_per_sec;
+            fill_stats(rtt, &result->rtt);
+        }
+        return msgs_per_sec;
+    }
+
+    static bool valid_object_name(const char* name) {
+        return name && name[0] != '\0' && strnlen(name, CXL_OBJECT_NAME_MAX + 1) <= CXL_OBJECT_NAME_MAX;
+    }
+
+    cxl_handle_t make_handle(uint64_t offset) const {
+        return (static_cast<cxl_handle_t>(directory.region_id()) << CXL_HANDLE_OFFSET_BITS) | offset;
+    }
+
+    // Bring the allocator in line with the directory: reserve objects other processes
+    // created and release the ones they removed. Callers hold objects_lock and the
+    // directory lock.
+    void sync_objects(bool force) {
+        uint32_t generation = directory.generation();
+        if (!force && generation == objects_generation) {
+            return;
+        }
+        
+        std::unordered_map<uint64_t, uint64_t> current;
+        for (const auto& extent : directory.extents()) {
+            current.insert(extent);
+        }
+        
+        for (auto it = objects.begin(); it != objects.end();) {
+            auto found = current.find(it->first);
+            if (found == current.end() || found->second != it->second) {
+                allocator.release(it->first);
+                it = objects.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        
+        for (const auto& extent : current) {
+            if (objects.count(extent.first)) {
+                continue;
+            }
+            if (extent.first < data_offset || extent.first >= region_size ||
+                extent.second > region_size - extent.first ||
+                !allocator.reserve(extent.first, extent.second)) {
+                std::cerr << "Shared object at offset " << extent.first
+                          << " overlaps memory already allocated by this process" << std::endl;
+                continue;
+            }
+            objects.insert(extent);
+        }
+        objects_generation = generation;
+    }
+
+    // Per-thread state for the parallel bandwidth engine
+    struct BandwidthWorker {
+        int cpu;                                         // CPU the worker is pinned to (-1 = unpinned)
+        int node;                                        // NUMA node the worker ran on
+        size_t slice_offset;                             // Start of this worker's slice of the region
+        size_t slice_blocks;                             // Number of whole blocks in the slice
+        std::chrono::steady_clock::time_point start;   // Time the worker left the barrier
+        std::chrono::steady_clock::time_point end;     // Time the worker finished its loop
+    };
+
+    // Range of a vectored transfer after validation
+    struct IoSegment {
+        size_t offset;
+        char* buffer;
+        size_t length;
+    };
+
+    static void load_segments(const cxl_iovec* iov, int count, std::vector<IoSegment>& segments) {
+        segments.clear();
+        for (int i = 0; i < count; i++) {
+            if (iov[i].length) {
+                segments.push_back({ iov[i].offset, static_cast<char*>(iov[i].buffer), iov[i].length });
+            }
+        }
+    }
+
+    static void merge_segments(std::vector<IoSegment>& segments) {
+        size_t out = 0;
+        for (size_t i = 1; i < segments.size(); i++) {
+            IoSegment& last = segments[out];
+            if (segments[i].offset == last.offset + last.length &&
+                segments[i].buffer == last.buffer + last.length) {
+                last.length += segments[i].length;
+            } else {
+                segments[++out] = segments[i];
+            }
+        }
+        if (!segments.empty()) {
+            segments.resize(out + 1);
+        }
+    }
+
+    void cpu_transfer(bool is_write, const IoSegment& seg) {
+        char* region = static_cast<char*>(mapped_region) + seg.offset;
+        if (is_write) {
+            modelled(seg.length, [&] { kernel->copy(region, seg.buffer, seg.length); });
+        } else {
+            modelled(seg.length, [&] { memcpy(seg.buffer, region, seg.length); });
+        }
+    }
+
+    // Run the segments as CMD_MEM_COPY chains through the ring, one doorbell per
+    // chain; anything the device rejects or fails is copied on the CPU. On a device
+    // set pieces are cut at stripe units and every device gets its own chain.
+    // Returns false (errno set) when a chain could not be collected: its commands
+    // may still be moving data, so copying the same bytes on the CPU is not safe.
+    bool fpga_transfer(bool is_write, const std::vector<IoSegment>& segments) {
+        const size_t max_piece = 1UL << 31;         // Commands carry a 32-bit length
+        const int max_chain = CXL_RING_ENTRIES / 2;  // Leave ring space for other users
+        const int ways = layout.ways;
+        
+        thread_local std::vector<std::vector<IoSegment>> pieces;
+        pieces.resize(ways);
+        for (auto& queue : pieces) {
+            queue.clear();
+        }
+        for (const IoSegment& seg : segments) {
+            for (size_t done = 0; done < seg.length;) {
+                uint64_t offset = seg.offset + done;
+                size_t length = std::min<uint64_t>({ max_piece, seg.length - done, layout.run(offset) });
+                pieces[layout.device_of(offset)].push_back({ offset, seg.buffer + done, length });
+                done += length;
+            }
+        }
+        
+        thread_local std::vector<struct cxl_ring_sqe> sqes;
+        thread_local std::vector<struct cxl_ring_cqe> cqes;
+        thread_local std::vector<uint32_t> ids;
+        sqes.resize(static_cast<size_t>(ways) * max_chain);
+        cqes.resize(sqes.size());
+        ids.resize(sqes.size());
+        std::vector<size_t> next(ways, 0);
+        const bool coherence = device_coherence();
+        std::vector<int> chains(ways), posted(ways);
+        int lost = 0;
+        
+        while (!lost) {
+            bool pending = false;
+            for (int device = 0; device < ways; device++) {
+                const size_t first = static_cast<size_t>(device) * max_chain;
+                chains[device] = static_cast<int>(std::min(pieces[device].size() - next[device],
+                                                           static_cast<size_t>(max_chain)));
+                posted[device] = 0;
+                if (!chains[device]) {
+                    continue;
+                }
+                pending = true;
+                for (int i = 0; i < chains[device]; i++) {
+                    const IoSegment& piece = pieces[device][next[device] + i];
+                    if (coherence) {
+                        cxl_cache_invalidate(static_cast<char*>(mapped_region) + piece.offset, piece.length);
+                    }
+                    ids[first + i] = 0x80000000u | (next_cmd_id.fetch_add(1, std::memory_order_relaxed) & 0x7fffffffu);
+                    sqes[first + i].id = ids[first + i];
+                    sqes[first + i].opcode = CMD_MEM_COPY;
+                    sqes[first + i].address = layout.device_offset(piece.offset);
+                    sqes[first + i].data = reinterpret_cast<uintptr_t>(piece.buffer);
+                    sqes[first + i].length = static_cast<uint32_t>(piece.length);
+                    sqes[first + i].flags = CXL_CMD_FLAG_HOST_VA | (is_write ? 0 : CXL_CMD_FLAG_TO_HOST);
+                }
+                if (coherence) {
+                    cxl_cache_fence(false);
+                }
+                posted[device] = device_ring(device).submit(&sqes[first], chains[device]);
+            }
+            if (!pending) {
+                break;
+            }
+            
+            for (int device = 0; device < ways; device++) {
+                if (!chains[device]) {
+                    continue;
+                }
+                const size_t first = static_cast<size_t>(device) * max_chain;
+                int ret = posted[device] > 0 ?
+                          device_ring(device).collect(&ids[first], posted[device], &cqes[first], 5000) : 0;
+                if (ret != 0) {
+                    // Keep collecting the other devices' chains, then fail the call
+                    std::cerr << "FPGA copy chain was not collected: " << strerror(-ret) << std::endl;
+                    device_ring(device).abandon(&ids[first], posted[device]);
+                    lost = -ret;
+                    continue;
+                }
+                bool collected = posted[device] > 0;
+                for (int i = 0; coherence && is_write && i < posted[device]; i++) {
+                    const IoSegment& piece = pieces[device][next[device] + i];
+                    cxl_cache_invalidate(static_cast<char*>(mapped_region) + piece.offset, piece.length);
+                }
+                if (coherence && is_write) {
+                    cxl_cache_fence(true);
+                }
+                for (int i = 0; i < std::max(posted[device], 1) && next[device] + i < pieces[device].size(); i++) {
+                    if (!collected || cqes[first + i].status != CXL_CMD_STATUS_COMPLETED) {
+                        cpu_transfer(is_write, pieces[device][next[device] + i]);
+                        fallback_bytes.fetch_add(pieces[device][next[device] + i].length, std::memory_order_relaxed);
+                    }
+                }
+                next[device] += std::max(posted[device], 1);
+            }
+        }
+        if (lost) {
+            errno = lost;
+            return false;
+        }
+        return true;
+    }
+
+    // Benchmarks overwrite the scratch extent. A device region keeps it out of the
+    // allocator for good; without a region header it spans the allocator's whole
+    // range, so each run takes it out for its duration and refuses to start over
+    // live allocations (cxl_alloc fails meanwhile)
+    class ScratchClaim {
+    public:
+        explicit ScratchClaim(CXLMemoryManager& owner) : manager(owner), claimed(owner.claim_scratch()) {}
+        ~ScratchClaim() {
+            if (claimed) {
+                manager.release_scratch();
+            }
+        }
+        ScratchClaim(const ScratchClaim&) = delete;
+        ScratchClaim& operator=(const ScratchClaim&) = delete;
+
+        bool held() const { return claimed; }
+
+    private:
+        CXLMemoryManager& manager;
+        bool claimed;
+    };
+
+    bool claim_scratch() {
+        if (directory.attached()) {
+            return true;
+        }
+        std::lock_guard<std::mutex> guard(scratch_lock);
+        if (scratch_claims == 0 && !allocator.reserve(scratch_offset, scratch_bytes)) {
+            std::cerr << "Benchmarks need the whole region, which holds live cxl_alloc allocations" << std::endl;
+            return false;
+        }
+        scratch_claims++;
+        return true;
+    }
+
+    void release_scratch() {
+        if (directory.attached()) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(scratch_lock);
+        if (--scratch_claims == 0) {
+            allocator.release(scratch_offset);
+        }
+    }
+
+    // Bracket a timed loop with the perf counters when they are enabled
+    void perf_begin() {
+        if (perf.active()) {
+            perf.start();
+        }
+    }
+
+    void perf_end() {
+        if (perf.active()) {
+            perf.stop(&perf_last);
+            perf_measured = true;
+        }
+    }
+
+    // Offset of the i-th block when walking the data area in whole blocks; wraps
+    // after the last whole block, so a block as large as the area reuses offset 0
+    size_t block_offset(size_t i, size_t block_size) {
+        return (i % (data_size() / block_size)) * block_size;
+    }
+
+    // Run one block transfer, stretched to the simulation model when one is loaded
+    template <typename Op>
+    void modelled(size_t bytes, Op op) {
+        if (!sim_model.active()) {
+            op();
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        op();
+        sim_model.transfer(bytes, start);
+    }
+
+    // Anonymous mapping, from the hugetlb pool when asked; falls back to transparent
+    // huge pages (2MB only) if the pool cannot cover the request
+    static void* map_anonymous(size_t& size, int flags) {
+        if (!(flags & (CXL_INIT_HUGE_2M | CXL_INIT_HUGE_1G))) {
+            return mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+        
+        const int shift = (flags & CXL_INIT_HUGE_1G) ? 30 : 21;
+        const size_t huge = 1UL << shift;
+        size = (size + huge - 1) & ~(huge - 1);
+        
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+        if (addr != MAP_FAILED) {
+            return addr;
+        }
+        
+        std::cerr << "No " << (huge >> 20) << "MB hugetlb pages available, "
+                  << "falling back to transparent huge pages" << std::endl;
+        addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, size, MADV_HUGEPAGE);
+        }
+        return addr;
+    }
+
+    // Fault in every page of the region writable, without changing its contents
+    void populate() {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(mapped_region, region_size, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#endif
+        const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        volatile char* p = static_cast<volatile char*>(mapped_region);
+        for (size_t offset = 0; offset < region_size; offset += page) {
+            p[offset] = p[offset];
+        }
+    }
+
+    // CPUs this process is allowed to run on, in ascending order
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        return cpus;
+    }
+
+    // Split the region into one slice per thread and run the copy loop on all of them
+    double run_parallel(bool is_write, void* buffer, size_t block_size, int iterations,
+                        const cxl_bw_config* config, cxl_bw_result* result) {
+        if (result) {
+            memset(result, 0, sizeof(*result));
+        }
+        if (!initialized || block_size == 0 || iterations <= 0) {
+            return 0.0;
+        }
+        ScratchClaim claim(*this);
+        if (!claim.held()) {
+            return 0.0;
+        }
+
+        std::vector<int> cpus = allowed_cpus();
+        if (config && config->cpus && config->num_cpus > 0) {
+            cpus.assign(config->cpus, config->cpus + config->num_cpus);
+        }
+        int num_threads = config ? config->num_threads : 0;
+        if (num_threads <= 0) {
+            num_threads = cpus.empty() ? 1 : static_cast<int>(cpus.size());
+        }
+        num_threads = std::min(num_threads, CXL_MAX_BW_THREADS);
+        bool pin = config && config->pin_threads && !cpus.empty();
+
+        // Keep slices cache-line aligned so threads never share a line
+        size_t slice_size = (data_size() / num_threads) & ~static_cast<size_t>(63);
+        if (slice_size < block_size) {
+            std::cerr << "Region too small for " << num_threads
+                      << " threads with block size " << block_size << std::endl;
+            return 0.0;
+        }
+
+        std::vector<BandwidthWorker> workers(num_threads);
+        for (int t = 0; t < num_threads; t++) {
+            workers[t].cpu = pin ? cpus[t % cpus.size()] : -1;
+            workers[t].slice_offset = t * slice_size;
+            workers[t].slice_blocks = slice_size / block_size;
+        }
+
+        pthread_barrier_t barrier;
+        pthread_barrier_init(&barrier, nullptr, num_threads);
+
+        auto worker_main = [&](BandwidthWorker& w) {
+            if (w.cpu >= 0) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(w.cpu, &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+
+            // Private host buffer, first touched after pinning so it is local to the worker
+            void* host = aligned_alloc(64, (block_size + 63) & ~static_cast<size_t>(63));
+            if (host) {
+                if (is_write && buffer) {
+                    memcpy(host, buffer, block_size);
+                } else {
+                    memset(host, 0xA5, block_size);
+                }
+            }
+
+            w.node = cxl_numa_cpu_node(w.cpu >= 0 ? w.cpu : sched_getcpu());
+
+            pthread_barrier_wait(&barrier);
+            w.start = std::chrono::steady_clock::now();
+
+            char* base = data_start() + w.slice_offset;
+            for (int i = 0; host && i < iterations; i++) {
+                char* block = base + (i % w.slice_blocks) * block_size;
+                if (is_write) {
+                    modelled(block_size, [&] { kernel->copy(block, host, block_size); });
+                } else {
+                    modelled(block_size, [&] { memcpy(host, block, block_size); });
+                }
+            }
+
+            w.end = std::chrono::steady_clock::now();
+            if (!host) {
+                w.end = w.start;
+            }
+            free(host);
+        };
+
+        // Counters inherit into the workers, which are started inside the window
+        perf_begin();
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back(worker_main, std::ref(workers[t]));
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        perf_end();
+        pthread_barrier_destroy(&barrier);
+
+        // Aggregate bandwidth covers the window from the first start to the last finish
+        const double bytes_per_thread = static_cast<double>(block_size) * iterations;
+        const double gib = 1024.0 * 1024 * 1024;
+        auto first_start = workers[0].start;
+        auto last_end = workers[0].end;
+        for (int t = 0; t < num_threads; t++) {
+            first_start = std::min(first_start, workers[t].start);
+            last_end = std::max(last_end, workers[t].end);
+
+            std::chrono::duration<double> elapsed = workers[t].end - workers[t].start;
+            if (result) {
+                result->thread_gbps[t] = elapsed.count() > 0 ?
+                    bytes_per_thread / (elapsed.count() * gib) : 0.0;
+                result->thread_cpu[t] = workers[t].cpu;
+                result->thread_node[t] = workers[t].node;
+            }
+        }
+
+        std::chrono::duration<double> window = last_end - first_start;
+        double aggregate = window.count() > 0 ?
+            (bytes_per_thread * num_threads) / (window.count() * gib) : 0.0;
+
+        if (result) {
+            result->aggregate_gbps = aggregate;
+            result->num_threads = num_threads;
+            result->memory_node = get_numa_node();
+        }
+        return aggregate;
+    }
+};
+
+// Run the bandwidth and latency tests against one region from the given CPUs
+static void measure_numa_region(CXLMemoryManager* manager, const cxl_numa_compare_config* config,
+                                const std::vector<int>& cpus, cxl_numa_result* out) {
+    const size_t block_size = config->block_size ? config->block_size : 1UL << 20;
+    const int bw_iterations = config->bw_iterations > 0 ? config->bw_iterations : 1000;
+    const int latency_iterations = config->latency_iterations > 0 ? config->latency_iterations : 1000;
+
+    std::vector<char> buffer(block_size, 0x5A);
+    cxl_bw_config bw = { config->num_threads, 1, cpus.data(), static_cast<int>(cpus.size()) };
+    out->write_gbps = manager->test_write_parallel(buffer.data(), block_size, bw_iterations, &bw, nullptr);
+    out->read_gbps = manager->test_read_parallel(buffer.data(), block_size, bw_iterations, &bw, nullptr);
+
+    // Chase from the node's first CPU, then give the caller its affinity back
+    cpu_set_t saved;
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(cpus[0], &one);
+    bool restore = sched_getaffinity(0, sizeof(saved), &saved) == 0;
+    sched_setaffinity(0, sizeof(one), &one);
+
+    cxl_chase_config chase = { std::min(manager->get_data_size(), 1UL << 30), 64, CXL_PAGES_DEFAULT };
+    cxl_latency_stats stats;
+    out->latency_ns = manager->test_latency_chase(&chase, latency_iterations, &stats);
+    out->latency_p99_ns = stats.p99_ns;
+
+    if (restore) {
+        sched_setaffinity(0, sizeof(saved), &saved);
+    }
+}
+
+// C interface for the CXL Memory Manager
+
+extern "C" {
 
 void* cxl_init(const char* device_path, size_t size) {
     CXLMemoryManager* manager = new CXLMemoryManager();
@@ -313,6 +2652,19 @@ void* cxl_init(const char* device_path, size_t size) {
     return static_cast<void*>(manager);
 }
 
+void* cxl_init_ex(const char* device_path, const cxl_init_options* options) {
+    if (!options) {
+        return nullptr;
+    }
+    CXLMemoryManager* manager = new CXLMemoryManager();
+    if (!manager->initialize(device_path, options->size, options->numa_node, options->flags,
+                             options->interleave_granularity, options->scratch_size)) {
+        delete manager;
+        return nullptr;
+    }
+    return static_cast<void*>(manager);
+}
+
 void cxl_cleanup(void* handle) {
     if (handle) {
         CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
@@ -321,6 +2673,413 @@ void cxl_cleanup(void* handle) {
     }
 }
 
+size_t cxl_get_page_size(void* handle) {
+    if (!handle) return 0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_page_size();
+}
+
+int cxl_get_sim_model(void* handle, double* latency_ns, double* bandwidth_gbps) {
+    if (!handle) return 0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_sim_model(latency_ns, bandwidth_gbps) ? 1 : 0;
+}
+
+int cxl_get_numa_node(void* handle) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_numa_node();
+}
+
+int cxl_numa_get_nodes(int* nodes, int max_nodes) {
+    std::vector<int> online = cxl_numa_online_nodes();
+    int count = std::min(static_cast<int>(online.size()), std::max(max_nodes, 0));
+    if (nodes) {
+        std::copy(online.begin(), online.begin() + count, nodes);
+    }
+    return count;
+}
+
+int cxl_numa_get_node_cpus(int node, int* cpus, int max_cpus) {
+    std::vector<int> node_cpus = cxl_numa_node_cpus(node);
+    int count = std::min(static_cast<int>(node_cpus.size()), std::max(max_cpus, 0));
+    if (cpus) {
+        std::copy(node_cpus.begin(), node_cpus.begin() + count, cpus);
+    }
+    return count;
+}
+
+int cxl_numa_compare(const cxl_numa_compare_config* config, cxl_numa_result* results, int max_results) {
+    if (!config || !results || max_results <= 0) {
+        return -1;
+    }
+    std::vector<int> cpus = cxl_numa_node_cpus(config->cpu_node);
+    if (cpus.empty()) {
+        std::cerr << "NUMA node " << config->cpu_node << " has no CPUs" << std::endl;
+        return -1;
+    }
+
+    cxl_init_options options = { config->size ? config->size : 256UL << 20, -1, CXL_INIT_POPULATE, 0, 0 };
+    int count = 0;
+
+    for (int node : cxl_numa_online_nodes()) {
+        if (count >= max_results) {
+            break;
+        }
+        if (!cxl_numa_node_has_memory(node)) {
+            continue;
+        }
+
+        CXLMemoryManager manager;
+        options.numa_node = node;
+        if (!manager.initialize(nullptr, options.size, options.numa_node, options.flags)) {
+            continue;
+        }
+
+        cxl_numa_result& result = results[count++];
+        result.memory_node = node;
+        result.kind = node == config->cpu_node ? CXL_NODE_DRAM_LOCAL :
+                      cxl_numa_node_is_cpuless(node) ? CXL_NODE_CPULESS : CXL_NODE_DRAM_REMOTE;
+        measure_numa_region(&manager, config, cpus, &result);
+    }
+
+    if (config->device_path && count < max_results) {
+        CXLMemoryManager manager;
+        if (manager.initialize(config->device_path, options.size, -1, CXL_INIT_POPULATE, 0, CXL_SCRATCH_ALL)) {
+            cxl_numa_result& result = results[count++];
+            result.memory_node = manager.get_numa_node();
+            result.kind = CXL_NODE_DEVICE;
+            measure_numa_region(&manager, config, cpus, &result);
+        }
+    }
+    return count;
+}
+
+void* cxl_alloc(void* handle, size_t size, size_t align) {
+    if (!handle) return nullptr;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->alloc(size, align);
+}
+
+void cxl_free(void* handle, void* ptr) {
+    if (!handle || !ptr) return;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    if (!manager->free_block(ptr)) {
+        std::cerr << "cxl_free: " << ptr << " was not allocated from this region" << std::endl;
+    }
+}
+
+void cxl_get_alloc_stats(void* handle, cxl_alloc_stats* stats) {
+    if (!handle || !stats) return;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->get_alloc_stats(stats);
+}
+
+int cxl_get_stats(void* handle, cxl_stats* stats) {
+    if (!handle || !stats) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->get_stats(stats);
+    return 0;
+}
+
+void cxl_reset_stats(void* handle) {
+    if (!handle) return;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->reset_stats();
+}
+
+int cxl_get_interleave(void* handle, size_t* granularity) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_interleave(granularity);
+}
+
+int cxl_get_cache_mode(void* handle) {
+    if (!handle) return CXL_CACHE_WRITE_BACK;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_cache_mode();
+}
+
+int cxl_get_backend(void* handle) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_backend();
+}
+
+void cxl_flush_range(void* handle, const void* addr, size_t length) {
+    if (!addr || !length) return;
+    if (!handle) {
+        cxl_cache_writeback(addr, length);
+        return;
+    }
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->flush_range(addr, length);
+}
+
+void cxl_invalidate_range(void* handle, const void* addr, size_t length) {
+    if (!addr || !length) return;
+    if (!handle) {
+        cxl_cache_invalidate(addr, length);
+        cxl_cache_fence(true);
+        return;
+    }
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->invalidate_range(addr, length);
+}
+
+void cxl_persist_barrier(void* handle) {
+    if (!handle) {
+        cxl_cache_fence(false);
+        return;
+    }
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->persist_barrier();
+}
+
+uint16_t cxl_region_id(void* handle) {
+    if (!handle) return 0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_region_id();
+}
+
+void cxl_get_region_info(void* handle, cxl_region_info* info) {
+    if (!info) return;
+    if (!handle) {
+        memset(info, 0, sizeof(*info));
+        return;
+    }
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->get_region_info(info);
+}
+
+void* cxl_get_scratch(void* handle, size_t* size) {
+    if (!handle) {
+        if (size) *size = 0;
+        return nullptr;
+    }
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_scratch(size);
+}
+
+void* cxl_get_region(void* handle, size_t* size) {
+    if (!handle) {
+        if (size) *size = 0;
+        return nullptr;
+    }
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    if (size) *size = manager->get_size();
+    return manager->get_pointer(0);
+}
+
+cxl_handle_t cxl_ptr_to_handle(void* handle, const void* ptr) {
+    if (!handle || !ptr) return CXL_HANDLE_NULL;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->to_handle(ptr);
+}
+
+void* cxl_handle_to_ptr(void* handle, cxl_handle_t object) {
+    if (!handle || object == CXL_HANDLE_NULL) return nullptr;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->from_handle(object);
+}
+
+cxl_handle_t cxl_object_create(void* handle, const char* name, size_t size) {
+    if (!handle) return CXL_HANDLE_NULL;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->create_object(name, size);
+}
+
+cxl_handle_t cxl_object_open(void* handle, const char* name, size_t* size) {
+    if (!handle) return CXL_HANDLE_NULL;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->open_object(name, size);
+}
+
+int cxl_object_remove(void* handle, const char* name) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->remove_object(name) ? 0 : -1;
+}
+
+// Tiering layer and the region extent its CXL tier lives in
+struct CXLTier {
+    CXLMemoryManager* manager;
+    void* extent;
+    CXLTierManager tiers;
+};
+
+void* cxl_tier_create(void* handle, const cxl_tier_config* config) {
+    if (!handle || !config) return nullptr;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    if (manager->get_fd() < 0) {
+        std::cerr << "Tiering needs a region mapped from a single device" << std::endl;
+        return nullptr;
+    }
+    
+    void* extent = manager->alloc(config->cxl_bytes, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    if (!extent) {
+        std::cerr << "No room in the region for a " << config->cxl_bytes << "-byte CXL tier" << std::endl;
+        return nullptr;
+    }
+    CXLTier* tier = new CXLTier();
+    tier->manager = manager;
+    tier->extent = extent;
+    size_t offset = static_cast<size_t>(static_cast<char*>(extent) - static_cast<char*>(manager->get_pointer(0)));
+    if (!tier->tiers.init(manager->get_fd(), offset, extent, *config)) {
+        manager->free_block(extent);
+        delete tier;
+        return nullptr;
+    }
+    return tier;
+}
+
+void cxl_tier_destroy(void* tier) {
+    if (!tier) return;
+    CXLTier* t = static_cast<CXLTier*>(tier);
+    t->tiers.shutdown();
+    t->manager->free_block(t->extent);
+    delete t;
+}
+
+void* cxl_tier_alloc(void* tier, size_t size, int placement) {
+    if (!tier) return nullptr;
+    return static_cast<CXLTier*>(tier)->tiers.allocate(size, placement);
+}
+
+void cxl_tier_free(void* tier, void* ptr) {
+    if (!tier || !ptr) return;
+    if (!static_cast<CXLTier*>(tier)->tiers.release(ptr)) {
+        std::cerr << "cxl_tier_free: " << ptr << " was not allocated from this tier" << std::endl;
+    }
+}
+
+int cxl_tier_where(void* tier, const void* ptr) {
+    if (!tier) return -1;
+    return static_cast<CXLTier*>(tier)->tiers.where(ptr);
+}
+
+int cxl_tier_migrate(void* tier, const void* ptr, size_t length, int target) {
+    if (!tier) return -1;
+    return static_cast<CXLTier*>(tier)->tiers.migrate_range(ptr, length, target);
+}
+
+int cxl_tier_scan(void* tier) {
+    if (!tier) return -1;
+    return static_cast<CXLTier*>(tier)->tiers.scan();
+}
+
+void cxl_tier_get_stats(void* tier, cxl_tier_stats* stats) {
+    if (!tier || !stats) return;
+    static_cast<CXLTier*>(tier)->tiers.get_stats(stats);
+}
+
+void* cxl_zstore_create(void* handle, const cxl_zstore_config* config) {
+    if (!handle || !config) return nullptr;
+    CXLCompressedStore* store = new CXLCompressedStore();
+    if (!store->init(handle, *config)) {
+        delete store;
+        return nullptr;
+    }
+    return store;
+}
+
+void cxl_zstore_destroy(void* store) {
+    if (!store) return;
+    delete static_cast<CXLCompressedStore*>(store);
+}
+
+uint64_t cxl_zstore_put(void* store, const void* data, size_t size) {
+    if (!store) return 0;
+    return static_cast<CXLCompressedStore*>(store)->put(data, size);
+}
+
+int64_t cxl_zstore_get(void* store, uint64_t key, void* out, size_t capacity) {
+    if (!store) return -1;
+    return static_cast<CXLCompressedStore*>(store)->get(key, out, capacity);
+}
+
+int64_t cxl_zstore_size(void* store, uint64_t key) {
+    if (!store) return -1;
+    return static_cast<CXLCompressedStore*>(store)->size(key);
+}
+
+int cxl_zstore_remove(void* store, uint64_t key) {
+    if (!store) return -1;
+    return static_cast<CXLCompressedStore*>(store)->remove(key) ? 0 : -1;
+}
+
+void cxl_zstore_get_stats(void* store, cxl_zstore_stats* stats) {
+    if (!store || !stats) return;
+    static_cast<CXLCompressedStore*>(store)->get_stats(stats);
+}
+
+int cxl_has_command_ring(void* handle) {
+    if (!handle) return 0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->has_command_ring() ? 1 : 0;
+}
+
+int cxl_submit_commands(void* handle, const cxl_command* cmds, int count) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->submit_commands(cmds, count);
+}
+
+int cxl_reap_completions(void* handle, cxl_completion* out, int max) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->reap_completions(out, max);
+}
+
+int cxl_wait_command(void* handle, uint32_t id, uint32_t timeout_ms, cxl_completion* out) {
+    if (!handle) return -EINVAL;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->wait_command(id, timeout_ms, out);
+}
+
+int cxl_set_iov_engine(void* handle, int engine) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->set_iov_engine(engine) ? 0 : -1;
+}
+
+int64_t cxl_writev(void* handle, const cxl_iovec* iov, int iovcnt) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->transfer_vector(true, iov, iovcnt);
+}
+
+int64_t cxl_readv(void* handle, const cxl_iovec* iov, int iovcnt) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->transfer_vector(false, iov, iovcnt);
+}
+
+int cxl_set_kernel(void* handle, int kernel) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->set_kernel(kernel) ? 0 : -1;
+}
+
+int cxl_get_kernel(void* handle) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_kernel();
+}
+
+int cxl_select_fastest_kernel(void* handle, size_t block_size, int iterations) {
+    if (!handle || block_size == 0) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+
+    void* buffer = aligned_alloc(64, (block_size + 63) & ~static_cast<size_t>(63));
+    if (!buffer) return -1;
+    memset(buffer, 0x5A, block_size);
+
+    int kernel = manager->select_fastest_kernel(buffer, block_size, iterations);
+    free(buffer);
+    return kernel;
+}
+
 double cxl_test_write(void* handle, void* buffer, size_t block_size, int iterations) {
     if (!handle) return 0.0;
     CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
@@ -333,16 +3092,115 @@ double cxl_test_read(void* handle, void* buffer, size_t block_size, int iteratio
     return manager->test_read(buffer, block_size, iterations);
 }
 
+double cxl_test_write_mt(void* handle, void* buffer, size_t block_size, int iterations,
+                         const cxl_bw_config* config, cxl_bw_result* result) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_write_parallel(buffer, block_size, iterations, config, result);
+}
+
+double cxl_test_read_mt(void* handle, void* buffer, size_t block_size, int iterations,
+                        const cxl_bw_config* config, cxl_bw_result* result) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_read_parallel(buffer, block_size, iterations, config, result);
+}
+
 double cxl_test_latency(void* handle, int iterations) {
     if (!handle) return 0.0;
     CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
     return manager->test_latency(iterations);
 }
 
+double cxl_test_latency_hist(void* handle, int iterations, cxl_latency_stats* stats) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_latency_histogram(iterations, stats);
+}
+
+double cxl_test_latency_chase(void* handle, const cxl_chase_config* config, int iterations,
+                              cxl_latency_stats* stats) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_latency_chase(config, iterations, stats);
+}
+
+int cxl_loaded_latency(void* handle, const cxl_loaded_latency_config* config, int iterations,
+                       cxl_loaded_latency_point* points, int max_points) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->loaded_latency(config, iterations, points, max_points);
+}
+
+int cxl_latency_sweep(void* handle, const cxl_chase_config* config, size_t min_working_set,
+                      size_t max_working_set, int iterations, cxl_latency_point* points, int max_points) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->latency_sweep(config, min_working_set, max_working_set, iterations,
+                                  points, max_points);
+}
+
+size_t cxl_latency_json(void* handle, char* buf, size_t len) {
+    if (!handle) return 0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->latency_json(buf, len);
+}
+
+double cxl_test_pattern(void* handle, const cxl_pattern_config* config, int iterations,
+                        cxl_pattern_result* result, cxl_latency_stats* stats) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_pattern(config, iterations, result, stats);
+}
+
+int cxl_pattern_sweep(void* handle, const cxl_pattern_config* config, size_t min_block_size,
+                      size_t max_block_size, size_t bytes_per_point, cxl_pattern_result* points,
+                      int max_points) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->pattern_sweep(config, min_block_size, max_block_size, bytes_per_point,
+                                  points, max_points);
+}
+
+int cxl_perf_enable(void* handle, const char* uncore_events) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->enable_perf(uncore_events);
+}
+
+void cxl_perf_disable(void* handle) {
+    if (!handle) return;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    manager->disable_perf();
+}
+
+int cxl_perf_last(void* handle, cxl_perf_counters* counters) {
+    if (!handle) return -1;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->get_perf(counters);
+}
+
+double cxl_test_compute(void* handle, const cxl_compute_config* config, cxl_compute_result* result) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_compute(config, result);
+}
+
+double cxl_test_queue(void* handle, const cxl_queue_config* config, cxl_queue_result* result) {
+    if (!handle) return 0.0;
+    CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
+    return manager->test_queue(config, result);
+}
+
 double cxl_test_fpga(void* handle, int operation, int iterations) {
+    return cxl_test_fpga_ex(handle, operation, iterations, nullptr);
+}
+
+double cxl_test_fpga_ex(void* handle, int operation, int iterations, cxl_fpga_result* result) {
+    if (result) memset(result, 0, sizeof(*result));
     if (!handle) return 0.0;
     CXLMemoryManager* manager = static_cast<CXLMemoryManager*>(handle);
-    return manager->test_fpga(operation, iterations);
+    return manager->test_fpga(operation, iterations, result);
 }
 
 } // extern "C"
\ No newline at end of file
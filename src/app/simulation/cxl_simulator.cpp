@@ -1,36 +1,159 @@
 #include <iostream>
 #include <fstream>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 
 #define SIM_MEMORY_SIZE (1UL << 30)  // 1GB
+#define SIM_DEVICE_DIR  "/tmp/cxl_sim"
+#define SIM_DEVICE_PATH SIM_DEVICE_DIR "/cxl0"
+#define SIM_MAX_DEVICES 10          // MAX_DEVICES in the driver
+
+static volatile sig_atomic_t running = 1;
+
+// One simulated device: a memory file exposed as SIM_DEVICE_DIR/cxl<n>
+struct SimDevice {
+    std::string path;
+    int fd;
+    void* memory;
+};
+
+static void stop_simulator(int) {
+    running = 0;
+}
+
+// Create the memory file backing the simulated device, from the hugetlb pool
+// when huge_shift is set
+static int create_sim_memory(int huge_shift) {
+    if (huge_shift) {
+        int fd = memfd_create("cxl_sim", MFD_CLOEXEC | MFD_HUGETLB | (huge_shift << MAP_HUGE_SHIFT));
+        if (fd >= 0 && ftruncate(fd, SIM_MEMORY_SIZE) == 0) {
+            return fd;
+        }
+        std::cerr << "No " << ((1UL << huge_shift) >> 20) << "MB hugetlb pages available ("
+                  << strerror(errno) << "), falling back to shmem pages" << std::endl;
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    int fd = memfd_create("cxl_sim", MFD_CLOEXEC);
+    if (fd >= 0 && ftruncate(fd, SIM_MEMORY_SIZE) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+int main(int argc, char** argv) {
+    // --hugepages 2M|1G backs the simulated memory with huge pages;
+    // --latency-ns and --bandwidth-gbps set the model libcxl applies, per device;
+    // --devices N exposes cxl0..cxl<N-1> for striping
+    int huge_shift = 0;
+    int num_devices = 1;
+    double latency_ns = 0.0;
+    double bandwidth_gbps = 0.0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--latency-ns" && i + 1 < argc) {
+            latency_ns = atof(argv[++i]);
+        } else if (arg == "--bandwidth-gbps" && i + 1 < argc) {
+            bandwidth_gbps = atof(argv[++i]);
+        } else if (arg == "--devices" && i + 1 < argc) {
+            num_devices = atoi(argv[++i]);
+            if (num_devices < 1 || num_devices > SIM_MAX_DEVICES) {
+                std::cerr << "Between 1 and " << SIM_MAX_DEVICES << " devices" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--hugepages" && i + 1 < argc) {
+            std::string size = argv[++i];
+            if (size == "2M") {
+                huge_shift = 21;
+            } else if (size == "1G") {
+                huge_shift = 30;
+            } else {
+                std::cerr << "Unsupported huge page size " << size << " (use 2M or 1G)" << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--hugepages 2M|1G] [--latency-ns N] [--bandwidth-gbps X] [--devices N]" << std::endl;
+            return 1;
+        }
+    }
 
-int main() {
     std::cout << "Starting CXL simulator..." << std::endl;
     
-    // Create a memory mapped file to simulate CXL memory
-    void* sim_memory = mmap(NULL, SIM_MEMORY_SIZE, 
-                           PROT_READ | PROT_WRITE, 
-                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    
-    if (sim_memory == MAP_FAILED) {
-        std::cerr << "Failed to allocate simulation memory" << std::endl;
-        return 1;
+    mkdir(SIM_DEVICE_DIR, 0755);
+    std::vector<SimDevice> devices;
+    bool failed = false;
+    for (int n = 0; n < num_devices && !failed; n++) {
+        SimDevice device = { SIM_DEVICE_DIR "/cxl" + std::to_string(n), -1, MAP_FAILED };
+        
+        // Create a shared memory file to simulate CXL memory
+        device.fd = create_sim_memory(huge_shift);
+        if (device.fd >= 0) {
+            device.memory = mmap(NULL, SIM_MEMORY_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, device.fd, 0);
+        }
+        if (device.memory == MAP_FAILED) {
+            std::cerr << "Failed to allocate simulation memory" << std::endl;
+            if (device.fd >= 0) {
+                close(device.fd);
+            }
+            failed = true;
+            break;
+        }
+        
+        // Expose the memory file as the simulated device; opening the link opens the memfd
+        std::string target = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(device.fd);
+        unlink(device.path.c_str());
+        if (symlink(target.c_str(), device.path.c_str()) != 0) {
+            std::cerr << "Failed to create " << device.path << ": " << strerror(errno) << std::endl;
+            munmap(device.memory, SIM_MEMORY_SIZE);
+            close(device.fd);
+            failed = true;
+            break;
+        }
+        
+        // Publish the latency/bandwidth model next to the device
+        std::ofstream model_file(device.path + ".model");
+        model_file << "latency_ns " << latency_ns << "\n"
+                   << "bandwidth_gbps " << bandwidth_gbps << "\n";
+        model_file.close();
+        devices.push_back(device);
     }
     
-    // Create a simulated device file
-    std::ofstream device_file("/tmp/cxl_sim/cxl0");
-    device_file.close();
-    
-    std::cout << "CXL simulator running. Press Ctrl+C to stop." << std::endl;
-    
-    // Keep running until terminated
-    while(true) {
-        sleep(1);
+    if (!failed) {
+        signal(SIGINT, stop_simulator);
+        signal(SIGTERM, stop_simulator);
+        
+        std::cout << "CXL simulator running at " << SIM_DEVICE_PATH;
+        if (num_devices > 1) {
+            std::cout << ".." << num_devices - 1;
+        }
+        std::cout << " (latency +" << latency_ns << " ns, bandwidth "
+                  << (bandwidth_gbps > 0 ? std::to_string(bandwidth_gbps) + " GB/s" : std::string("unthrottled"))
+                  << (num_devices > 1 ? " each" : "") << "). Press Ctrl+C to stop." << std::endl;
+        
+        // Keep running until terminated
+        while (running) {
+            sleep(1);
+        }
     }
     
     // Cleanup
-    munmap(sim_memory, SIM_MEMORY_SIZE);
-    return 0;
-}
\ No newline at end of file
+    for (const SimDevice& device : devices) {
+        unlink(device.path.c_str());
+        unlink((device.path + ".model").c_str());
+        munmap(device.memory, SIM_MEMORY_SIZE);
+        close(device.fd);
+    }
+    return failed ? 1 : 0;
+}
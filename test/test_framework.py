@@ -1,5 +1,13 @@
 # Add these imports at the top
 import os 
+import argparse
+import csv
+import ctypes
+import errno
+import json
+import random
+import subprocess
+import tempfile
 import matplotlib.pyplot as plt
 import numpy as np
 from matplotlib import cm
@@ -12,8 +20,244 @@ sns.set(style="darkgrid")
 custom_cmap = LinearSegmentedColormap.from_list("hermes_blue", 
                                                ["#08306b", "#4292c6", "#c6dbef"], N=256)
 
-def generate_visualizations(results_dir="./results"):
-    """Generate various visualizations for HERMES-CXL performance"""
+def measure_latency_histogram(lib_path="./libcxl.so", device="/tmp/cxl_sim/cxl0",
+                              size=1 << 30, iterations=10000):
+    """Run the TSC-sampled latency test through libcxl.so and return its histogram as a dict"""
+    if not (os.path.exists(lib_path) and os.path.exists(device)):
+        return None
+    
+    lib = ctypes.CDLL(os.path.abspath(lib_path))
+    lib.cxl_init.restype = ctypes.c_void_p
+    lib.cxl_init.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.cxl_cleanup.argtypes = [ctypes.c_void_p]
+    lib.cxl_test_latency_hist.restype = ctypes.c_double
+    lib.cxl_test_latency_hist.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p]
+    lib.cxl_latency_json.restype = ctypes.c_size_t
+    lib.cxl_latency_json.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+    
+    handle = lib.cxl_init(device.encode(), size)
+    if not handle:
+        return None
+    try:
+        lib.cxl_test_latency_hist(handle, iterations, None)
+        length = lib.cxl_latency_json(handle, None, 0)
+        buf = ctypes.create_string_buffer(length + 1)
+        lib.cxl_latency_json(handle, buf, length + 1)
+        return json.loads(buf.value.decode())
+    finally:
+        lib.cxl_cleanup(handle)
+
+class ChaseConfig(ctypes.Structure):
+    _fields_ = [("working_set", ctypes.c_size_t), ("stride", ctypes.c_size_t), ("page_mode", ctypes.c_int)]
+
+class LatencyPoint(ctypes.Structure):
+    _fields_ = [("working_set", ctypes.c_size_t), ("stride", ctypes.c_size_t),
+                ("mean_ns", ctypes.c_double), ("p50_ns", ctypes.c_double), ("p99_ns", ctypes.c_double)]
+
+def measure_latency_sweep(lib_path="./libcxl.so", device="/tmp/cxl_sim/cxl0", size=1 << 30,
+                          strides=(64, 4096), min_ws=16 << 10, max_ws=512 << 20, iterations=1000):
+    """Run cxl_latency_sweep for each stride and return {stride: [(working_set, mean, p50, p99)]}"""
+    if not (os.path.exists(lib_path) and os.path.exists(device)):
+        return None
+    
+    lib = ctypes.CDLL(os.path.abspath(lib_path))
+    lib.cxl_init.restype = ctypes.c_void_p
+    lib.cxl_init.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.cxl_cleanup.argtypes = [ctypes.c_void_p]
+    lib.cxl_latency_sweep.restype = ctypes.c_int
+    lib.cxl_latency_sweep.argtypes = [ctypes.c_void_p, ctypes.POINTER(ChaseConfig), ctypes.c_size_t,
+                                      ctypes.c_size_t, ctypes.c_int, ctypes.POINTER(LatencyPoint), ctypes.c_int]
+    
+    handle = lib.cxl_init(device.encode(), size)
+    if not handle:
+        return None
+    try:
+        curves = {}
+        points = (LatencyPoint * 128)()
+        for stride in strides:
+            config = ChaseConfig(0, stride, 0)
+            n = lib.cxl_latency_sweep(handle, ctypes.byref(config), min_ws, max_ws, iterations, points, 128)
+            curves[stride] = [(p.working_set, p.mean_ns, p.p50_ns, p.p99_ns) for p in points[:max(n, 0)]]
+        return curves
+    finally:
+        lib.cxl_cleanup(handle)
+
+def plot_latency_sweep(curves, results_dir="./results"):
+    """Plot latency against working-set size for each chase stride"""
+    plt.figure(figsize=(12, 7))
+    for stride, points in curves.items():
+        ws = [p[0] / 1024 for p in points]
+        plt.plot(ws, [p[1] for p in points], 'o-', linewidth=2, label=f'{stride} B stride (mean)')
+        plt.plot(ws, [p[3] for p in points], '--', linewidth=1, label=f'{stride} B stride (p99)')
+    
+    plt.xscale('log', base=2)
+    plt.xlabel('Working Set (KB)', fontsize=14)
+    plt.ylabel('Load-to-use latency (ns)', fontsize=14)
+    plt.title('Pointer-Chase Latency vs Footprint', fontsize=16)
+    plt.grid(True, alpha=0.3)
+    plt.legend(fontsize=12)
+    plt.savefig(f"{results_dir}/latency_sweep.png", dpi=300, bbox_inches='tight')
+
+def plot_pattern_sweep(records, results_dir="./results"):
+    """Plot bandwidth against block size for each access pattern, CXL solid and DRAM dashed"""
+    plt.figure(figsize=(12, 7))
+    for target, style in (("cxl", "-"), ("dram", "--")):
+        for pattern in ("sequential", "strided", "random", "gather", "scatter"):
+            points = sorted((r["block_size"], r["gbps"]) for r in records
+                            if r["target"] == target and r["pattern"] == pattern and
+                            r["op"] == ("write" if pattern == "scatter" else "read"))
+            if points:
+                plt.plot([p[0] for p in points], [p[1] for p in points], style, linewidth=2,
+                         label=f"{target.upper()} {pattern}")
+    
+    plt.xscale('log', base=2)
+    plt.xlabel('Block Size (bytes)', fontsize=14)
+    plt.ylabel('Bandwidth (GB/s)', fontsize=14)
+    plt.title('Bandwidth by Access Pattern and Block Size', fontsize=16)
+    plt.grid(True, alpha=0.3)
+    plt.legend(fontsize=10, ncol=2)
+    plt.savefig(f"{results_dir}/pattern_sweep.png", dpi=300, bbox_inches='tight')
+
+def plot_loaded_latency(records, results_dir="./results"):
+    """Plot chase latency against the traffic bandwidth it ran under, one curve per target and traffic mix"""
+    plt.figure(figsize=(12, 7))
+    for target, style in (("cxl", "-"), ("dram", "--")):
+        for op in ("read", "write"):
+            points = sorted((r["gbps"], r["latency_ns"]["mean"]) for r in records
+                            if r["target"] == target and r["op"] == op and r["gbps"] is not None and
+                            r["latency_ns"])
+            if points:
+                plt.plot([p[0] for p in points], [p[1] for p in points], 'o' + style, linewidth=2,
+                         label=f"{target.upper()} {op} traffic")
+    
+    plt.xlabel('Traffic Bandwidth (GB/s)', fontsize=14)
+    plt.ylabel('Load-to-use latency (ns)', fontsize=14)
+    plt.title('Loaded Latency', fontsize=16)
+    plt.grid(True, alpha=0.3)
+    plt.legend(fontsize=12)
+    plt.savefig(f"{results_dir}/loaded_latency.png", dpi=300, bbox_inches='tight')
+
+def plot_latency_histogram(hist, results_dir="./results"):
+    """Plot a histogram exported by cxl_latency_json, marking the reported percentiles"""
+    lows = [b[0] for b in hist["buckets"]]
+    widths = [b[1] - b[0] + 1 for b in hist["buckets"]]
+    counts = [b[2] for b in hist["buckets"]]
+    
+    plt.figure(figsize=(12, 7))
+    plt.bar(lows, counts, width=widths, align='edge', color='#1f77b4')
+    for label, value in hist["percentiles"].items():
+        plt.axvline(value, linestyle='--', linewidth=1, color='#d62728')
+        plt.text(value, max(counts), f"p{label}", rotation=90, va='top')
+    
+    plt.xscale('log')
+    plt.yscale('log')
+    plt.xlabel(f"Load-to-use latency ({hist['unit']})", fontsize=14)
+    plt.ylabel('Samples', fontsize=14)
+    plt.title(f"CXL Latency Distribution ({hist['samples']} samples, mean {hist['mean']:.1f} {hist['unit']})",
+              fontsize=16)
+    plt.savefig(f"{results_dir}/latency_distribution.png", dpi=300, bbox_inches='tight')
+
+class ComputeConfig(ctypes.Structure):
+    _fields_ = [("op", ctypes.c_int), ("isa", ctypes.c_int), ("elements", ctypes.c_size_t),
+                ("iterations", ctypes.c_int), ("tile_bytes", ctypes.c_size_t)]
+
+class ComputeResult(ctypes.Structure):
+    _fields_ = [("isa", ctypes.c_int), ("flops", ctypes.c_double), ("bytes", ctypes.c_double),
+                ("seconds", ctypes.c_double), ("gflops", ctypes.c_double), ("gbps", ctypes.c_double),
+                ("bytes_per_flop", ctypes.c_double), ("checksum", ctypes.c_double)]
+
+COMPUTE_OPS = {'Scale': 0, 'Add': 1, 'Triad': 2, 'Dot': 3, 'Sum': 4}
+
+def measure_compute_throughput(lib_path="./libcxl.so", device="/tmp/cxl_sim/cxl0", size=1 << 30,
+                               ops=('Scale', 'Add', 'Triad'), sizes_mb=(8, 16, 32, 64, 128), iterations=5):
+    """Run cxl_test_compute for each op and per-array size; returns {op: [GB/s per size]}"""
+    if not (os.path.exists(lib_path) and os.path.exists(device)):
+        return None
+    
+    lib = ctypes.CDLL(os.path.abspath(lib_path))
+    lib.cxl_init.restype = ctypes.c_void_p
+    lib.cxl_init.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.cxl_cleanup.argtypes = [ctypes.c_void_p]
+    lib.cxl_test_compute.restype = ctypes.c_double
+    lib.cxl_test_compute.argtypes = [ctypes.c_void_p, ctypes.POINTER(ComputeConfig),
+                                     ctypes.POINTER(ComputeResult)]
+    
+    handle = lib.cxl_init(device.encode(), size)
+    if not handle:
+        return None
+    try:
+        measured = {}
+        for op in ops:
+            rates = []
+            for mb in sizes_mb:
+                config = ComputeConfig(COMPUTE_OPS[op], 0, (mb << 20) // 4, iterations, 0)
+                result = ComputeResult()
+                if lib.cxl_test_compute(handle, ctypes.byref(config), ctypes.byref(result)) <= 0:
+                    return None
+                rates.append(result.gbps)
+            measured[op] = rates
+        return measured
+    finally:
+        lib.cxl_cleanup(handle)
+
+def load_bench_results(path):
+    """Load a cxl_bench JSON or CSV file as {"host": {...}, "records": [...]}"""
+    if path.endswith(".csv"):
+        host = {}
+        rows = []
+        with open(path) as f:
+            for line in f:
+                if line.startswith("#"):
+                    key, _, value = line[1:].partition(":")
+                    host[key.strip()] = value.strip()
+                else:
+                    rows.append(line)
+        records = []
+        for row in csv.DictReader(rows):
+            record = {k: row[k] for k in ("test", "target", "op", "pattern")}
+            for k in ("block_size", "threads", "working_set"):
+                record[k] = int(row[k])
+            record["delay"] = int(row["delay"]) if row.get("delay") else None
+            for k in ("gbps", "gflops"):
+                record[k] = float(row[k]) if row[k] else None
+            lat = {k: float(row[f"lat_{k}_ns"]) for k in ("min", "mean", "p50", "p90", "p99", "p999", "max")
+                   if row[f"lat_{k}_ns"]}
+            record["latency_ns"] = lat or None
+            perf = {k: int(row[f"perf_{k}"]) for k in ("cycles", "instructions", "llc_misses", "dtlb_misses")
+                    if row.get(f"perf_{k}")}
+            uncore = dict(pair.split("=") for pair in row.get("perf_uncore", "").split(";") if pair)
+            if perf or uncore:
+                perf["uncore"] = {name: int(count) for name, count in uncore.items()}
+            record["perf"] = perf or None
+            records.append(record)
+        return {"host": host, "records": records}
+    
+    with open(path) as f:
+        return json.load(f)
+
+def run_bench(bench_path, device, tests="all", output="./results/bench.json"):
+    """Run cxl_bench over the benchmark matrix; returns the output path or None"""
+    if not (os.path.exists(bench_path) and os.path.exists(device)):
+        return None
+    
+    # The binaries find libcxl through a relative rpath, so point the loader at their directory
+    bench_dir = os.path.dirname(os.path.abspath(bench_path))
+    env = dict(os.environ, LD_LIBRARY_PATH=os.pathsep.join(filter(None, [bench_dir,
+                                                                        os.environ.get("LD_LIBRARY_PATH")])))
+    cmd = [os.path.abspath(bench_path), "--device", device, "--test", tests, "--output", output]
+    if subprocess.run(cmd, env=env).returncode != 0:
+        print(f"{bench_path} failed, falling back to synthetic data")
+        return None
+    return output
+
+def select(records, **match):
+    """Records whose fields equal every given value"""
+    return [r for r in records if all(r.get(k) == v for k, v in match.items())]
+
+def generate_visualizations(results_dir="./results", bench=None, lib_path="./libcxl.so",
+                            device="/tmp/cxl_sim/cxl0"):
+    """Generate various visualizations for HERMES-CXL performance, from cxl_bench results where given"""
+    records = bench["records"] if bench else []
     # Ensure results directory exists
     os.makedirs(results_dir, exist_ok=True)
     
@@ -25,6 +269,23 @@ def generate_visualizations(results_dir="./results"):
     cxl_write = [7.4, 13.1, 21.5, 27.2, 31.1, 33.6, 34.1, 34.3, 34.5]  # GB/s
     std_read = [6.1, 11.2, 18.4, 23.1, 25.8, 27.4, 27.9, 28.1, 28.2]   # GB/s
     std_write = [5.6, 10.3, 17.1, 21.5, 24.2, 25.9, 26.3, 26.4, 26.5]  # GB/s
+    source = " (synthetic)"
+    
+    # Measured bandwidth at the highest thread count run, CXL against the DRAM baseline
+    bandwidth = select(records, test="bandwidth")
+    if bandwidth:
+        threads = max(r["threads"] for r in bandwidth)
+        bandwidth = [r for r in bandwidth if r["threads"] == threads]
+        block_sizes = sorted({r["block_size"] for r in bandwidth})
+        
+        def series(target, op):
+            rates = {r["block_size"]: r["gbps"] for r in select(bandwidth, target=target, op=op)}
+            return [rates.get(b, 0.0) for b in block_sizes]
+        
+        cxl_read, cxl_write = series("cxl", "read"), series("cxl", "write")
+        std_read, std_write = series("dram", "read"), series("dram", "write")
+        block_sizes = [b // 1024 for b in block_sizes]
+        source = f" ({threads} threads)"
     
     # 1. Bandwidth comparison chart
     plt.figure(figsize=(12, 7))
@@ -38,7 +299,7 @@ def generate_visualizations(results_dir="./results"):
     
     plt.xlabel('Block Size (KB)', fontsize=14)
     plt.ylabel('Bandwidth (GB/s)', fontsize=14)
-    plt.title('HERMES-CXL vs Standard Memory Performance', fontsize=16)
+    plt.title('HERMES-CXL vs Standard Memory Performance' + source, fontsize=16)
     plt.xticks(x, block_sizes)
     plt.legend(fontsize=12)
     plt.grid(axis='y', alpha=0.3)
@@ -57,11 +318,29 @@ def generate_visualizations(results_dir="./results"):
         [105, 95, 130, 140]  # Scatter
     ])
     
+    source = " (synthetic)"
+    
+    # Measured percentiles: a row per access pattern, then per chase stride; p50/p99 per target
+    latency = select(records, test="latency")
+    if latency:
+        order = ["sequential", "strided", "random", "gather", "scatter"]
+        rows = sorted({(r["op"], r["pattern"], r["block_size"]) for r in latency},
+                      key=lambda k: (k[0] == "chase", order.index(k[1]) if k[1] in order else len(order), k[2]))
+        targets = [t for t in ("cxl", "dram") if select(latency, target=t)]
+        access_patterns = [f"Chase {size}B stride" if op == "chase" else f"{pattern.capitalize()} {size}B"
+                           for op, pattern, size in rows]
+        devices = [f"{t.upper()} {p}" for t in targets for p in ("p50", "p99")]
+        latency_data = np.array([[next((r["latency_ns"][p] for r in select(latency, target=t, op=op, pattern=pattern,
+                                                                         block_size=size)), np.nan)
+                                  for t in targets for p in ("p50", "p99")]
+                                 for op, pattern, size in rows])
+        source = ""
+    
     plt.figure(figsize=(10, 7))
     sns.heatmap(latency_data, annot=True, fmt=".1f", 
                 xticklabels=devices, yticklabels=access_patterns,
                 cmap=custom_cmap, linewidths=0.5)
-    plt.title('Memory Access Latency (ns) by Pattern and Device', fontsize=16)
+    plt.title('Memory Access Latency (ns) by Pattern and Device' + source, fontsize=16)
     plt.tight_layout()
     plt.savefig(f"{results_dir}/latency_heatmap.png", dpi=300, bbox_inches='tight')
     
@@ -69,15 +348,31 @@ def generate_visualizations(results_dir="./results"):
     processes = np.arange(1, 9)
     cxl_scaling = [1.0, 1.92, 2.76, 3.45, 3.95, 4.32, 4.56, 4.72]  # Efficiency scaling
     std_scaling = [1.0, 1.85, 2.55, 3.10, 3.42, 3.65, 3.78, 3.85]  # Efficiency scaling
+    source = " (synthetic)"
+    
+    # Measured read bandwidth at the largest block size, relative to one thread
+    reads = select(records, test="bandwidth", op="read")
+    if reads and len({r["threads"] for r in reads}) > 1:
+        block = max(r["block_size"] for r in reads)
+        processes = np.array(sorted({r["threads"] for r in reads}))
+        
+        def scaling(target):
+            rates = {r["threads"]: r["gbps"] for r in select(reads, target=target, block_size=block)}
+            base = rates.get(processes[0]) or 1.0
+            return [rates.get(t, 0.0) / base for t in processes]
+        
+        cxl_scaling, std_scaling = scaling("cxl"), scaling("dram")
+        source = f" ({block // 1024} KB reads)"
     
     plt.figure(figsize=(10, 6))
     plt.plot(processes, cxl_scaling, 'o-', linewidth=2, markersize=10, label='HERMES-CXL', color='#1f77b4')
     plt.plot(processes, std_scaling, 's-', linewidth=2, markersize=10, label='Standard Memory', color='#ff7f0e')
     plt.plot(processes, processes, '--', linewidth=1, label='Ideal Linear', color='#2ca02c', alpha=0.7)
     
-    plt.xlabel('Number of Concurrent Processes', fontsize=14)
+    plt.xlabel('Number of Concurrent Threads' if source != " (synthetic)" else 'Number of Concurrent Processes',
+               fontsize=14)
     plt.ylabel('Relative Performance', fontsize=14)
-    plt.title('Scaling Efficiency with Concurrent Processes', fontsize=16)
+    plt.title('Scaling Efficiency with Concurrent Processes' + source, fontsize=16)
     plt.grid(True, alpha=0.3)
     plt.legend(fontsize=12)
     plt.savefig(f"{results_dir}/scaling_performance.png", dpi=300, bbox_inches='tight')
@@ -109,6 +404,12 @@ def generate_visualizations(results_dir="./results"):
         [24.3, 25.4, 26.0, 26.4, 26.7]
     ])
     
+    # Replace the compute rows with measured kernel throughput when possible
+    measured = measure_compute_throughput(lib_path, device, sizes_mb=tuple(int(mb) for mb in data_sizes))
+    if measured:
+        for op, rates in measured.items():
+            z[operations.index(op)] = rates
+    
     # Convert to flattened representation for 3D bar
     z = z.T.flatten()
     
@@ -134,7 +435,424 @@ def generate_visualizations(results_dir="./results"):
     plt.tight_layout()
     plt.savefig(f"{results_dir}/operations_performance_3d.png", dpi=300, bbox_inches='tight')
     
+    # Pattern sweeps from cxl_bench
+    patterns = select(records, test="pattern")
+    if patterns:
+        plot_pattern_sweep(patterns, results_dir)
+    
+    loaded = select(records, test="loaded_latency")
+    if loaded:
+        plot_loaded_latency(loaded, results_dir)
+    
+    # 5. Measured latency distribution, when the library and a device are available
+    hist = measure_latency_histogram(lib_path, device)
+    if hist:
+        with open(f"{results_dir}/latency_histogram.json", "w") as f:
+            json.dump(hist, f)
+        plot_latency_histogram(hist, results_dir)
+    
+    curves = measure_latency_sweep(lib_path, device)
+    if curves:
+        plot_latency_sweep(curves, results_dir)
+    
     print(f"Generated visualizations saved to {results_dir}/")
 
-# Call this function at the end of your tests
-generate_visualizations()
\ No newline at end of file
+# Library behaviour checks, run against the simulation build before benchmarking
+
+CXL_INIT_FORMAT = 0x8
+CXL_REGION_HEADER_SIZE = 64 * 1024
+CXL_REGION_BLOCK = 4096         # One superblock copy per block
+
+class InitOptions(ctypes.Structure):
+    _fields_ = [("size", ctypes.c_size_t), ("numa_node", ctypes.c_int), ("flags", ctypes.c_int),
+                ("interleave_granularity", ctypes.c_size_t), ("scratch_size", ctypes.c_size_t)]
+
+class RegionInfo(ctypes.Structure):
+    _fields_ = [("version", ctypes.c_uint32), ("region_id", ctypes.c_uint16), ("objects", ctypes.c_uint32),
+                ("max_objects", ctypes.c_uint32), ("scratch_offset", ctypes.c_uint64),
+                ("scratch_size", ctypes.c_uint64), ("formatted", ctypes.c_int), ("repaired", ctypes.c_uint32)]
+
+class IoVec(ctypes.Structure):
+    _fields_ = [("offset", ctypes.c_size_t), ("buffer", ctypes.c_void_p), ("length", ctypes.c_size_t)]
+
+class AllocStats(ctypes.Structure):
+    _fields_ = [(name, ctypes.c_size_t) for name in ("capacity", "bytes_allocated", "bytes_free",
+                                                     "largest_free_block", "num_allocations", "num_slabs")]
+
+class ZstoreConfig(ctypes.Structure):
+    _fields_ = [("codec", ctypes.c_int), ("min_ratio", ctypes.c_double)]
+
+class ZstoreStats(ctypes.Structure):
+    _fields_ = ([(name, ctypes.c_uint64) for name in ("objects", "compressed_objects", "logical_bytes",
+                                                      "stored_bytes")]
+                + [("capacity_multiplier", ctypes.c_double), ("puts", ctypes.c_uint64), ("gets", ctypes.c_uint64)]
+                + [(name, ctypes.c_double) for name in ("compress_gbps", "decompress_gbps", "get_avg_ns",
+                                                        "get_max_ns", "decompress_avg_ns")])
+
+CXL_CODEC_LZ4 = 1
+
+def load_check_library(lib_path):
+    """Load libcxl with the prototypes the behaviour checks call"""
+    lib = ctypes.CDLL(os.path.abspath(lib_path), use_errno=True)
+    lib.cxl_init_ex.restype = ctypes.c_void_p
+    lib.cxl_init_ex.argtypes = [ctypes.c_char_p, ctypes.POINTER(InitOptions)]
+    lib.cxl_cleanup.argtypes = [ctypes.c_void_p]
+    lib.cxl_alloc.restype = ctypes.c_void_p
+    lib.cxl_alloc.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_size_t]
+    lib.cxl_free.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+    lib.cxl_get_alloc_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(AllocStats)]
+    lib.cxl_get_region_info.argtypes = [ctypes.c_void_p, ctypes.POINTER(RegionInfo)]
+    lib.cxl_region_id.restype = ctypes.c_uint16
+    lib.cxl_region_id.argtypes = [ctypes.c_void_p]
+    lib.cxl_get_scratch.restype = ctypes.c_void_p
+    lib.cxl_get_scratch.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_size_t)]
+    lib.cxl_object_create.restype = ctypes.c_uint64
+    lib.cxl_object_create.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t]
+    lib.cxl_object_open.restype = ctypes.c_uint64
+    lib.cxl_object_open.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(ctypes.c_size_t)]
+    lib.cxl_handle_to_ptr.restype = ctypes.c_void_p
+    lib.cxl_handle_to_ptr.argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+    lib.cxl_test_write.restype = ctypes.c_double
+    lib.cxl_test_write.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_int]
+    lib.cxl_get_region.restype = ctypes.c_void_p
+    lib.cxl_get_region.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_size_t)]
+    lib.cxl_zstore_create.restype = ctypes.c_void_p
+    lib.cxl_zstore_create.argtypes = [ctypes.c_void_p, ctypes.POINTER(ZstoreConfig)]
+    lib.cxl_zstore_destroy.argtypes = [ctypes.c_void_p]
+    lib.cxl_zstore_put.restype = ctypes.c_uint64
+    lib.cxl_zstore_put.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]
+    lib.cxl_zstore_get.restype = ctypes.c_int64
+    lib.cxl_zstore_get.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_void_p, ctypes.c_size_t]
+    lib.cxl_zstore_size.restype = ctypes.c_int64
+    lib.cxl_zstore_size.argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+    lib.cxl_zstore_remove.argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+    lib.cxl_zstore_get_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(ZstoreStats)]
+    for name in ("cxl_writev", "cxl_readv"):
+        getattr(lib, name).restype = ctypes.c_int64
+        getattr(lib, name).argtypes = [ctypes.c_void_p, ctypes.POINTER(IoVec), ctypes.c_int]
+    return lib
+
+def open_region(lib, path=None, size=64 << 20, flags=0):
+    """cxl_init_ex over a device file, or anonymous host memory without a path"""
+    options = InitOptions(size, -1, flags, 0, 0)
+    return lib.cxl_init_ex(path.encode() if path else None, ctypes.byref(options))
+
+def make_device(workdir, name, size=64 << 20):
+    """Blank file standing in for a device, so the checks never touch the one benchmarked"""
+    path = os.path.join(workdir, name)
+    with open(path, "wb") as f:
+        f.truncate(size)
+    return path
+
+def expect(failures, ok, what):
+    if not ok:
+        failures.append(what)
+
+def alloc_stats(lib, handle):
+    stats = AllocStats()
+    lib.cxl_get_alloc_stats(handle, ctypes.byref(stats))
+    return stats
+
+def check_allocator(lib, workdir):
+    """Blocks split on allocation and coalesce back on free; small objects come from slabs"""
+    failures = []
+    handle = open_region(lib)
+    if not handle:
+        return ["cxl_init_ex of host memory failed"]
+    try:
+        empty = alloc_stats(lib, handle)
+        expect(failures, empty.num_allocations == 0 and empty.bytes_free == empty.capacity,
+               "fresh region has allocations")
+        a = lib.cxl_alloc(handle, 1 << 20, 0)
+        b = lib.cxl_alloc(handle, 1 << 20, 0)
+        expect(failures, a and b and abs(a - b) >= 1 << 20, "1MB blocks missing or overlapping")
+        split = alloc_stats(lib, handle)
+        expect(failures, split.num_allocations == 2 and split.bytes_allocated >= 2 << 20
+               and split.largest_free_block < empty.largest_free_block, "large blocks did not split")
+        lib.cxl_free(handle, a)
+        lib.cxl_free(handle, b)
+        merged = alloc_stats(lib, handle)
+        expect(failures, merged.num_allocations == 0 and merged.bytes_free == empty.capacity
+               and merged.largest_free_block == empty.largest_free_block, "freed blocks did not coalesce")
+        whole = lib.cxl_alloc(handle, empty.largest_free_block, 0)
+        expect(failures, whole, "largest free block cannot be allocated after coalescing")
+        if whole:
+            lib.cxl_free(handle, whole)
+        
+        aligned = lib.cxl_alloc(handle, 100, 4096)
+        expect(failures, aligned and aligned % 4096 == 0, "4KB-aligned allocation misaligned")
+        small = [lib.cxl_alloc(handle, 24, 0) for _ in range(100)]
+        expect(failures, all(small) and len(set(small)) == len(small), "small allocations failed or repeated")
+        expect(failures, alloc_stats(lib, handle).num_slabs > 0, "small allocations did not use slabs")
+        for p in small + [aligned]:
+            lib.cxl_free(handle, p)
+        expect(failures, alloc_stats(lib, handle).num_allocations == 0, "allocations left after freeing all")
+        expect(failures, not lib.cxl_alloc(handle, empty.capacity + 1, 0), "allocation past capacity succeeded")
+    finally:
+        lib.cxl_cleanup(handle)
+    return failures
+
+def transfer(lib, handle, is_write, ranges):
+    """cxl_writev or cxl_readv over (offset, buffer) pairs; returns the call's result and errno"""
+    iov = (IoVec * len(ranges))(*[IoVec(offset, ctypes.addressof(buf), len(buf)) for offset, buf in ranges])
+    ctypes.set_errno(0)
+    ret = (lib.cxl_writev if is_write else lib.cxl_readv)(handle, iov, len(ranges))
+    return ret, ctypes.get_errno()
+
+def check_vectored_io(lib, workdir):
+    """readv/writev merge unsorted adjacent ranges, keep submission order on overlap and stay out of the header"""
+    failures = []
+    handle = open_region(lib, make_device(workdir, "iov"))
+    if not handle:
+        return ["cxl_init_ex of a device file failed"]
+    try:
+        base = 1 << 20
+        parts = [ctypes.create_string_buffer(bytes([c]) * 4096, 4096) for c in b"ABC"]
+        ret, _ = transfer(lib, handle, True, [(base + 8192, parts[2]), (base, parts[0]), (base + 4096, parts[1])])
+        expect(failures, ret == 3 * 4096, f"unsorted adjacent writev returned {ret}")
+        whole = ctypes.create_string_buffer(3 * 4096)
+        ret, _ = transfer(lib, handle, False, [(base, whole)])
+        expect(failures, ret == 3 * 4096 and whole.raw == b"A" * 4096 + b"B" * 4096 + b"C" * 4096,
+               "adjacent writev ranges landed out of place")
+        
+        # Overlapping writes land in submission order, whichever way round they are listed
+        wide = ctypes.create_string_buffer(b"x" * 4096, 4096)
+        narrow = ctypes.create_string_buffer(b"y" * 1024, 1024)
+        transfer(lib, handle, True, [(base, wide), (base + 1024, narrow)])
+        ret, _ = transfer(lib, handle, False, [(base, whole)])
+        expect(failures, whole.raw[:4096] == b"x" * 1024 + b"y" * 1024 + b"x" * 2048,
+               "later overlapping write did not win")
+        transfer(lib, handle, True, [(base + 1024, narrow), (base, wide)])
+        transfer(lib, handle, False, [(base, whole)])
+        expect(failures, whole.raw[:4096] == b"x" * 4096, "earlier overlapping write won")
+        
+        # Split reads of one range, overlapping included
+        halves = [ctypes.create_string_buffer(6144) for _ in range(2)]
+        ret, _ = transfer(lib, handle, False, [(base + 6144, halves[1]), (base, halves[0])])
+        expect(failures, ret == 12288 and halves[0].raw + halves[1].raw == whole.raw, "split readv mismatch")
+        ret, _ = transfer(lib, handle, False, [(base, halves[0]), (base + 2048, halves[1])])
+        expect(failures, ret == 12288 and halves[1].raw == whole.raw[2048:2048 + 6144], "overlapping readv mismatch")
+        
+        # A bad range fails the whole call before anything moves
+        header = ctypes.create_string_buffer(b"z" * 64, 64)
+        ret, err = transfer(lib, handle, True, [(base, header), (0, header)])
+        expect(failures, ret == -1 and err == errno.EINVAL, "writev into the region header accepted")
+        ret, err = transfer(lib, handle, False, [(4096, header)])
+        expect(failures, ret == -1 and err == errno.EINVAL, "readv from the region header accepted")
+        ret, err = transfer(lib, handle, True, [((64 << 20) - 1024, wide)])
+        expect(failures, ret == -1 and err == errno.EINVAL, "writev past the region end accepted")
+        transfer(lib, handle, False, [(base, whole)])
+        expect(failures, whole.raw[:4096] == b"x" * 4096, "rejected writev changed the region")
+        ret, _ = transfer(lib, handle, True, [])
+        expect(failures, ret == 0, "empty writev did not return 0")
+    finally:
+        lib.cxl_cleanup(handle)
+    return failures
+
+def region_info(lib, handle):
+    info = RegionInfo()
+    lib.cxl_get_region_info(handle, ctypes.byref(info))
+    return info
+
+def damage(path, offset, length=16):
+    with open(path, "r+b") as f:
+        f.seek(offset)
+        f.write(b"\xee" * length)
+
+def check_region_layout(lib, workdir):
+    """Region headers persist objects, repair one damaged superblock copy and refuse two"""
+    failures = []
+    size = 64 << 20
+    path = make_device(workdir, "region", size)
+    handle = open_region(lib, path, size)
+    if not handle:
+        return ["cxl_init_ex of a blank device file failed"]
+    info = region_info(lib, handle)
+    expect(failures, info.version == 2 and info.formatted and info.objects == 0 and info.repaired == 0,
+           "blank device was not formatted")
+    expect(failures, info.scratch_offset == CXL_REGION_HEADER_SIZE
+           and info.scratch_size == (size - CXL_REGION_HEADER_SIZE) // 2, "default scratch extent misplaced")
+    region_id = lib.cxl_region_id(handle)
+    obj = lib.cxl_object_create(handle, b"alpha", 1 << 20)
+    expect(failures, obj and not lib.cxl_object_create(handle, b"alpha", 4096), "object create or name clash")
+    offset = obj & ((1 << 48) - 1)
+    expect(failures, offset >= info.scratch_offset + info.scratch_size or offset + (1 << 20) <= info.scratch_offset,
+           "object overlaps the scratch extent")
+    if obj:
+        ctypes.memmove(lib.cxl_handle_to_ptr(handle, obj), b"persisted", 10)
+    buf = ctypes.create_string_buffer(1 << 20)
+    expect(failures, lib.cxl_test_write(handle, buf, len(buf), 4) > 0, "benchmark refused on a device region")
+    lib.cxl_cleanup(handle)
+    
+    def reattach(what):
+        handle = open_region(lib, path, size)
+        if not handle:
+            failures.append(f"{what}: reattach failed")
+            return None
+        info = region_info(lib, handle)
+        length = ctypes.c_size_t()
+        obj = lib.cxl_object_open(handle, b"alpha", ctypes.byref(length))
+        data = ctypes.string_at(lib.cxl_handle_to_ptr(handle, obj), 10) if obj else b""
+        expect(failures, not info.formatted and info.objects == 1 and lib.cxl_region_id(handle) == region_id
+               and length.value == 1 << 20 and data == b"persisted\0", f"{what}: object lost")
+        lib.cxl_cleanup(handle)
+        return info
+    
+    info = reattach("restart")
+    expect(failures, info and info.repaired == 0, "clean restart reported repairs")
+    damage(path, 40)
+    info = reattach("damaged copy 0")
+    expect(failures, info and info.repaired == 1, "damaged superblock copy not repaired")
+    info = reattach("after repair")
+    expect(failures, info and info.repaired == 0, "repair did not stick")
+    
+    # Both copies damaged: refused rather than formatted over, until asked to format
+    damage(path, 40)
+    damage(path, CXL_REGION_BLOCK + 40)
+    handle = open_region(lib, path, size)
+    expect(failures, not handle, "damaged header accepted")
+    if handle:
+        lib.cxl_cleanup(handle)
+    handle = open_region(lib, path, size, CXL_INIT_FORMAT)
+    if not handle:
+        return failures + ["CXL_INIT_FORMAT failed"]
+    info = region_info(lib, handle)
+    expect(failures, info.formatted and info.objects == 0 and not lib.cxl_object_open(handle, b"alpha", None),
+           "CXL_INIT_FORMAT kept the old layout")
+    lib.cxl_cleanup(handle)
+    return failures
+
+def check_scratch_claim(lib, workdir):
+    """Without a header, benchmarks and cxl_alloc allocations never share the region"""
+    failures = []
+    handle = open_region(lib)
+    if not handle:
+        return ["cxl_init_ex of host memory failed"]
+    try:
+        info = region_info(lib, handle)
+        scratch_size = ctypes.c_size_t()
+        lib.cxl_get_scratch(handle, ctypes.byref(scratch_size))
+        expect(failures, info.version == 0 and info.scratch_offset == 0 and scratch_size.value == 64 << 20,
+               "host memory scratch is not the whole region")
+        buf = ctypes.create_string_buffer(1 << 20)
+        expect(failures, lib.cxl_test_write(handle, buf, len(buf), 4) > 0, "benchmark refused with no allocations")
+        p = lib.cxl_alloc(handle, 4096, 0)
+        expect(failures, p, "allocation failed after a benchmark")
+        if p:
+            ctypes.memset(p, 0x5A, 4096)
+            expect(failures, lib.cxl_test_write(handle, buf, len(buf), 4) == 0,
+                   "benchmark ran over a live allocation")
+            expect(failures, ctypes.string_at(p, 4096) == b"\x5a" * 4096, "benchmark overwrote an allocation")
+            lib.cxl_free(handle, p)
+        expect(failures, lib.cxl_test_write(handle, buf, len(buf), 4) > 0, "benchmark refused after the free")
+    finally:
+        lib.cxl_cleanup(handle)
+    return failures
+
+def check_zstore(lib, workdir):
+    """LZ4 objects round-trip, incompressible ones are stored as is and a corrupt block is rejected"""
+    failures = []
+    handle = open_region(lib, make_device(workdir, "zstore"))
+    if not handle:
+        return ["cxl_init_ex of a device file failed"]
+    try:
+        expect(failures, not lib.cxl_zstore_create(handle, ctypes.byref(ZstoreConfig(9, 0))), "unknown codec accepted")
+        baseline = alloc_stats(lib, handle).num_allocations     # The scratch extent is reserved
+        store = lib.cxl_zstore_create(handle, ctypes.byref(ZstoreConfig(CXL_CODEC_LZ4, 0)))
+        if not store:
+            return failures + ["cxl_zstore_create failed"]
+        
+        # The marker opens the first literal run of the compressed block, so it can be found in the region
+        marker = b"HERMES-ZSTORE-CHECK:"
+        text = marker + b"".join(f"record {i} of the quick brown fox\n".encode() for i in range(30000))
+        noise = random.Random(7).randbytes(1 << 20)
+        keys = [lib.cxl_zstore_put(store, data, len(data)) for data in (text, noise, b"")]
+        expect(failures, all(keys) and len(set(keys)) == 3, "put failed or reused a key")
+        stats = ZstoreStats()
+        lib.cxl_zstore_get_stats(store, ctypes.byref(stats))
+        expect(failures, stats.objects == 3 and stats.compressed_objects == 1
+               and stats.logical_bytes == len(text) + len(noise) and stats.capacity_multiplier > 1.3,
+               "text was not compressed or noise was")
+        
+        out = ctypes.create_string_buffer(len(text) + len(noise))
+        for key, data in zip(keys, (text, noise, b"")):
+            n = lib.cxl_zstore_get(store, key, out, len(out))
+            expect(failures, n == len(data) and out.raw[:n] == data, f"object of {len(data)} bytes did not round-trip")
+            expect(failures, lib.cxl_zstore_size(store, key) == len(data), "cxl_zstore_size mismatch")
+        expect(failures, lib.cxl_zstore_get(store, keys[0], out, len(text) - 1) == -1, "get past capacity succeeded")
+        expect(failures, lib.cxl_zstore_get(store, 999, out, len(out)) == -1, "get of an unknown key succeeded")
+        
+        # Zeroing the block after its first literals leaves a match offset of 0, which must be rejected
+        region_size = ctypes.c_size_t()
+        region = lib.cxl_get_region(handle, ctypes.byref(region_size))
+        at = ctypes.string_at(region, region_size.value).find(marker)
+        expect(failures, at > 0 and stats.stored_bytes - len(noise) > 8192, "compressed block not found in the region")
+        if at > 0:
+            ctypes.memset(region + at + len(marker), 0, 4096)
+            expect(failures, lib.cxl_zstore_get(store, keys[0], out, len(out)) == -1, "corrupt block decompressed")
+            n = lib.cxl_zstore_get(store, keys[1], out, len(out))
+            expect(failures, n == len(noise) and out.raw[:n] == noise, "corruption spread to another object")
+        
+        expect(failures, lib.cxl_zstore_remove(store, keys[0]) == 0 and lib.cxl_zstore_remove(store, keys[0]) == -1,
+               "remove did not drop the key once")
+        lib.cxl_zstore_destroy(store)
+        expect(failures, alloc_stats(lib, handle).num_allocations == baseline, "objects outlived the store")
+    finally:
+        lib.cxl_cleanup(handle)
+    return failures
+
+LIBRARY_CHECKS = [check_allocator, check_vectored_io, check_region_layout, check_scratch_claim, check_zstore]
+
+def run_library_checks(lib_path):
+    """Run every behaviour check against lib_path; returns failure messages, or None without the library"""
+    if not os.path.exists(lib_path):
+        return None
+    
+    lib = load_check_library(lib_path)
+    failures = []
+    with tempfile.TemporaryDirectory(prefix="cxl_check_") as workdir:
+        for check in LIBRARY_CHECKS:
+            found = check(lib, workdir)
+            print(f"{check.__name__}: {'FAILED' if found else 'ok'}")
+            failures += [f"{check.__name__}: {what}" for what in found]
+    return failures
+
+def main():
+    parser = argparse.ArgumentParser(description="HERMES-CXL performance evaluation")
+    parser.add_argument("--simulation", action="store_true",
+                        help="use the simulation builds in ../build instead of the hardware builds")
+    parser.add_argument("--device", default="/tmp/cxl_sim/cxl0", help="CXL device to benchmark")
+    parser.add_argument("--test", default="all", choices=["all", "bandwidth", "pattern", "latency", "loaded", "compute"],
+                        help="benchmarks cxl_bench runs")
+    parser.add_argument("--results", help="plot an existing cxl_bench JSON/CSV file instead of running it")
+    parser.add_argument("--bench", help="cxl_bench binary (default depends on --simulation)")
+    parser.add_argument("--results-dir", default="./results", help="where plots and results are written")
+    parser.add_argument("--no-checks", action="store_true",
+                        help="skip the library behaviour checks run before simulation benchmarks")
+    args = parser.parse_args()
+    
+    build = "../build" if args.simulation else ".."
+    bench_path = args.bench or os.path.join(build, "cxl_bench_sim" if args.simulation else "cxl_bench")
+    lib_path = os.path.join(build, "libcxl_sim.so" if args.simulation else "libcxl.so")
+    os.makedirs(args.results_dir, exist_ok=True)
+    
+    if args.simulation and not args.no_checks:
+        failures = run_library_checks(lib_path)
+        if failures is None:
+            print(f"{lib_path} not found, skipping library checks")
+        elif failures:
+            print("\n".join(failures))
+            raise SystemExit(1)
+    
+    results = args.results or run_bench(bench_path, args.device, args.test,
+                                        os.path.join(args.results_dir, "bench.json"))
+    bench = load_bench_results(results) if results else None
+    if bench:
+        host = bench.get("host", {})
+        print(f"Loaded {len(bench['records'])} records from {results} "
+              f"({host.get('hostname', '?')}, {host.get('build', '?')} build)")
+    
+    generate_visualizations(args.results_dir, bench, lib_path, args.device)
+
+if __name__ == "__main__":
+    main()